@@ -0,0 +1,260 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+
+#include "affinity.h"
+
+// libnuma 없이 set_mempolicy 시스템 호출로 노드 선호 지정 (linux/mempolicy.h 의 값)
+#define MPOL_PREFERRED 1
+
+static int enabled = 0;
+static cpu_set_t allowed;
+static int cpus[CPU_SETSIZE]; // 집합의 CPU 번호 (돌아가며 배치할 순서)
+static int cpu_cnt = 0;
+static int cpu_node[CPU_SETSIZE]; // CPU -> NUMA 노드 (노드 정보가 없으면 0)
+
+// 집합 밖에서 처리된 연결을 배치할 다음 순서
+static pthread_mutex_t rr_lock = PTHREAD_MUTEX_INITIALIZER;
+static int rr_next = 0;
+
+// "0-3,8,10-11" 형식의 CPU 목록을 set에 추가 (추가한 CPU 수)
+static int parse_cpulist(const char *s, cpu_set_t *set)
+{
+    int added = 0;
+    while (*s)
+    {
+        char *end;
+        long a = strtol(s, &end, 10), b = a;
+        if (end == s)
+            break;
+        if (*end == '-')
+            b = strtol(end + 1, &end, 10);
+        for (long c = a; c <= b && c >= 0 && c < CPU_SETSIZE; c++)
+        {
+            CPU_SET(c, set);
+            added++;
+        }
+        s = *end == ',' ? end + 1 : end;
+        if (*s == '\n')
+            break;
+    }
+    return added;
+}
+
+// sysfs/proc 한 줄짜리 파일 읽기 (성공 0, 실패 -1)
+static int read_line_file(const char *path, char *buf, int size)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    char *r = fgets(buf, size, fp);
+    fclose(fp);
+    return r ? 0 : -1;
+}
+
+// CPU별 NUMA 노드 (/sys/devices/system/node/node<n>/cpulist)
+static void load_nodes(void)
+{
+    char path[64], buf[4096];
+    for (int n = 0; n < 64; n++)
+    {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", n);
+        if (read_line_file(path, buf, sizeof(buf)) < 0)
+            continue;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        parse_cpulist(buf, &set);
+        for (int c = 0; c < CPU_SETSIZE; c++)
+            if (CPU_ISSET(c, &set))
+                cpu_node[c] = n;
+    }
+}
+
+// 인터럽트 이름이 NIC 것인지 - 인터페이스 이름이나 장치 이름(virtio3, PCI 주소) 뒤에 숫자가 이어지지 않음
+static int irq_matches(const char *name, const char *iface, const char *dev)
+{
+    const char *keys[2] = {iface, dev};
+    for (int i = 0; i < 2; i++)
+    {
+        if (!keys[i][0])
+            continue;
+        const char *p = strstr(name, keys[i]);
+        if (p && !(p[strlen(keys[i])] >= '0' && p[strlen(keys[i])] <= '9'))
+            return 1;
+    }
+    return 0;
+}
+
+// 수신 큐 인터럽트인지 (드라이버마다 이름이 다름: eth0-rx-0, eth0-TxRx-0, virtio3-input.0, mlx5_comp0)
+static int irq_is_rx(const char *name)
+{
+    return strstr(name, "rx") || strstr(name, "Rx") || strstr(name, "RX") ||
+           strstr(name, "input") || strstr(name, "comp");
+}
+
+// NIC 수신 큐 인터럽트를 처리하는 CPU 집합 (/proc/interrupts -> /proc/irq/<n>/effective_affinity_list)
+// 수신 큐로 보이는 인터럽트가 없으면 NIC의 모든 인터럽트, 그것도 없으면 NIC가 붙은 노드의 CPU
+static int irq_cpus(const char *iface, cpu_set_t *set)
+{
+    // 장치 이름 (/sys/class/net/<iface>/device 가 가리키는 디렉토리 이름)
+    char path[PATH_MAX], link[PATH_MAX], dev[PATH_MAX] = "";
+    snprintf(path, sizeof(path), "/sys/class/net/%s/device", iface);
+    ssize_t n = readlink(path, link, sizeof(link) - 1);
+    if (n > 0)
+    {
+        link[n] = '\0';
+        const char *base = strrchr(link, '/');
+        snprintf(dev, sizeof(dev), "%s", base ? base + 1 : link);
+    }
+
+    FILE *fp = fopen("/proc/interrupts", "r");
+    if (!fp)
+        return -1;
+
+    cpu_set_t rx, any;
+    CPU_ZERO(&rx);
+    CPU_ZERO(&any);
+    int rx_cnt = 0, any_cnt = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), fp))
+    {
+        // " 43:   8026   PCI-MSIX-0000:00:05.0   1-edge   virtio4-rx" - 번호와 마지막 필드(이름)
+        int irq;
+        if (sscanf(line, " %d:", &irq) != 1)
+            continue;
+        line[strcspn(line, "\n")] = '\0';
+        const char *name = strrchr(line, ' ');
+        name = name ? name + 1 : line;
+        if (!irq_matches(name, iface, dev))
+            continue;
+
+        char buf[4096];
+        snprintf(path, sizeof(path), "/proc/irq/%d/effective_affinity_list", irq);
+        if (read_line_file(path, buf, sizeof(buf)) < 0)
+        {
+            snprintf(path, sizeof(path), "/proc/irq/%d/smp_affinity_list", irq);
+            if (read_line_file(path, buf, sizeof(buf)) < 0)
+                continue;
+        }
+        if (irq_is_rx(name))
+            rx_cnt += parse_cpulist(buf, &rx);
+        any_cnt += parse_cpulist(buf, &any);
+    }
+    fclose(fp);
+
+    if (rx_cnt > 0 || any_cnt > 0)
+    {
+        *set = rx_cnt > 0 ? rx : any;
+        return 0;
+    }
+
+    // 인터럽트를 찾지 못하면 NIC 노드 (가상 장치는 부모 PCI 장치에 있음)
+    char buf[64];
+    snprintf(path, sizeof(path), "/sys/class/net/%s/device/numa_node", iface);
+    if (read_line_file(path, buf, sizeof(buf)) < 0)
+    {
+        snprintf(path, sizeof(path), "/sys/class/net/%s/device/../numa_node", iface);
+        if (read_line_file(path, buf, sizeof(buf)) < 0)
+            return -1;
+    }
+    int node = atoi(buf);
+    if (node < 0)
+        node = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    char list[4096];
+    if (read_line_file(path, list, sizeof(list)) < 0)
+        return -1;
+    return parse_cpulist(list, set) > 0 ? 0 : -1;
+}
+
+// CPU 집합 설정 - 이 프로세스가 쓸 수 있는 CPU만 남김
+int affinity_open(const char *spec)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (strncmp(spec, "irq:", 4) == 0)
+    {
+        if (irq_cpus(spec + 4, &set) < 0)
+            return -1;
+    }
+    else if (strncmp(spec, "node:", 5) == 0)
+    {
+        char path[64], list[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", atoi(spec + 5));
+        if (read_line_file(path, list, sizeof(list)) < 0)
+            return -1;
+        parse_cpulist(list, &set);
+    }
+    else if (parse_cpulist(spec, &set) == 0)
+        return -1;
+
+    cpu_set_t usable;
+    if (sched_getaffinity(0, sizeof(usable), &usable) == 0)
+        CPU_AND(&set, &set, &usable);
+
+    load_nodes();
+    CPU_ZERO(&allowed);
+    cpu_cnt = 0;
+    for (int c = 0; c < CPU_SETSIZE; c++)
+        if (CPU_ISSET(c, &set))
+        {
+            CPU_SET(c, &allowed);
+            cpus[cpu_cnt++] = c;
+        }
+    if (cpu_cnt == 0)
+        return -1;
+    enabled = 1;
+
+    printf("[AFFIN] %s -> CPU", spec);
+    for (int i = 0; i < cpu_cnt; i++)
+        printf("%s%d(node %d)", i ? "," : " ", cpus[i], cpu_node[cpus[i]]);
+    printf("\n");
+    return 0;
+}
+
+// 이 스레드의 새 메모리를 node에서 먼저 할당 (모자라면 다른 노드)
+static void prefer_node(int node)
+{
+    unsigned long mask = 1UL << (node % (8 * sizeof(unsigned long)));
+    syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, 8 * sizeof(mask));
+}
+
+// 수신 CPU가 집합에 있으면 그 CPU, 아니면 돌아가며 고른 CPU에 고정
+int affinity_pin_session(int sd)
+{
+    if (!enabled)
+        return -1;
+
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(sd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0 ||
+        cpu < 0 || cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))
+    {
+        pthread_mutex_lock(&rr_lock);
+        cpu = cpus[rr_next++ % cpu_cnt];
+        pthread_mutex_unlock(&rr_lock);
+    }
+
+    cpu_set_t one;
+    CPU_ZERO(&one);
+    CPU_SET(cpu, &one);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(one), &one) != 0)
+        return -1;
+    prefer_node(cpu_node[cpu]);
+    return cpu;
+}
+
+// 집합 전체에 고정하고 첫 CPU의 노드를 선호
+void affinity_pin_worker(void)
+{
+    if (!enabled)
+        return;
+    pthread_setaffinity_np(pthread_self(), sizeof(allowed), &allowed);
+    prefer_node(cpu_node[cpus[0]]);
+}
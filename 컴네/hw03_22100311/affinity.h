@@ -0,0 +1,22 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+// 서버 스레드 CPU 고정과 NUMA 노드 배치 (-A)
+// 연결 세션 스레드는 그 소켓의 수신 패킷을 처리한 CPU(SO_INCOMING_CPU)에 고정해서
+// NIC 수신 큐 인터럽트, 소켓 버퍼, 세션 버퍼, 파일 쓰기가 같은 CPU/노드에서 일어나게 함
+// 고정한 스레드의 새 메모리(세션 버퍼, 페이지 캐시)는 그 CPU의 노드에서 먼저 할당 (MPOL_PREFERRED)
+//   spec: "irq:<iface>"  /proc/interrupts 에서 NIC 수신 큐 인터럽트를 찾아 /proc/irq/<n>/ 의 CPU 목록 사용
+//         "node:<n>"     /sys/devices/system/node/node<n>/cpulist
+//         "<CPU 목록>"    예: 0-3,8
+// 집합 밖의 CPU에서 처리된 연결이나 유닉스 소켓 연결은 집합의 CPU에 돌아가며 배치
+
+// CPU 집합 설정 (성공 0, 실패 -1)
+int affinity_open(const char *spec);
+
+// 연결 세션 스레드를 그 소켓의 수신 CPU에 고정 (고정한 CPU, 사용하지 않으면 -1)
+int affinity_pin_session(int sd);
+
+// 후처리 작업 스레드를 CPU 집합 전체에 고정 (사용하지 않으면 아무것도 안 함)
+void affinity_pin_worker(void);
+
+#endif
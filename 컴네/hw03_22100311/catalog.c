@@ -0,0 +1,953 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "netio.h"
+#include "journal.h"
+#include "pack.h"
+#include "ecstore.h"
+#include "tier.h"
+#include "dedup.h"
+#include "catalog.h"
+
+#define BASE_MAGIC 0x47544143U // "CATG"
+#define LOG_MAGIC 0x4c544143U  // "CATL"
+
+// 키 "<client_id>/<filename>" 최대 길이
+#define KEY_MAX 330
+
+#define BASE_PATH CATALOG_DIR "/base"
+#define BASE_TMP CATALOG_DIR "/base.tmp"
+#define LOG_PATH CATALOG_DIR "/log"
+#define LOG_TMP CATALOG_DIR "/log.tmp"
+
+// base 파일 헤더 (뒤에 count개의 항목, heap_len 바이트 키 모음)
+typedef struct
+{
+    uint32_t magic;
+    uint32_t crc; // 항목 + 키 모음의 CRC32
+    uint64_t count;
+    uint64_t heap_len;
+} BaseHeader;
+
+// 항목 하나 (64 bytes, base와 log 공용)
+typedef struct
+{
+    uint64_t key_off; // 키 모음 안의 위치 (log에서는 0)
+    uint32_t key_len;
+    uint16_t state;
+    uint16_t hashed; // sha256을 알고 있으면 1
+    int64_t size;
+    int64_t mtime_ns;
+    uint8_t sha256[32];
+} CatalogEntry;
+
+// log 레코드 (뒤에 key_len 바이트 키)
+typedef struct
+{
+    uint32_t magic;
+    uint32_t crc; // 항목 + 키의 CRC32 (찢어진 레코드 검출)
+    CatalogEntry e;
+} LogRecord;
+
+// 메모리의 바뀐 항목 (같은 키가 여러 번 있으면 seq가 큰 것이 최신)
+typedef struct
+{
+    char *key;
+    uint64_t seq;
+    CatalogEntry e;
+} DeltaEntry;
+
+// 매핑한 base
+typedef struct
+{
+    void *map;
+    size_t len;
+    const CatalogEntry *ent;
+    const char *heap;
+    uint64_t count;
+} Base;
+
+// 조회는 읽기 잠금, 기록/교체는 쓰기 잠금
+static pthread_rwlock_t cat_lock = PTHREAD_RWLOCK_INITIALIZER;
+static Base base;
+static DeltaEntry *delta = NULL;
+static size_t delta_cnt = 0, delta_cap = 0;
+static uint64_t delta_seq = 0;
+static int log_fd = -1;
+
+// 합치기 스레드 깨우기
+static pthread_mutex_t merge_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t merge_cond = PTHREAD_COND_INITIALIZER;
+static int merge_wanted = 0;
+
+static const char *state_names[] = {"file", "pack", "ec", "cold"};
+
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static long long mtime_of(const struct stat *st)
+{
+    return st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+// "<client_id>/<filename>" 키 만들기 (길이, 너무 길면 -1)
+static int make_key(char *out, const char *client_id, const char *filename)
+{
+    int len = snprintf(out, KEY_MAX, "%s/%s", client_id, filename);
+    return len < 0 || len >= KEY_MAX ? -1 : len;
+}
+
+// 두 키 비교 (바이트 순, 앞부분이 같으면 짧은 쪽이 앞)
+static int key_cmp(const char *a, size_t alen, const char *b, size_t blen)
+{
+    int c = memcmp(a, b, alen < blen ? alen : blen);
+    if (c != 0)
+        return c;
+    return alen < blen ? -1 : alen > blen;
+}
+
+static const char *base_key(size_t i)
+{
+    return base.heap + base.ent[i].key_off;
+}
+
+// key 이상인 첫 base 항목 위치
+static size_t base_lower(const char *key, size_t len)
+{
+    size_t lo = 0, hi = base.count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (key_cmp(base_key(mid), base.ent[mid].key_len, key, len) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// base에서 key 찾기 (없으면 NULL)
+static const CatalogEntry *base_find(const char *key, size_t len)
+{
+    size_t i = base_lower(key, len);
+    if (i < base.count && key_cmp(base_key(i), base.ent[i].key_len, key, len) == 0)
+        return &base.ent[i];
+    return NULL;
+}
+
+static void hex_to_bin(const char *hex, uint8_t *out)
+{
+    for (int i = 0; i < 32; i++)
+    {
+        unsigned v;
+        sscanf(hex + 2 * i, "%2x", &v);
+        out[i] = v;
+    }
+}
+
+static void bin_to_hex(const uint8_t *in, char *hex)
+{
+    for (int i = 0; i < 32; i++)
+        sprintf(hex + 2 * i, "%02x", in[i]);
+}
+
+// 키 순, 같은 키는 오래된 것부터
+static int delta_cmp(const void *a, const void *b)
+{
+    const DeltaEntry *x = a, *y = b;
+    int c = key_cmp(x->key, x->e.key_len, y->key, y->e.key_len);
+    if (c != 0)
+        return c;
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
+// 정렬한 뒤 같은 키는 최신만 남김 (남은 개수, owned면 버린 항목의 키 해제)
+static size_t sort_unique(DeltaEntry *v, size_t n, int owned)
+{
+    qsort(v, n, sizeof(*v), delta_cmp);
+    size_t out = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i + 1 < n && key_cmp(v[i].key, v[i].e.key_len, v[i + 1].key, v[i + 1].e.key_len) == 0)
+        {
+            if (owned)
+                free(v[i].key);
+            continue;
+        }
+        v[out++] = v[i];
+    }
+    return out;
+}
+
+// 정렬된 목록에서 key 찾기 (없으면 NULL)
+static DeltaEntry *sorted_find(DeltaEntry *v, size_t n, const char *key, size_t len)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = key_cmp(v[mid].key, v[mid].e.key_len, key, len);
+        if (c == 0)
+            return &v[mid];
+        if (c < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+// base 파일 매핑 - 크기와 CRC가 맞아야 사용 (성공 0, 없거나 깨졌으면 -1)
+static int base_map(Base *b)
+{
+    memset(b, 0, sizeof(*b));
+    int fd = open(BASE_PATH, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(BaseHeader))
+    {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+
+    const BaseHeader *h = map;
+    size_t body = st.st_size - sizeof(BaseHeader);
+    if (h->magic != BASE_MAGIC || h->count > body / sizeof(CatalogEntry) ||
+        h->count * sizeof(CatalogEntry) + h->heap_len != body ||
+        crc32_update(0, h + 1, body) != h->crc)
+    {
+        munmap(map, st.st_size);
+        return -1;
+    }
+    b->map = map;
+    b->len = st.st_size;
+    b->count = h->count;
+    b->ent = (const CatalogEntry *)(h + 1);
+    b->heap = (const char *)(b->ent + b->count);
+    return 0;
+}
+
+static void base_unmap(Base *b)
+{
+    if (b->map)
+        munmap(b->map, b->len);
+    memset(b, 0, sizeof(*b));
+}
+
+// 디렉토리 항목(rename)까지 디스크에 기록
+static void sync_dir(void)
+{
+    int fd = open(CATALOG_DIR, O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// 현재 base(use_old가 0이면 빈 목록)와 정렬된 add를 합친 새 base를 임시 파일에 쓰고 rename (성공 0, 실패 -1)
+// 같은 키는 add가 우선
+static int base_write(int use_old, const DeltaEntry *add, size_t n)
+{
+    size_t oc = use_old ? base.count : 0;
+    size_t heap_max = use_old && base.map ? base.len : 0;
+    for (size_t j = 0; j < n; j++)
+        heap_max += add[j].e.key_len;
+
+    CatalogEntry *ents = malloc((oc + n) * sizeof(CatalogEntry) + 1);
+    char *heap = malloc(heap_max + 1);
+    if (!ents || !heap)
+    {
+        free(ents);
+        free(heap);
+        return -1;
+    }
+
+    size_t i = 0, j = 0, cnt = 0;
+    uint64_t heap_len = 0;
+    while (i < oc || j < n)
+    {
+        int c = i >= oc ? 1 : j >= n ? -1 : key_cmp(base_key(i), base.ent[i].key_len, add[j].key, add[j].e.key_len);
+        CatalogEntry e;
+        const char *key;
+        if (c < 0)
+        {
+            e = base.ent[i];
+            key = base_key(i++);
+        }
+        else
+        {
+            e = add[j].e;
+            key = add[j++].key;
+            if (c == 0)
+                i++;
+        }
+        memcpy(heap + heap_len, key, e.key_len);
+        e.key_off = heap_len;
+        heap_len += e.key_len;
+        ents[cnt++] = e;
+    }
+
+    BaseHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = BASE_MAGIC;
+    h.count = cnt;
+    h.heap_len = heap_len;
+    h.crc = crc32_update(crc32_update(0, ents, cnt * sizeof(CatalogEntry)), heap, heap_len);
+
+    int fd = open(BASE_TMP, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok = fd >= 0 && write_all(fd, &h, sizeof(h)) == 0 &&
+             write_all(fd, ents, cnt * sizeof(CatalogEntry)) == 0 &&
+             write_all(fd, heap, heap_len) == 0 && fsync(fd) == 0;
+    if (fd >= 0)
+        close(fd);
+    free(ents);
+    free(heap);
+    if (!ok || rename(BASE_TMP, BASE_PATH) < 0)
+    {
+        unlink(BASE_TMP);
+        return -1;
+    }
+    sync_dir();
+    return 0;
+}
+
+// 항목 하나를 log에 덧붙임 (한 번의 write로)
+static void log_append(int fd, const char *key, const CatalogEntry *e)
+{
+    char buf[sizeof(LogRecord) + KEY_MAX];
+    LogRecord *r = (LogRecord *)buf;
+    r->magic = LOG_MAGIC;
+    r->e = *e;
+    r->e.key_off = 0;
+    memcpy(buf + sizeof(LogRecord), key, e->key_len);
+    r->crc = crc32_update(0, buf + offsetof(LogRecord, e), sizeof(CatalogEntry) + e->key_len);
+    write_all(fd, buf, sizeof(LogRecord) + e->key_len);
+}
+
+// 바뀐 항목 목록에 추가 (성공 0, 실패 -1)
+static int delta_push(const char *key, const CatalogEntry *e)
+{
+    if (delta_cnt == delta_cap)
+    {
+        size_t cap = delta_cap ? delta_cap * 2 : 1024;
+        DeltaEntry *v = realloc(delta, sizeof(DeltaEntry) * cap);
+        if (!v)
+            return -1;
+        delta = v;
+        delta_cap = cap;
+    }
+    DeltaEntry *d = &delta[delta_cnt];
+    d->key = strndup(key, e->key_len);
+    if (!d->key)
+        return -1;
+    d->seq = delta_seq++;
+    d->e = *e;
+    delta_cnt++;
+    return 0;
+}
+
+// log를 읽어 바뀐 항목 목록에 추가 - 찢어지거나 깨진 레코드부터는 잘라냄 (읽은 항목 수)
+static size_t log_replay(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+        return 0;
+    size_t len = st.st_size;
+    char *buf = malloc(len);
+    if (!buf || pread_all(fd, buf, len, 0) < 0)
+    {
+        free(buf);
+        return 0;
+    }
+
+    size_t pos = 0, n = 0;
+    while (pos + sizeof(LogRecord) <= len)
+    {
+        LogRecord r;
+        memcpy(&r, buf + pos, sizeof(r));
+        if (r.magic != LOG_MAGIC || r.e.key_len == 0 || r.e.key_len >= KEY_MAX ||
+            pos + sizeof(r) + r.e.key_len > len ||
+            crc32_update(0, buf + pos + offsetof(LogRecord, e), sizeof(CatalogEntry) + r.e.key_len) != r.crc ||
+            delta_push(buf + pos + sizeof(r), &r.e) < 0)
+            break;
+        pos += sizeof(r) + r.e.key_len;
+        n++;
+    }
+    if (pos < len && ftruncate(fd, pos) == 0)
+        printf("[CATLG] log 끝의 깨진 기록 %zu bytes 버림\n", len - pos);
+    free(buf);
+    return n;
+}
+
+// log를 남은 바뀐 항목만으로 다시 씀 (쓰기 잠금 잡은 상태, 실패하면 예전 log 유지 - 다시 읽어도 결과는 같음)
+static void log_rewrite(void)
+{
+    int fd = open(LOG_TMP, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0)
+        return;
+    for (size_t i = 0; i < delta_cnt; i++)
+        log_append(fd, delta[i].key, &delta[i].e);
+    if (fsync(fd) < 0 || rename(LOG_TMP, LOG_PATH) < 0)
+    {
+        close(fd);
+        unlink(LOG_TMP);
+        return;
+    }
+    close(log_fd);
+    log_fd = fd;
+}
+
+// 바뀐 항목 기록 후 log에 덧붙이고, 많이 쌓이면 합치기 스레드를 깨움 (쓰기 잠금 잡은 상태)
+static void record_locked(const char *key, size_t len, CatalogEntry *e)
+{
+    e->key_off = 0;
+    e->key_len = len;
+    if (delta_push(key, e) < 0)
+        return;
+    if (log_fd >= 0)
+        log_append(log_fd, key, e);
+    if (delta_cnt >= CATALOG_MERGE)
+    {
+        pthread_mutex_lock(&merge_lock);
+        merge_wanted = 1;
+        pthread_cond_signal(&merge_cond);
+        pthread_mutex_unlock(&merge_lock);
+    }
+}
+
+// key의 현재 항목 - 바뀐 항목(최신부터)이 base보다 우선 (있으면 1)
+static int lookup_locked(const char *key, size_t len, CatalogEntry *out)
+{
+    for (size_t i = delta_cnt; i-- > 0;)
+        if (delta[i].e.key_len == len && memcmp(delta[i].key, key, len) == 0)
+        {
+            *out = delta[i].e;
+            return 1;
+        }
+    const CatalogEntry *e = base_find(key, len);
+    if (e)
+        *out = *e;
+    return e != NULL;
+}
+
+// 완료된 업로드 기록
+void catalog_put(const char *client_id, const char *filename, long long size, long long mtime_ns, int state,
+                 const char *sha256)
+{
+    char key[KEY_MAX];
+    int len = make_key(key, client_id, filename);
+    if (len < 0)
+        return;
+
+    CatalogEntry e;
+    memset(&e, 0, sizeof(e));
+    e.state = state;
+    e.size = size;
+    e.mtime_ns = mtime_ns;
+    if (sha256 && sha256_valid_hex(sha256))
+    {
+        hex_to_bin(sha256, e.sha256);
+        e.hashed = 1;
+    }
+
+    pthread_rwlock_wrlock(&cat_lock);
+    record_locked(key, len, &e);
+    pthread_rwlock_unlock(&cat_lock);
+}
+
+// 저장 상태만 바꿈 (크기, 수정 시각, 해시는 그대로)
+void catalog_set_state(const char *client_id, const char *filename, int state)
+{
+    char key[KEY_MAX];
+    int len = make_key(key, client_id, filename);
+    if (len < 0)
+        return;
+
+    pthread_rwlock_wrlock(&cat_lock);
+    CatalogEntry e;
+    if (lookup_locked(key, len, &e) && e.state != state)
+    {
+        e.state = state;
+        record_locked(key, len, &e);
+    }
+    pthread_rwlock_unlock(&cat_lock);
+}
+
+static void fill_item(CatalogItem *it, const char *key, const CatalogEntry *e, size_t skip)
+{
+    size_t n = e->key_len - skip;
+    if (n >= sizeof(it->name))
+        n = sizeof(it->name) - 1;
+    memcpy(it->name, key + skip, n);
+    it->name[n] = '\0';
+    it->size = e->size;
+    it->mtime = e->mtime_ns / 1000000000LL;
+    it->state = e->state;
+    it->sha256[0] = '\0';
+    if (e->hashed)
+        bin_to_hex(e->sha256, it->sha256);
+}
+
+// base의 범위는 이진 탐색으로 찾고, 조건에 맞는 바뀐 항목을 정렬해서 같은 키는 바뀐 항목으로 바꿔 끼우며 합침
+int catalog_list(const char *client_id, const char *prefix, const char *after, CatalogItem *items, int max,
+                 long long *matched)
+{
+    char kp[KEY_MAX], ka[KEY_MAX];
+    int kplen = make_key(kp, client_id, prefix);
+    int kalen = after[0] ? make_key(ka, client_id, after) : -1;
+    *matched = 0;
+    if (kplen < 0)
+        return 0;
+    size_t skip = strlen(client_id) + 1;
+
+    pthread_rwlock_rdlock(&cat_lock);
+    DeltaEntry *dv = malloc(sizeof(DeltaEntry) * (delta_cnt + 1));
+    if (!dv)
+    {
+        pthread_rwlock_unlock(&cat_lock);
+        return 0;
+    }
+    size_t dn = 0;
+    for (size_t i = 0; i < delta_cnt; i++)
+    {
+        const DeltaEntry *d = &delta[i];
+        if (d->e.key_len >= (size_t)kplen && memcmp(d->key, kp, kplen) == 0 &&
+            (kalen < 0 || key_cmp(d->key, d->e.key_len, ka, kalen) > 0))
+            dv[dn++] = *d;
+    }
+    dn = sort_unique(dv, dn, 0);
+
+    size_t i = base_lower(kp, kplen);
+    if (kalen >= 0)
+    {
+        size_t a = base_lower(ka, kalen);
+        if (a < base.count && key_cmp(base_key(a), base.ent[a].key_len, ka, kalen) == 0)
+            a++;
+        if (a > i)
+            i = a;
+    }
+
+    int n = 0;
+    size_t j = 0;
+    while (1)
+    {
+        int in_base = i < base.count && base.ent[i].key_len >= (size_t)kplen && memcmp(base_key(i), kp, kplen) == 0;
+        if (!in_base && j >= dn)
+            break;
+        int c = !in_base ? 1 : j >= dn ? -1 : key_cmp(base_key(i), base.ent[i].key_len, dv[j].key, dv[j].e.key_len);
+        const CatalogEntry *e;
+        const char *key;
+        if (c < 0)
+        {
+            e = &base.ent[i];
+            key = base_key(i++);
+        }
+        else
+        {
+            e = &dv[j].e;
+            key = dv[j++].key;
+            if (c == 0)
+                i++;
+        }
+        (*matched)++;
+        if (n < max)
+            fill_item(&items[n++], key, e, skip);
+    }
+    pthread_rwlock_unlock(&cat_lock);
+    free(dv);
+    return n;
+}
+
+const char *catalog_state_name(int state)
+{
+    return state >= 0 && state < (int)(sizeof(state_names) / sizeof(state_names[0])) ? state_names[state] : "?";
+}
+
+// 메모리에 쌓인 바뀐 항목을 base와 합쳐 새 base로 교체
+// 합치는 동안 들어온 항목은 메모리와 새 log에 남음
+static void merge_delta(void)
+{
+    long long t0 = now_us();
+    pthread_rwlock_rdlock(&cat_lock);
+    size_t n = delta_cnt;
+    DeltaEntry *snap = malloc(sizeof(DeltaEntry) * (n + 1));
+    if (snap)
+        memcpy(snap, delta, sizeof(DeltaEntry) * n);
+    pthread_rwlock_unlock(&cat_lock);
+    if (!snap)
+        return;
+
+    // base와 앞의 n개 키는 이 스레드만 바꾸거나 해제하므로 잠금 없이 읽음
+    size_t m = sort_unique(snap, n, 0);
+    Base next;
+    int r = base_write(1, snap, m);
+    free(snap);
+    if (r < 0 || base_map(&next) < 0)
+    {
+        printf("[CATLG] 합치기 실패 (바뀐 항목 %zu개는 log에 남김)\n", n);
+        return;
+    }
+
+    pthread_rwlock_wrlock(&cat_lock);
+    Base old = base;
+    base = next;
+    for (size_t i = 0; i < n; i++)
+        free(delta[i].key);
+    memmove(delta, delta + n, sizeof(DeltaEntry) * (delta_cnt - n));
+    delta_cnt -= n;
+    log_rewrite();
+    pthread_rwlock_unlock(&cat_lock);
+    base_unmap(&old);
+
+    printf("[CATLG] merged %zu changes -> %llu entries (%lld ms)\n", n, (unsigned long long)next.count,
+           (now_us() - t0) / 1000);
+    fflush(stdout);
+}
+
+static void *merge_thread(void *arg)
+{
+    (void)arg;
+    while (1)
+    {
+        pthread_mutex_lock(&merge_lock);
+        while (!merge_wanted)
+            pthread_cond_wait(&merge_cond, &merge_lock);
+        merge_wanted = 0;
+        pthread_mutex_unlock(&merge_lock);
+        merge_delta();
+    }
+    return NULL;
+}
+
+// 다시 만들 때 스레드 하나가 모은 항목
+typedef struct
+{
+    DeltaEntry *v;
+    size_t cnt, cap;
+} ScanList;
+
+// 클라이언트 디렉토리 목록 (스레드들이 하나씩 가져감)
+typedef struct
+{
+    char (*ids)[64];
+    int cnt;
+    int next;
+    pthread_mutex_t lock;
+} ScanJob;
+
+typedef struct
+{
+    ScanJob *job;
+    ScanList list;
+    const char *id; // 지금 훑는 클라이언트 (샤드 콜백용)
+} Scanner;
+
+// 같은 이름이 여러 곳에 있으면 개별 파일 > 저온 계층 > 샤드 > 팩 (seq가 큰 쪽이 남음)
+static void scan_add(ScanList *l, const char *id, const char *file, long long size, long long mtime_ns, int state)
+{
+    static const int rank[] = {3, 0, 1, 2};
+    char key[KEY_MAX];
+    int len = make_key(key, id, file);
+    if (len < 0)
+        return;
+    if (l->cnt == l->cap)
+    {
+        size_t cap = l->cap ? l->cap * 2 : 1024;
+        DeltaEntry *v = realloc(l->v, sizeof(DeltaEntry) * cap);
+        if (!v)
+            return;
+        l->v = v;
+        l->cap = cap;
+    }
+    DeltaEntry *d = &l->v[l->cnt];
+    memset(d, 0, sizeof(*d));
+    if (!(d->key = strdup(key)))
+        return;
+    d->seq = rank[state];
+    d->e.key_len = len;
+    d->e.state = state;
+    d->e.size = size;
+    d->e.mtime_ns = mtime_ns;
+    l->cnt++;
+}
+
+static void scan_ec(const char *file, long long len, long long mtime_ns, void *arg)
+{
+    Scanner *sc = arg;
+    scan_add(&sc->list, sc->id, file, len, mtime_ns, CATALOG_EC);
+}
+
+static void scan_pack(const char *id, const char *file, long long len, long long mtime_ns, void *arg)
+{
+    scan_add(arg, id, file, len, mtime_ns, CATALOG_PACK);
+}
+
+// 클라이언트 디렉토리 하나 - 완료된 파일, 저온 계층 표시 파일, 샤드
+// 받는 중인 파일(저널이나 HTTP 전체 크기 기록이 있는 것)은 뺌
+static void scan_client(Scanner *sc, const char *id)
+{
+    char dir[80];
+    snprintf(dir, sizeof(dir), "./%s", id);
+    DIR *d = opendir(dir);
+    if (d)
+    {
+        struct dirent *e;
+        while ((e = readdir(d)) != NULL)
+        {
+            const char *name = e->d_name;
+            size_t n = strlen(name);
+            char path[600];
+            struct stat st;
+            if (name[0] == '.')
+            {
+                // ".<filename>.cold"
+                long long len;
+                char file[256];
+                if (n <= 6 || strcmp(name + n - 5, ".cold") != 0)
+                    continue;
+                memcpy(file, name + 1, n - 6);
+                file[n - 6] = '\0';
+                snprintf(path, sizeof(path), "%s/%s", dir, name);
+                if (tier_stat(id, file, &len) == 0 && stat(path, &st) == 0)
+                    scan_add(&sc->list, id, file, len, mtime_of(&st), CATALOG_COLD);
+                continue;
+            }
+
+            snprintf(path, sizeof(path), "%s/%s", dir, name);
+            if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+                continue;
+            char side[600];
+            snprintf(side, sizeof(side), "%s/.%s.journal", dir, name);
+            if (access(side, F_OK) == 0)
+                continue;
+            snprintf(side, sizeof(side), "%s/.%s.length", dir, name);
+            if (access(side, F_OK) == 0)
+                continue;
+            scan_add(&sc->list, id, name, st.st_size, mtime_of(&st), CATALOG_FILE);
+        }
+        closedir(d);
+    }
+    sc->id = id;
+    ec_foreach(id, scan_ec, sc);
+}
+
+static void *scan_thread(void *arg)
+{
+    Scanner *sc = arg;
+    ScanJob *job = sc->job;
+    while (1)
+    {
+        pthread_mutex_lock(&job->lock);
+        int i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->cnt)
+            break;
+        scan_client(sc, job->ids[i]);
+    }
+    return NULL;
+}
+
+// 정렬된 새 목록 (완료 기록 콜백용)
+typedef struct
+{
+    DeltaEntry *v;
+    size_t n;
+} Sorted;
+
+// 같은 내용 합치기(-H)의 완료 기록에 있는 해시 (기록 뒤 바뀌지 않은 개별 파일만)
+static void scan_hash(const char *hash, const char *path, void *arg)
+{
+    Sorted *s = arg;
+    if (strncmp(path, "./", 2) == 0)
+        path += 2;
+    DeltaEntry *d = sorted_find(s->v, s->n, path, strlen(path));
+    if (d && d->e.state == CATALOG_FILE)
+    {
+        hex_to_bin(hash, d->e.sha256);
+        d->e.hashed = 1;
+    }
+}
+
+// 클라이언트 디렉토리 이름 목록 ("."의 숨김이 아닌 디렉토리, 개수)
+static int list_clients(ScanJob *job)
+{
+    DIR *d = opendir(".");
+    if (!d)
+        return -1;
+    int cap = 0;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        struct stat st;
+        if (e->d_name[0] == '.' || strlen(e->d_name) >= sizeof(job->ids[0]) ||
+            stat(e->d_name, &st) < 0 || !S_ISDIR(st.st_mode))
+            continue;
+        if (job->cnt == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            char(*ids)[64] = realloc(job->ids, sizeof(job->ids[0]) * cap);
+            if (!ids)
+                break;
+            job->ids = ids;
+        }
+        strcpy(job->ids[job->cnt++], e->d_name);
+    }
+    closedir(d);
+    return job->cnt;
+}
+
+// 디스크에서 다시 만듦 - 클라이언트 디렉토리는 스레드들이 나눠 훑고 팩 색인은 이 스레드에서 읽음
+// 예전 목록(base + log)에 크기와 상태가 같은 항목이 있으면 그 해시와 수정 시각을 이어받음 (개별 파일은 수정 시각도 같아야 함)
+static int catalog_rebuild(void)
+{
+    long long t0 = now_us();
+    ScanJob job;
+    memset(&job, 0, sizeof(job));
+    pthread_mutex_init(&job.lock, NULL);
+    if (list_clients(&job) < 0)
+        return -1;
+
+    Scanner sc[CATALOG_SCAN_THREADS];
+    pthread_t tids[CATALOG_SCAN_THREADS];
+    int nt = job.cnt < CATALOG_SCAN_THREADS ? job.cnt : CATALOG_SCAN_THREADS;
+    memset(sc, 0, sizeof(sc));
+    for (int i = 0; i < nt; i++)
+    {
+        sc[i].job = &job;
+        pthread_create(&tids[i], NULL, scan_thread, &sc[i]);
+    }
+    ScanList packed;
+    memset(&packed, 0, sizeof(packed));
+    pack_foreach(scan_pack, &packed);
+    for (int i = 0; i < nt; i++)
+        pthread_join(tids[i], NULL);
+    pthread_mutex_destroy(&job.lock);
+
+    // 스레드별 목록 합치기
+    size_t total = packed.cnt;
+    for (int i = 0; i < nt; i++)
+        total += sc[i].list.cnt;
+    DeltaEntry *v = malloc(sizeof(DeltaEntry) * (total + 1));
+    if (!v)
+        return -1;
+    memcpy(v, packed.v, sizeof(DeltaEntry) * packed.cnt);
+    size_t n = packed.cnt;
+    free(packed.v);
+    for (int i = 0; i < nt; i++)
+    {
+        memcpy(v + n, sc[i].list.v, sizeof(DeltaEntry) * sc[i].list.cnt);
+        n += sc[i].list.cnt;
+        free(sc[i].list.v);
+    }
+    n = sort_unique(v, n, 1);
+
+    // 예전 목록의 해시 이어받기
+    DeltaEntry *old = malloc(sizeof(DeltaEntry) * (delta_cnt + 1));
+    size_t on = 0, carried = 0;
+    if (old)
+    {
+        memcpy(old, delta, sizeof(DeltaEntry) * delta_cnt);
+        on = sort_unique(old, delta_cnt, 0);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        const DeltaEntry *od = old ? sorted_find(old, on, v[i].key, v[i].e.key_len) : NULL;
+        const CatalogEntry *oe = od ? &od->e : base_find(v[i].key, v[i].e.key_len);
+        if (!oe || oe->size != v[i].e.size || oe->state != v[i].e.state ||
+            (oe->state == CATALOG_FILE && oe->mtime_ns != v[i].e.mtime_ns))
+            continue;
+        // 팩/샤드/저온 계층은 디스크에 원래 파일의 수정 시각이 없으므로 예전 값 유지
+        v[i].e.mtime_ns = oe->mtime_ns;
+        if (oe->hashed)
+        {
+            memcpy(v[i].e.sha256, oe->sha256, sizeof(oe->sha256));
+            v[i].e.hashed = 1;
+            carried++;
+        }
+    }
+    free(old);
+    Sorted s = {v, n};
+    dedup_foreach(scan_hash, &s);
+
+    int r = base_write(0, v, n);
+    for (size_t i = 0; i < n; i++)
+        free(v[i].key);
+    free(v);
+    free(job.ids);
+    base_unmap(&base);
+    if (r < 0 || base_map(&base) < 0)
+        return -1;
+
+    // 새 base에 모두 들어갔으므로 log 비우기
+    for (size_t i = 0; i < delta_cnt; i++)
+        free(delta[i].key);
+    delta_cnt = 0;
+    if (ftruncate(log_fd, 0) < 0)
+        return -1;
+
+    printf("[CATLG] rebuilt %zu entries from %d client dirs with %d threads, %zu hashes kept (%lld ms)\n",
+           n, job.cnt, nt, carried, (now_us() - t0) / 1000);
+    fflush(stdout);
+    return 0;
+}
+
+// base 매핑, log 다시 읽기, base가 없거나 깨졌으면 다시 만들기, 합치기 스레드 시작
+int catalog_open(int rebuild)
+{
+    if (mkdir(CATALOG_DIR, 0755) < 0 && errno != EEXIST)
+        return -1;
+
+    long long t0 = now_us();
+    int have_base = base_map(&base) == 0;
+    log_fd = open(LOG_PATH, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (log_fd < 0)
+        return -1;
+    size_t replayed = log_replay(log_fd);
+
+    if (have_base && !rebuild)
+        printf("[CATLG] %llu entries + %zu logged changes (%lld ms)\n", (unsigned long long)base.count, replayed,
+               (now_us() - t0) / 1000);
+    else
+    {
+        if (!have_base && !rebuild)
+            printf("[CATLG] %s 없음 또는 깨짐 - 디스크에서 다시 만듦\n", BASE_PATH);
+        if (catalog_rebuild() < 0)
+            return -1;
+    }
+
+    fflush(stdout);
+
+    pthread_t t;
+    if (pthread_create(&t, NULL, merge_thread, NULL) != 0)
+        return -1;
+    pthread_detach(t);
+    if (delta_cnt >= CATALOG_MERGE)
+    {
+        pthread_mutex_lock(&merge_lock);
+        merge_wanted = 1;
+        pthread_cond_signal(&merge_cond);
+        pthread_mutex_unlock(&merge_lock);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "sha256.h"
+
+// 완료된 업로드 목록 (LIST 명령): 업로드마다 크기, 수정 시각, sha256, 저장 위치(상태)
+//   ./.catalog/base  "<client_id>/<filename>" 순으로 정렬한 고정 크기 항목 + 키 모음 (mmap으로 이진 탐색)
+//   ./.catalog/log   FIN 때마다 바뀐 항목을 덧붙이는 기록 (시작할 때 다시 읽어 메모리에 둠, 찢어진 끝은 버림)
+// 바뀐 항목이 CATALOG_MERGE개 쌓이면 백그라운드 스레드가 base와 합친 새 base를 만들어 rename으로 교체
+// base가 없거나 깨졌으면(또는 -L) 업로드 디렉토리, 팩, 샤드, 저온 계층 표시 파일을 여러 스레드로 훑어 다시 만듦
+#define CATALOG_DIR "./.catalog"
+
+// base와 합치기 전에 메모리에 모아 두는 바뀐 항목 수
+#define CATALOG_MERGE 65536
+
+// 다시 만들 때 클라이언트 디렉토리를 나눠 훑는 스레드 수
+#define CATALOG_SCAN_THREADS 8
+
+// LIST 한 번에 돌려주는 항목 수 기본값 / 최대값
+#define CATALOG_LIST_DEFAULT 1000
+#define CATALOG_LIST_MAX 10000
+
+// 저장 상태
+#define CATALOG_FILE 0 // ./<client_id>/<filename>
+#define CATALOG_PACK 1 // 팩 파일 (-k)
+#define CATALOG_EC 2   // 소거 부호 샤드 (-E)
+#define CATALOG_COLD 3 // 저온 계층 (-C)
+
+// LIST 결과 한 항목
+typedef struct
+{
+    char name[256];
+    long long size;
+    long long mtime; // 초
+    int state;
+    char sha256[SHA256_HEX + 1]; // 모르면 빈 문자열
+} CatalogItem;
+
+// 목록 열기 - rebuild면 디스크에서 다시 만듦 (성공 0, 실패 -1)
+int catalog_open(int rebuild);
+
+// 완료된 업로드 기록 (mtime_ns: 수정 시각 ns, sha256: 확인한 해시, 모르면 NULL)
+void catalog_put(const char *client_id, const char *filename, long long size, long long mtime_ns, int state,
+                 const char *sha256);
+
+// 저장 상태만 바꿈 (목록에 없으면 아무것도 안 함)
+void catalog_set_state(const char *client_id, const char *filename, int state);
+
+// client_id 의 업로드 중 prefix로 시작하고 after(빈 문자열이면 처음부터)보다 뒤인 이름을 이름 순으로 최대 max개
+// (items에 채운 개수 반환, *matched: 조건에 맞는 전체 개수)
+int catalog_list(const char *client_id, const char *prefix, const char *after, CatalogItem *items, int max,
+                 long long *matched);
+
+// 상태 이름 (file, pack, ec, cold)
+const char *catalog_state_name(int state);
+
+#endif
@@ -2,33 +2,193 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <signal.h>
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "netio.h"
+#include "delta.h"
+#include "extent.h"
+#include "trace.h"
+#include "localfd.h"
+#include "readahead.h"
+#include "statedir.h"
+#include "lz.h"
+#include "zpool.h"
+#include "endpoint.h"
+#include "sha256.h"
+#include "tcptune.h"
 
 #define CHUNK 4096
 
+// 파일 스트리밍 전송 시 한 번에 읽는 크기 (-c 로 청크를 키워도 메모리는 이만큼만 사용)
+#define SEND_BUF (256 * 1024)
+
+// 미리 읽기 버퍼 수 기본값 (-a, 0이면 전송 스레드가 직접 읽음)
+#define READ_AHEAD 4
+
+// 접속과 FIRST/RESUME 응답을 기다리는 최대 시간 (초, 죽은 서버에서 오래 멈추지 않게 함)
+#define CONNECT_TIMEOUT 3
+
+// 서버가 이 시간(초) 이상 계속 실패하면 대체 서버로 옮김 (-w)
+#define FAILOVER_SEC 5
+
+// 압축 전송(-z) 작업 스레드 수
+#define ZIP_THREADS 4
+
+// 병렬 경로 업로드에서 한 번에 나눠 주는 구간 크기
+#define STRIPE (1024 * 1024)
+#define MAX_PATHS 8
+
+// 동시에 업로드하는 파일 수 기본값 (-j), 대기열 최대 길이
+#define QUEUE_JOBS 4
+#define MAX_JOBS 64
+#define MAX_QUEUE 1024
+
+// 목록 조회(-L)에서 LIST 한 번에 요청하는 항목 수 (서버 최대값)
+#define LIST_PAGE 10000
+
 typedef struct
 {
     // Socket descriptor
     int sd;
     // Server address
-    char *server_ip;
+    char server_ip[64];
     // Server port
     int server_port;
+    // 서버 목록(endpoint.c)에서 현재 연결한 서버 번호 (유닉스 소켓이면 -1)
+    int ep;
+    // 현재 연결의 소켓 버퍼를 RTT로 정했는지 (TCP Fast Open 이면 첫 응답 후)
+    int tuned;
 
     char client_id[64];
     char filename[256];
 
-    FILE *fp;
-    long file_size;
-    long offset;
+    int fd;
+    long long file_size;
+    long long offset;
+
+    // DATA 한 청크 크기 (-c, 최대 MAX_CHUNK_SIZE)
+    long long chunk;
+
+    // 델타 업로드 모드 (-d)
+    int delta;
+
+    // 병렬 경로 수 (-p), 경로별 출발지 주소 목록 (-b)
+    int paths;
+    char *bind_ips[MAX_PATHS];
+    int bind_cnt;
+    // 이 연결이 사용할 출발지 주소 (없으면 NULL)
+    char *bind_ip;
+
+    // 같은 호스트 서버의 유닉스 도메인 소켓 (-u), 현재 연결이 그 소켓인지
+    char *unix_path;
+    int local;
+    // 파일 디스크립터 전달(FILEFD) 사용 여부 (서버가 거부하면 DATA로 전환)
+    int pass_fd;
+
+    // 미리 읽기 버퍼 수 (-a)와 읽기 스레드 (upload_file에서만 사용)
+    int ahead;
+    ReadAhead *ra;
+
+    // 청크 압축 요청 (-z), 서버가 FIRST/RESUME 응답에서 코덱을 받아들였는지, 압축 작업 풀
+    int compress;
+    int zip_ok;
+    ZPool *zp;
+    // 압축 전송한 청크의 원본 / 실제 전송 바이트 수
+    long long zip_raw;
+    long long zip_sent;
+
+    // 파일 전체 해시를 FIRST/RESUME 에 붙임 (-H), 계산한 해시 (없으면 빈 문자열)
+    int hash;
+    char sha256[SHA256_HEX + 1];
+
+    // 상태 디렉토리 (-s, 없으면 NULL)와 이 업로드의 상태
+    char *state_dir;
+    UploadState *state;
 } UploadClient;
 
+// 소켓 송수신 시간 제한 (0이면 해제)
+static void set_timeout(int sd, int sec)
+{
+    struct timeval tv = {sec, 0};
+    setsockopt(sd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+// FIRST/RESUME 응답을 받음 - 시간 제한을 풀고 서버 상태에 성공과 왕복 시간 기록
+static void handshake_done(UploadClient *uc, long long t_start_us)
+{
+    if (uc->local)
+        return;
+    set_timeout(uc->sd, 0);
+    if (!uc->tuned)
+        uc->tuned = tune_socket(uc->sd, "client") == 1;
+    endpoint_report(uc->ep, 1, endpoint_now_us() - t_start_us);
+}
+
 // 서버에 접속하는 함수
 int connect_server(UploadClient *uc)
 {
+    // 같은 호스트 서버면 유닉스 도메인 소켓 먼저 시도 (실패하면 TCP로 접속)
+    uc->local = 0;
+    uc->ep = -1;
+    if (uc->unix_path)
+    {
+        int sd = unix_connect(uc->unix_path);
+        if (sd >= 0)
+        {
+            printf("서버 접속 성공: %s (local)\n", uc->unix_path);
+            fflush(stdout);
+            uc->sd = sd;
+            uc->local = 1;
+            return 0;
+        }
+        perror(uc->unix_path);
+    }
+
+    // 서버 목록에서 이번에 접속할 서버 선택 (현재 서버가 오래 실패하면 대체 서버)
+    Endpoint ep;
+    uc->ep = endpoint_pick(&ep);
+    snprintf(uc->server_ip, sizeof(uc->server_ip), "%s", ep.ip);
+    uc->server_port = ep.port;
+
     // Socket descriptor 생성
     int sd = socket(PF_INET, SOCK_STREAM, 0);
 
+    // 접속과 첫 응답까지만 시간 제한 (handshake_done 에서 해제)
+    set_timeout(sd, CONNECT_TIMEOUT);
+
+#ifdef TCP_FASTOPEN_CONNECT
+    // 전에 응답한 서버에 다시 접속할 때는 TCP Fast Open 사용: connect는 바로 돌아오고
+    // 첫 send(RESUME)가 SYN에 실려 가서 왕복 한 번을 줄임 (쿠키가 없으면 일반 접속)
+    if (ep.connected)
+    {
+        int one = 1;
+        setsockopt(sd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &one, sizeof(one));
+    }
+#endif
+
+    // 경로별 출발지 주소 지정 (예: Wi-Fi / LTE 인터페이스 주소)
+    if (uc->bind_ip)
+    {
+        struct sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = inet_addr(uc->bind_ip);
+        if (bind(sd, (struct sockaddr *)&local, sizeof(local)) < 0)
+        {
+            perror("bind");
+            close(sd);
+            endpoint_report(uc->ep, 0, 0);
+            return -1;
+        }
+    }
+
     // 서버 주소 설정
     struct sockaddr_in serv;
     memset(&serv, 0, sizeof(serv));
@@ -44,11 +204,16 @@ int connect_server(UploadClient *uc)
     if (connect(sd, (struct sockaddr *)&serv, sizeof(serv)) < 0)
     {
         perror("connect");
+        close(sd);
+        endpoint_report(uc->ep, 0, 0);
         return -1;
     }
 
     // 접속 성공 메시지 출력
     printf("서버 접속 성공: %s:%d\n", uc->server_ip, uc->server_port);
+
+    // RTT로 소켓 버퍼를 정하고 Nagle 끄기
+    uc->tuned = tune_socket(sd, "client") == 1;
     fflush(stdout);
 
     // Socket descriptor 저장
@@ -56,13 +221,43 @@ int connect_server(UploadClient *uc)
     return 0;
 }
 
+// FIRST/RESUME 끝에 붙이는 선택 토큰 (압축 코덱 이름, 파일 해시)
+static void upload_options(UploadClient *uc, char *out, size_t size)
+{
+    snprintf(out, size, "%s%s%s", uc->compress ? " " LZ_CODEC : "",
+             uc->sha256[0] ? " " SHA256_TOKEN : "", uc->sha256);
+}
+
+// FIRST/RESUME 응답 한 줄 수신 (실패 -1)
+// 같은 내용을 먼저 올리는 업로드가 서버에 있으면 그 진행 상황(WAIT)을 받다가 끝나면 ACK를 받음
+static int read_reply(UploadClient *uc, char *line, int size)
+{
+    while (1)
+    {
+        if (read_line(uc->sd, line, size) < 0)
+            return -1;
+
+        long long done, total;
+        if (sscanf(line, "WAIT %lld %lld", &done, &total) != 2)
+            return 0;
+        printf("[WAIT ] %s 같은 내용을 서버가 받는 중 %lld / %lld\n", uc->filename, done, total);
+        fflush(stdout);
+    }
+}
+
 // FIRST 메시지 전송 함수
 int send_FIRST(UploadClient *uc)
 {
+    long long t0 = trace_now();
+    long long t_start = endpoint_now_us();
+
     // FIRST 메시지 생성
-    char msg[256];
-    snprintf(msg, sizeof(msg), "FIRST %s %s %ld\n",
-             uc->client_id, uc->filename, uc->file_size);
+    char msg[512], opts[128];
+    // 압축을 쓰려면 코덱 이름을 붙여 협상 (서버가 같은 이름을 붙여 응답해야 사용)
+    // 파일 해시를 붙이면 서버가 같은 내용의 업로드와 합침
+    upload_options(uc, opts, sizeof(opts));
+    snprintf(msg, sizeof(msg), "FIRST %s %s %lld%s\n",
+             uc->client_id, uc->filename, uc->file_size, opts);
 
     // msg_len: 메시지의 길이
     // sent: 이미 전송된 바이트 수
@@ -85,43 +280,18 @@ int send_FIRST(UploadClient *uc)
         sent += send_cnt;
     }
 
-    // 서버로부터 ACK 응답 수신
-
-    // 응답 메시지 저장
+    // 서버로부터 ACK 응답 수신 (같은 내용을 기다리는 동안의 WAIT는 건너뜀)
     char line[128];
-
-    // 현재 위치
-    int pos = 0;
-
-    // 읽은 바이트 수
-    int read_len;
-
-    // 한 글자씩 읽기 위한 변수
-    char c;
-
-    // 한 글자씩 읽어서 응답 메시지 생성
-    while ((read_len = read(uc->sd, &c, 1)) > 0)
-    {
-        // 읽은 글자를 응답 메시지에 추가
-        line[pos++] = c;
-
-        // 개행 문자이거나 버퍼가 가득 찼으면 종료
-        if (c == '\n' || pos >= (int)sizeof(line) - 1)
-            break;
-    }
-
-    // 읽기 오류 처리
-    if (read_len <= 0)
+    if (read_reply(uc, line, sizeof(line)) < 0)
         return -1;
 
-    // 응답 메시지 종료 문자 추가
-    line[pos] = '\0';
-
-    // ACK 메시지에서 offset 추출
-    sscanf(line, "ACK %ld", &uc->offset);
-
-    // 파일 포인터를 offset 위치로 이동
-    fseek(uc->fp, uc->offset, SEEK_SET);
+    // ACK 메시지에서 offset 추출 (이후 전송은 이 위치부터 pread)
+    char codec[16] = "";
+    sscanf(line, "ACK %lld %15s", &uc->offset, codec);
+    uc->zip_ok = uc->compress && strcmp(codec, LZ_CODEC) == 0;
+    handshake_done(uc, t_start);
+    trace_complete("FIRST", t0, "\"id\":\"%s\",\"file\":\"%s\",\"size\":%lld,\"offset\":%lld",
+                   trace_str(uc->client_id), trace_str(uc->filename), uc->file_size, uc->offset);
 
     return 0;
 }
@@ -129,9 +299,14 @@ int send_FIRST(UploadClient *uc)
 // RESUME 메시지 전송 함수
 int send_RESUME(UploadClient *uc)
 {
+    long long t0 = trace_now();
+    long long t_start = endpoint_now_us();
+
     // RESUME 메시지 생성
-    char msg[256];
-    snprintf(msg, sizeof(msg), "RESUME %s %s\n", uc->client_id, uc->filename);
+    char msg[512], opts[128];
+    upload_options(uc, opts, sizeof(opts));
+    snprintf(msg, sizeof(msg), "RESUME %s %s %lld%s\n",
+             uc->client_id, uc->filename, uc->file_size, opts);
 
     // msg_len: 메시지의 길이
     // sent: 이미 전송된 바이트 수
@@ -154,31 +329,18 @@ int send_RESUME(UploadClient *uc)
         sent += send_cnt;
     }
 
-    // 서버로부터 ACK 응답 수신
+    // 서버로부터 ACK 응답 수신 (같은 내용을 기다리는 동안의 WAIT는 건너뜀)
     char line[128];
-    int pos = 0;
-    int read_len;
-    char c;
-
-    // 한 글자씩 읽어서 응답 메시지 생성하는 반복문
-    while ((read_len = read(uc->sd, &c, 1)) > 0)
-    {
-        line[pos++] = c;
-        if (c == '\n' || pos >= (int)sizeof(line) - 1)
-            break;
-    }
-
-    // read_len이 0 이하인 경우 return -1
-    if (read_len <= 0)
+    if (read_reply(uc, line, sizeof(line)) < 0)
         return -1;
 
-    // 응답 메시지 종료 문자 추가
-    line[pos] = '\0';
-
-    // ACK 메시지에서 offset 추출
-    sscanf(line, "ACK %ld", &uc->offset);
-    // 파일 포인터를 offset 위치로 이동
-    fseek(uc->fp, uc->offset, SEEK_SET);
+    // ACK 메시지에서 offset 추출 (재접속한 서버가 압축을 모르면 원본으로 전송)
+    char codec[16] = "";
+    sscanf(line, "ACK %lld %15s", &uc->offset, codec);
+    uc->zip_ok = uc->compress && strcmp(codec, LZ_CODEC) == 0;
+    handshake_done(uc, t_start);
+    trace_complete("RESUME", t0, "\"id\":\"%s\",\"file\":\"%s\",\"offset\":%lld",
+                   trace_str(uc->client_id), trace_str(uc->filename), uc->offset);
 
     return 0;
 }
@@ -186,6 +348,9 @@ int send_RESUME(UploadClient *uc)
 // DATA 청크 전송 함수
 int send_DATA_chunk(UploadClient *uc, char *buf, int size)
 {
+    int traced = trace_sample();
+    long long t0 = trace_now();
+
     // DATA 헤더 생성
     char header[64];
     sprintf(header, "DATA %d\n", size);
@@ -198,6 +363,8 @@ int send_DATA_chunk(UploadClient *uc, char *buf, int size)
     int sent = 0;
     int send_cnt;
 
+    // 헤더와 청크를 꽉 찬 세그먼트로 묶어서 전송
+    tune_bulk_begin(uc->sd);
     while (sent < header_len)
     {
         send_cnt = send(uc->sd, header + sent, header_len - sent, 0);
@@ -215,6 +382,7 @@ int send_DATA_chunk(UploadClient *uc, char *buf, int size)
             return -1;
         sent += send_cnt;
     }
+    tune_bulk_end(uc->sd);
 
     // 서버로부터 ACK 응답 수신
     char line[128];
@@ -236,14 +404,182 @@ int send_DATA_chunk(UploadClient *uc, char *buf, int size)
     line[pos] = '\0';
 
     // ACK 메시지에서 offset 추출
-    sscanf(line, "ACK %ld", &uc->offset);
+    sscanf(line, "ACK %lld", &uc->offset);
+    if (traced)
+        trace_complete("DATA", t0, "\"len\":%d,\"offset\":%lld", size, uc->offset);
+
+    return 0;
+}
+
+// 파일 스트리밍 DATA 전송 함수 - 현재 offset부터 size 바이트를 SEND_BUF 단위로 읽어서 전송
+// (청크 전체를 메모리에 올리지 않으므로 큰 청크도 같은 메모리로 전송)
+int send_DATA_file(UploadClient *uc, long long size)
+{
+    int traced = trace_sample();
+    long long t0 = trace_now();
+
+    // 미리 읽기 위치가 어긋나면 (재접속 후 ACK가 다르면) 현재 offset부터 다시 시작
+    if (uc->ahead > 0 && (!uc->ra || readahead_pos(uc->ra) != uc->offset))
+    {
+        readahead_stop(uc->ra);
+        uc->ra = readahead_start(uc->fd, uc->offset, uc->file_size, SEND_BUF, uc->ahead);
+    }
+
+    char header[64];
+    int len = sprintf(header, "DATA %lld\n", size);
+    tune_bulk_begin(uc->sd);
+    if (write_all(uc->sd, header, len) < 0)
+        return -1;
+
+    // 대기열의 여러 업로드가 동시에 보내므로 스레드마다 버퍼 하나
+    static __thread char buf[SEND_BUF];
+    long long done = 0;
+    while (done < size)
+    {
+        // 읽기 스레드가 채워 둔 버퍼를 바로 전송
+        if (uc->ra)
+        {
+            const char *p;
+            ssize_t n = readahead_get(uc->ra, size - done, &p);
+            if (n <= 0 || write_all(uc->sd, p, n) < 0)
+                return -1;
+            readahead_advance(uc->ra, n);
+            done += n;
+            continue;
+        }
+
+        size_t want = size - done < SEND_BUF ? (size_t)(size - done) : SEND_BUF;
+        if (pread_all(uc->fd, buf, want, uc->offset + done) < 0 ||
+            write_all(uc->sd, buf, want) < 0)
+            return -1;
+        done += want;
+    }
+    tune_bulk_end(uc->sd);
+
+    char line[128];
+    if (read_line(uc->sd, line, sizeof(line)) < 0)
+        return -1;
+    if (sscanf(line, "ACK %lld", &uc->offset) != 1)
+        return -1;
+    if (traced)
+        trace_complete("DATA", t0, "\"len\":%lld,\"offset\":%lld", size, uc->offset);
+    return 0;
+}
+
+// 압축 DATA 전송 함수 - 작업 풀이 압축해 둔 다음 청크를 ZDATA <원본 길이> <압축 길이> 로 전송
+// (줄지 않은 청크는 DATA로 원본 전송, ACK 오프셋은 항상 원본 기준)
+int send_DATA_zip(UploadClient *uc)
+{
+    int traced = trace_sample();
+    long long t0 = trace_now();
+
+    // 풀의 위치가 어긋나면 (재접속 후 ACK가 다르면) 현재 offset부터 다시 시작
+    if (!uc->zp || zpool_pos(uc->zp) != uc->offset)
+    {
+        zpool_stop(uc->zp);
+        size_t unit = uc->chunk < LZ_CHUNK_MAX ? (size_t)uc->chunk : LZ_CHUNK_MAX;
+        uc->zp = zpool_start(uc->fd, uc->offset, uc->file_size, unit, ZIP_THREADS);
+        if (!uc->zp)
+            return -1;
+    }
+
+    const ZChunk *c = zpool_get(uc->zp);
+    if (!c)
+        return -1;
+
+    char header[64];
+    int len = c->zlen ? sprintf(header, "ZDATA %zu %zu\n", c->len, c->zlen)
+                      : sprintf(header, "DATA %zu\n", c->len);
+    tune_bulk_begin(uc->sd);
+    if (write_all(uc->sd, header, len) < 0 ||
+        write_all(uc->sd, c->zlen ? c->z : c->raw, c->zlen ? c->zlen : c->len) < 0)
+        return -1;
+    tune_bulk_end(uc->sd);
 
+    char line[128];
+    if (read_line(uc->sd, line, sizeof(line)) < 0)
+        return -1;
+    if (sscanf(line, "ACK %lld", &uc->offset) != 1)
+        return -1;
+    uc->zip_raw += c->len;
+    uc->zip_sent += c->zlen ? c->zlen : c->len;
+    if (traced)
+        trace_complete("ZDATA", t0, "\"len\":%zu,\"zlen\":%zu,\"offset\":%lld", c->len, c->zlen, uc->offset);
+    zpool_advance(uc->zp);
+    return 0;
+}
+
+// 위치 지정 DATA 전송 함수 - DATA <offset> <len> 으로 지정한 위치에 저장 요청
+int send_DATA_at(UploadClient *uc, long long offset, char *buf, int size)
+{
+    int traced = trace_sample();
+    long long t0 = trace_now();
+
+    char header[64];
+    int len = sprintf(header, "DATA %lld %d\n", offset, size);
+    tune_bulk_begin(uc->sd);
+    if (write_all(uc->sd, header, len) < 0 || write_all(uc->sd, buf, size) < 0)
+        return -1;
+    tune_bulk_end(uc->sd);
+
+    // 서버로부터 ACK 응답 수신 (ACK 값은 0부터 연속으로 받은 끝 오프셋)
+    char line[128];
+    if (read_line(uc->sd, line, sizeof(line)) < 0)
+        return -1;
+    if (sscanf(line, "ACK %lld", &uc->offset) != 1)
+        return -1;
+    if (traced)
+        trace_complete("DATA", t0, "\"at\":%lld,\"len\":%d,\"offset\":%lld", offset, size, uc->offset);
+    return 0;
+}
+
+// FILEFD 전송 함수 - 원본 파일 디스크립터를 넘겨 서버가 현재 offset부터 끝까지 직접 복사하게 함
+// (유닉스 도메인 소켓 연결에서만 사용, 응답은 DATA와 같은 ACK)
+int send_FILEFD(UploadClient *uc)
+{
+    long long t0 = trace_now();
+
+    char header[64];
+    int len = sprintf(header, "FILEFD %lld\n", uc->file_size);
+    if (send_with_fd(uc->sd, header, len, uc->fd) < 0)
+        return -1;
+
+    char line[128];
+    if (read_line(uc->sd, line, sizeof(line)) < 0)
+        return -1;
+    if (sscanf(line, "ACK %lld", &uc->offset) != 1)
+        return -1;
+    trace_complete("FILEFD", t0, "\"offset\":%lld", uc->offset);
+    return 0;
+}
+
+// HOLES 요청 함수 - 서버가 아직 받지 못한 구간 목록을 holes에 저장
+int send_HOLES(UploadClient *uc, ExtentMap *holes)
+{
+    if (write_all(uc->sd, "HOLES\n", 6) < 0)
+        return -1;
+
+    char line[128];
+    int cnt;
+    if (read_line(uc->sd, line, sizeof(line)) < 0 || sscanf(line, "HOLES %d", &cnt) != 1)
+        return -1;
+
+    for (int i = 0; i < cnt; i++)
+    {
+        long long start, end;
+        if (read_line(uc->sd, line, sizeof(line)) < 0 ||
+            sscanf(line, "%lld %lld", &start, &end) != 2)
+            return -1;
+        extent_add(holes, start, end);
+    }
     return 0;
 }
 
 // FIN 메시지 전송 함수
 int send_FIN(UploadClient *uc)
 {
+    long long t0 = trace_now();
+
     // FIN 메시지 생성
 
     const char *fin_msg = "FIN\n";
@@ -283,106 +619,1005 @@ int send_FIN(UploadClient *uc)
 
     // 서버가 COMPLETE 메시지를 보낼 때까지 반복
     if (strncmp(line, "COMPLETE", 8) == 0)
+    {
+        trace_complete("FIN", t0, "\"id\":\"%s\",\"file\":\"%s\",\"size\":%lld",
+                       trace_str(uc->client_id), trace_str(uc->filename), uc->file_size);
         return 0;
+    }
 
     return -1;
 }
 
-// 파일 업로드 함수
-int upload_file(UploadClient *uc)
+// 목록 조회 - prefix로 시작하는 완료된 업로드를 이름 순으로 모두 출력
+// 한 번에 LIST_PAGE개씩 받고 마지막 이름 다음부터 이어서 요청 (응답 줄이 많으므로 버퍼를 두고 읽음)
+static int list_uploads(UploadClient *uc, const char *prefix)
 {
-    // 파일에서 읽은 데이터 청크를 저장하는 버퍼
-    char buf[CHUNK];
+    if (connect_server(uc) < 0)
+        return -1;
+    int fd = dup(uc->sd);
+    FILE *fp = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (!fp)
+    {
+        close(uc->sd);
+        return -1;
+    }
 
-    // 파일의 끝까지 반복
-    while (uc->offset < uc->file_size)
+    long long t0 = endpoint_now_us(), shown = 0;
+    char after[256] = "", line[512];
+    int ret = 0;
+    while (1)
     {
-        // 파일에서 데이터 청크 읽기
-        fseek(uc->fp, uc->offset, SEEK_SET);
-        int n = fread(buf, 1, CHUNK, uc->fp);
+        char req[600];
+        int len = snprintf(req, sizeof(req), "LIST %s %d prefix=%s%s%s\n", uc->client_id, LIST_PAGE, prefix,
+                           after[0] ? " after=" : "", after);
+        int cnt;
+        long long matched;
+        if (write_all(uc->sd, req, len) < 0 || !fgets(line, sizeof(line), fp) ||
+            sscanf(line, "LIST %d %lld", &cnt, &matched) != 2)
+        {
+            ret = -1;
+            break;
+        }
+        for (int i = 0; i < cnt && ret == 0; i++)
+        {
+            if (!fgets(line, sizeof(line), fp) || sscanf(line, "%255s", after) != 1)
+                ret = -1;
+            else
+                fputs(line, stdout);
+        }
+        shown += cnt;
+        if (ret < 0 || cnt == 0 || cnt >= matched)
+            break;
+    }
+    printf("[LIST ] id=%s prefix=%s %lld개 (%.1f ms)%s\n", uc->client_id, prefix, shown,
+           (endpoint_now_us() - t0) / 1000.0, ret < 0 ? " - 응답 오류" : "");
+    fclose(fp);
+    close(uc->sd);
+    return ret;
+}
+
+// 기존 소켓을 닫고 접속될 때까지 재접속 시도
+void reconnect_server(UploadClient *uc)
+{
+    long long t0 = trace_now();
+    int attempts = 1;
+
+    // 기존 소켓 닫기
+    close(uc->sd);
+
+    // 서버에 재접속 시도
+    while (connect_server(uc) < 0)
+    {
+        // 접속 실패 시 1초 대기 후 재시도
+        perror("connect");
+        sleep(1);
+        attempts++;
+    }
+
+    // 재접속 성공 메세지
+    printf("재접속 성공: %s:%d\n", uc->server_ip, uc->server_port);
+    trace_complete("reconnect", t0, "\"attempts\":%d,\"offset\":%lld", attempts, uc->offset);
+}
+
+// 재접속 후 RESUME이 성공할 때까지 반복 (RESUME 도중에 다시 끊겨도 재시도)
+void resume_server(UploadClient *uc)
+{
+    while (1)
+    {
+        reconnect_server(uc);
+        if (send_RESUME(uc) == 0)
+            break;
+
+        // 접속은 됐지만 RESUME 응답이 없으면 (TCP Fast Open 접속 실패 포함) 그 서버의 실패로 기록하고
+        // 접속 실패와 같이 1초 대기 후 재시도
+        endpoint_report(uc->ep, 0, 0);
+        sleep(1);
+    }
+    printf("RESUME -- offset = %lld\n", uc->offset);
+}
+
+// 보류 중인 블록 참조(COPY)를 전송하는 함수
+static int flush_COPY(UploadClient *uc, long long *start, long long *count)
+{
+    if (*count == 0)
+        return 0;
 
-        // 읽은 바이트 수가 0 이하이면 종료
+    char msg[64];
+    int len = sprintf(msg, "COPY %lld %lld\n", *start, *count);
+    if (write_all(uc->sd, msg, len) < 0)
+        return -1;
+
+    char line[128];
+    if (read_line(uc->sd, line, sizeof(line)) < 0)
+        return -1;
+    sscanf(line, "ACK %lld", &uc->offset);
+
+    *count = 0;
+    return 0;
+}
+
+// 파일 전체의 sha256 계산 (-H, 성공 0, 실패 -1)
+static int hash_file(UploadClient *uc)
+{
+    char *buf = malloc(SEND_BUF);
+    if (!buf)
+        return -1;
+
+    long long t_start = endpoint_now_us();
+    Sha256 h;
+    sha256_init(&h);
+    long long off = 0;
+    while (off < uc->file_size)
+    {
+        ssize_t n = pread(uc->fd, buf, SEND_BUF, off);
         if (n <= 0)
             break;
+        sha256_update(&h, buf, n);
+        off += n;
+    }
+    free(buf);
+    if (off != uc->file_size)
+        return -1;
+
+    sha256_final_hex(&h, uc->sha256);
+    printf("[HASH ] %s sha256=%.16s... (%lld ms)\n", uc->filename, uc->sha256,
+           (endpoint_now_us() - t_start) / 1000);
+    return 0;
+}
+
+// 리터럴 데이터를 DATA 청크로 나눠 전송하는 함수 (일반 업로드와 같은 -c 청크 크기로 묶어서)
+static int flush_literal(UploadClient *uc, const unsigned char *p, long long len)
+{
+    while (len > 0)
+    {
+        int n = len < uc->chunk ? (int)len : (int)uc->chunk;
+        if (send_DATA_chunk(uc, (char *)p, n) < 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// 델타 업로드 함수 - 서버 파일의 블록 서명과 비교해 바뀐 부분만 전송
+// 서버가 재구성한 파일을 확인할 수 있도록 파일 전체의 sha256을 함께 보냄
+int upload_delta(UploadClient *uc)
+{
+    long long t0 = trace_now();
+
+    // DELTA 메시지 전송
+    char msg[400];
+    long long t_start = endpoint_now_us();
+    int len = snprintf(msg, sizeof(msg), "DELTA %s %s %lld %s%s\n",
+                       uc->client_id, uc->filename, uc->file_size, SHA256_TOKEN, uc->sha256);
+    if (write_all(uc->sd, msg, len) < 0)
+        return -1;
+
+    // 큰 파일은 서명 계산이 오래 걸리므로 접속 확인(전송 성공) 후 바로 시간 제한 해제
+    if (!uc->local)
+        set_timeout(uc->sd, 0);
 
-        // 데이터 청크 전송
-        if (send_DATA_chunk(uc, buf, n) == 0)
+    // 서명 헤더 수신: SIG <block_size> <count>
+    char line[128];
+    unsigned int bs;
+    long long count;
+    if (read_line(uc->sd, line, sizeof(line)) < 0 ||
+        sscanf(line, "SIG %u %lld", &bs, &count) != 2 || bs == 0)
+        return -1;
+    endpoint_report(uc->ep, 1, endpoint_now_us() - t_start);
+
+    // 서명을 weak 체크섬 해시 테이블(체이닝)로 구성
+    long long nbucket = 1;
+    while (nbucket < count * 2)
+        nbucket <<= 1;
+
+    DeltaSig *sigs = malloc(sizeof(DeltaSig) * (count > 0 ? count : 1));
+    long long *head = malloc(sizeof(long long) * nbucket);
+    long long *next = malloc(sizeof(long long) * (count > 0 ? count : 1));
+    if (!sigs || !head || !next)
+    {
+        free(sigs);
+        free(head);
+        free(next);
+        return -1;
+    }
+    for (long long i = 0; i < nbucket; i++)
+        head[i] = -1;
+
+    int ret = -1;
+    unsigned char rec[DELTA_SIG_LEN];
+    for (long long i = 0; i < count; i++)
+    {
+        if (read_all(uc->sd, rec, sizeof(rec)) < 0)
+            goto out;
+        delta_sig_unpack(rec, &sigs[i]);
+        long long h = sigs[i].weak & (nbucket - 1);
+        next[i] = head[h];
+        head[h] = i;
+    }
+
+    // 원본 파일을 매핑해서 롤링 체크섬으로 일치 블록 탐색
+    const unsigned char *p = NULL;
+    long long size = uc->file_size;
+    if (size > 0)
+    {
+        p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, uc->fd, 0);
+        if (p == MAP_FAILED)
+            goto out;
+        madvise((void *)p, size, MADV_SEQUENTIAL);
+    }
+
+    long long pos = 0, lit_start = 0;
+    long long copy_start = 0, copy_count = 0;
+    long long copied = 0;
+    DeltaRoll r;
+    if (count > 0 && size >= (long long)bs)
+        delta_roll_init(&r, p, bs);
+
+    while (count > 0 && pos + (long long)bs <= size)
+    {
+        // weak 체크섬이 같은 후보 중 strong 해시까지 일치하는 블록 찾기
+        uint32_t weak = delta_roll_value(&r);
+        long long match = -1;
+        int strong_done = 0;
+        uint64_t strong = 0;
+        for (long long i = head[weak & (nbucket - 1)]; i >= 0; i = next[i])
+        {
+            if (sigs[i].weak != weak)
+                continue;
+            if (!strong_done)
+            {
+                strong = delta_strong(p + pos, bs);
+                strong_done = 1;
+            }
+            if (sigs[i].strong == strong)
+            {
+                match = i;
+                break;
+            }
+        }
+
+        if (match >= 0)
+        {
+            // 앞쪽 리터럴을 먼저 전송한 뒤 연속 블록은 하나의 COPY로 병합
+            if (pos > lit_start)
+            {
+                if (flush_COPY(uc, &copy_start, &copy_count) < 0 ||
+                    flush_literal(uc, p + lit_start, pos - lit_start) < 0)
+                    goto unmap;
+            }
+            if (copy_count > 0 && match != copy_start + copy_count)
+            {
+                if (flush_COPY(uc, &copy_start, &copy_count) < 0)
+                    goto unmap;
+            }
+            if (copy_count == 0)
+                copy_start = match;
+            copy_count++;
+            copied += bs;
+
+            pos += bs;
+            lit_start = pos;
+            if (pos + (long long)bs <= size)
+                delta_roll_init(&r, p + pos, bs);
             continue;
+        }
+
+        // 일치하지 않으면 한 바이트 이동
+        if (pos + (long long)bs < size)
+            delta_roll_rotate(&r, p[pos], p[pos + bs]);
+        pos++;
 
-        // send_DATA_chunk 실패 시 재접속 및 RESUME 전송
-        printf("[send-실패---재접속-요청]\n");
+        // 더 이상 일치에 쓰일 수 없는 리터럴은 미리 전송
+        if (pos - lit_start >= uc->chunk)
+        {
+            if (flush_COPY(uc, &copy_start, &copy_count) < 0 ||
+                flush_literal(uc, p + lit_start, pos - lit_start) < 0)
+                goto unmap;
+            lit_start = pos;
+        }
+    }
 
-        // 기존 소켓 닫기
+    // 남은 블록 참조와 꼬리 리터럴 전송
+    if (flush_COPY(uc, &copy_start, &copy_count) < 0 ||
+        flush_literal(uc, p + lit_start, size - lit_start) < 0)
+        goto unmap;
+
+    printf("DELTA -- 재사용 %lld bytes, 전송 %lld bytes\n", copied, size - copied);
+    trace_complete("DELTA", t0, "\"reused\":%lld,\"sent\":%lld", copied, size - copied);
+    ret = 0;
+
+unmap:
+    if (p)
+        munmap((void *)p, size);
+out:
+    free(sigs);
+    free(head);
+    free(next);
+    return ret;
+}
+
+// 서버가 받은 블록의 해시를 기록하고 상태 저장 (새로 끝난 블록이 있을 때만 파일에 씀)
+static void save_progress(UploadClient *uc)
+{
+    UploadState *st = uc->state;
+    if (!st)
+        return;
+
+    long long before = st->nsums;
+    st->offset = uc->offset;
+    state_hash_blocks(st, uc->fd, uc->offset);
+    if (st->nsums != before)
+        state_save(uc->state_dir, st);
+}
+
+// 파일 업로드 함수
+int upload_file(UploadClient *uc)
+{
+    while (1)
+    {
+        // 같은 호스트 연결이면 파일 디스크립터만 넘기고 서버가 직접 복사
+        if (uc->local && uc->pass_fd && uc->offset < uc->file_size && send_FILEFD(uc) < 0)
+        {
+            printf("[FILEFD-실패---DATA로-전송]\n");
+            uc->pass_fd = 0;
+            resume_server(uc);
+        }
+
+        // 파일의 끝까지 반복
+        while (uc->offset < uc->file_size)
+        {
+            // 이번에 보낼 청크 크기 (남은 크기와 -c 청크 중 작은 값)
+            long long n = uc->file_size - uc->offset;
+            if (n > uc->chunk)
+                n = uc->chunk;
+
+            // 데이터 청크 전송 (압축을 협상했으면 작업 풀이 압축한 청크 전송)
+            if ((uc->zip_ok ? send_DATA_zip(uc) : send_DATA_file(uc, n)) == 0)
+            {
+                save_progress(uc);
+                continue;
+            }
+
+            // send_DATA_file 실패 시 재접속 및 RESUME 전송
+            printf("[send-실패---재접속-요청]\n");
+            resume_server(uc);
+        }
+
+        // FIN 메시지 전송 (응답 전에 끊기면 다시 RESUME 후 FIN)
+        if (send_FIN(uc) == 0)
+            return 0;
+        printf("[FIN-실패---재접속-요청]\n");
+        resume_server(uc);
+    }
+}
+
+// 병렬 경로들이 나눠 가져가는 작업 목록 (구멍을 STRIPE 단위로 쪼갠 구간)
+typedef struct
+{
+    UploadClient *base;
+    Extent *stripes;
+    int stripe_cnt;
+    int next;
+    pthread_mutex_t lock;
+} StripeQueue;
+
+// 경로 하나의 상태
+typedef struct
+{
+    StripeQueue *q;
+    UploadClient uc;
+    int id;
+    long long sent;
+    int failed;
+} PathWorker;
+
+// 경로 스레드 - 남은 구간을 하나씩 가져가서 DATA <offset> <len> 으로 전송
+// 빠른 경로가 더 많은 구간을 가져가므로 경로 속도 차이가 자동으로 반영됨
+static void *path_worker(void *arg)
+{
+    PathWorker *w = arg;
+    UploadClient *uc = &w->uc;
+    char buf[CHUNK];
+
+    while (connect_server(uc) < 0)
+        sleep(1);
+    if (send_RESUME(uc) < 0)
+    {
+        w->failed = 1;
         close(uc->sd);
+        return NULL;
+    }
+
+    while (1)
+    {
+        pthread_mutex_lock(&w->q->lock);
+        int idx = w->q->next < w->q->stripe_cnt ? w->q->next++ : -1;
+        pthread_mutex_unlock(&w->q->lock);
+        if (idx < 0)
+            break;
 
-        // 서버에 재접속 시도
-        while (connect_server(uc) < 0)
+        long long pos = w->q->stripes[idx].start;
+        long long end = w->q->stripes[idx].end;
+        while (pos < end)
         {
-            // 접속 실패 시 1초 대기 후 재시도
-            perror("connect");
-            // 1초 대기
-            sleep(1);
+            int want = end - pos < CHUNK ? (int)(end - pos) : CHUNK;
+            int n = pread(uc->fd, buf, want, pos);
+            if (n <= 0)
+            {
+                w->failed = 1;
+                break;
+            }
+
+            // 실패 시 같은 경로로 재접속 후 같은 청크를 다시 전송 (위치 지정이라 중복 안전)
+            if (send_DATA_at(uc, pos, buf, n) < 0)
+            {
+                printf("[path %d] send 실패 --- 재접속\n", w->id);
+                reconnect_server(uc);
+                if (send_RESUME(uc) < 0)
+                {
+                    w->failed = 1;
+                    break;
+                }
+                continue;
+            }
+            pos += n;
+            w->sent += n;
         }
+    }
+
+    close(uc->sd);
+    return NULL;
+}
+
+// 병렬 경로 업로드 함수 - 구멍 목록을 여러 연결로 나눠서 동시에 채움
+int upload_parallel(UploadClient *uc)
+{
+    while (1)
+    {
+        // 서버가 아직 받지 못한 구간 조회
+        ExtentMap holes;
+        extent_init(&holes);
+        if (send_HOLES(uc, &holes) < 0)
+        {
+            extent_free(&holes);
+            return -1;
+        }
+        if (holes.n == 0)
+            break;
+
+        // 구멍을 STRIPE 단위 작업으로 분할
+        StripeQueue q;
+        memset(&q, 0, sizeof(q));
+        pthread_mutex_init(&q.lock, NULL);
+        for (int i = 0; i < holes.n; i++)
+            q.stripe_cnt += (holes.v[i].end - holes.v[i].start + STRIPE - 1) / STRIPE;
+        q.stripes = malloc(sizeof(Extent) * q.stripe_cnt);
+        if (!q.stripes)
+        {
+            extent_free(&holes);
+            return -1;
+        }
+        int k = 0;
+        for (int i = 0; i < holes.n; i++)
+        {
+            for (long long pos = holes.v[i].start; pos < holes.v[i].end; pos += STRIPE)
+            {
+                q.stripes[k].start = pos;
+                q.stripes[k].end = pos + STRIPE < holes.v[i].end ? pos + STRIPE : holes.v[i].end;
+                k++;
+            }
+        }
+        extent_free(&holes);
 
-        // 재접속 성공 메세지
-        printf("재접속 성공: %s:%d\n", uc->server_ip, uc->server_port);
+        // 경로별 스레드 시작 (경로 i는 -b로 지정한 i번째 주소에서 출발)
+        PathWorker workers[MAX_PATHS];
+        pthread_t tids[MAX_PATHS];
+        for (int i = 0; i < uc->paths; i++)
+        {
+            memset(&workers[i], 0, sizeof(workers[i]));
+            workers[i].q = &q;
+            workers[i].id = i;
+            workers[i].uc = *uc;
+            workers[i].uc.bind_ip = uc->bind_ips[i % (uc->bind_cnt > 0 ? uc->bind_cnt : 1)];
+            pthread_create(&tids[i], NULL, path_worker, &workers[i]);
+        }
 
-        // RESUME 메시지 전송
-        if (send_RESUME(uc) < 0)
+        int failed = 0;
+        for (int i = 0; i < uc->paths; i++)
+        {
+            pthread_join(tids[i], NULL);
+            printf("[path %d] %s sent=%lld bytes\n", i,
+                   workers[i].uc.bind_ip ? workers[i].uc.bind_ip : "-", workers[i].sent);
+            failed |= workers[i].failed;
+        }
+        free(q.stripes);
+        pthread_mutex_destroy(&q.lock);
+        if (failed)
             return -1;
-        printf("RESUME -- offset = %ld\n", uc->offset);
+
+        // 모든 구멍이 채워졌는지 다시 확인 후 종료
     }
 
-    // FIN 메시지 전송
     return send_FIN(uc);
 }
 
-// 메인 함수
-int main(int argc, char *argv[])
+// 원본이 바뀐 업로드 - 서버가 이미 받은 [0, offset) 중 해시가 달라진 블록과 해시가 없는 꼬리를 위치 지정 DATA로 다시 전송
+static int resend_changed(UploadClient *uc, const struct stat *sb)
 {
-    // 인자 개수 확인
-    if (argc != 5)
+    UploadState *st = uc->state;
+    long long have = uc->offset;
+    long long blocks = have / STATE_BLOCK < st->nsums ? have / STATE_BLOCK : st->nsums;
+
+    char *buf = malloc(STATE_BLOCK);
+    if (!buf)
+        return -1;
+
+    long long resent = 0;
+    for (long long pos = 0; pos < have;)
     {
-        printf("Usage: %s <IP> <port> <ClientID> <File>\n", argv[0]);
-        exit(1);
+        long long i = pos / STATE_BLOCK;
+        int n = have - pos < STATE_BLOCK ? (int)(have - pos) : STATE_BLOCK;
+        if (pread_all(uc->fd, buf, n, pos) < 0)
+        {
+            free(buf);
+            return -1;
+        }
+
+        // 해시가 있는 블록은 같으면 건너뜀 (다르면 새 해시로 교체)
+        if (i < blocks)
+        {
+            uint64_t h = delta_strong((unsigned char *)buf, n);
+            if (h == st->sums[i])
+            {
+                pos += n;
+                continue;
+            }
+            st->sums[i] = h;
+        }
+
+        // 위치 지정 쓰기라 끊겨서 다시 보내도 안전
+        while (send_DATA_at(uc, pos, buf, n) < 0)
+        {
+            printf("[send-실패---재접속-요청]\n");
+            resume_server(uc);
+        }
+        resent += n;
+        pos += n;
     }
+    free(buf);
 
-    // UploadClient 구조체 초기화
-    UploadClient uc;
-    uc.server_ip = argv[1];
-    uc.server_port = atoi(argv[2]);
-    strcpy(uc.client_id, argv[3]);
-    strcpy(uc.filename, argv[4]);
+    printf("[STATE] %s 원본 변경 -- 검사 %lld 블록, 다시 전송 %lld bytes\n", uc->filename, blocks, resent);
+    st->nsums = blocks;
+    st->offset = uc->offset;
+    state_set_source(st, sb);
+    state_save(uc->state_dir, st);
+    return 0;
+}
+
+// 델타 업로드 후 FIN (중간에 끊기면 재접속 후 처음부터 다시 재구성)
+static int upload_delta_FIN(UploadClient *uc)
+{
+    // 재구성 확인용 해시는 한 번만 계산 (-H로 이미 계산했으면 그대로 사용)
+    if (!uc->sha256[0] && hash_file(uc) < 0)
+    {
+        printf("파일 해시 계산 실패\n");
+        return -1;
+    }
+    while (upload_delta(uc) < 0)
+    {
+        printf("[delta-실패---재접속-요청]\n");
+        reconnect_server(uc);
+    }
+    if (send_FIN(uc) < 0)
+    {
+        printf("FIN 실패\n");
+        return -1;
+    }
+    return 0;
+}
 
+// 파일 하나 업로드 - 열기부터 FIN까지 (상태 디렉토리가 있으면 이전 진행 상황을 이어감)
+static int upload_one(UploadClient *uc, const char *source)
+{
     // 파일 열기
-    uc.fp = fopen(uc.filename, "rb");
-    if (!uc.fp)
+    uc->fd = open(source, O_RDONLY);
+    if (uc->fd < 0)
     {
-        printf("파일을 열 수 없음: %s\n", uc.filename);
-        exit(1);
+        printf("파일을 열 수 없음: %s\n", source);
+        return -1;
     }
 
-    // 파일 크기 구하기
-    fseek(uc.fp, 0, SEEK_END);
-    uc.file_size = ftell(uc.fp);
-    fseek(uc.fp, 0, SEEK_SET);
+    // 파일 크기 구하기 (4GB 이상도 그대로 표현되도록 64비트 off_t)
+    struct stat sb;
+    if (fstat(uc->fd, &sb) < 0)
+    {
+        perror("fstat");
+        close(uc->fd);
+        return -1;
+    }
+    uc->file_size = sb.st_size;
+
+    // 처음부터 끝까지 순서대로 읽는다고 알려 커널 미리 읽기 창을 키움
+    posix_fadvise(uc->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // 이전 상태 확인 (원본이 그대로면 해시를 다시 계산하지 않음)
+    UploadState st;
+    int changed = 0;
+    if (uc->state_dir)
+    {
+        if (state_load(uc->state_dir, uc->client_id, uc->filename, &st) < 0)
+            state_init(&st, uc->client_id, uc->filename, source, &sb);
+        else if (!(changed = state_changed(&st, &sb)) && st.done)
+        {
+            printf("[STATE] %s 이미 완료 (원본 변경 없음)\n", uc->filename);
+            state_free(&st);
+            close(uc->fd);
+            return 0;
+        }
+        snprintf(st.source, sizeof(st.source), "%s", source);
+        uc->state = &st;
+    }
+
+    // 같은 내용을 올리는 다른 호스트와 합칠 수 있게 파일 해시 계산 (실패하면 해시 없이 전송)
+    // 원본이 그대로면 상태 파일에 기록한 해시를 사용 (델타 업로드의 확인용 해시도 같음)
+    uc->sha256[0] = '\0';
+    if (uc->state && !changed && st.sha256[0] && (uc->hash || uc->delta))
+    {
+        memcpy(uc->sha256, st.sha256, sizeof(uc->sha256));
+        printf("[HASH ] %s sha256=%.16s... (상태 파일, 원본 변경 없음)\n", uc->filename, uc->sha256);
+    }
+    else if (uc->hash && !uc->delta && hash_file(uc) < 0)
+        uc->sha256[0] = '\0';
+
+    // 새로 계산한 해시는 바로 기록 (원본이 바뀌었으면 예전 해시를 버리고, 바뀐 원본 정보는 완료 때 기록)
+    if (uc->state && (changed || uc->sha256[0]) && strcmp(st.sha256, uc->sha256) != 0)
+    {
+        memcpy(st.sha256, uc->sha256, sizeof(st.sha256));
+        if (!changed)
+            state_save(uc->state_dir, &st);
+    }
 
     // 서버에 접속 시도
-    while (connect_server(&uc) < 0)
+    while (connect_server(uc) < 0)
         sleep(1);
 
-    // FIRST 메시지 전송
-    if (send_FIRST(&uc) < 0)
+    int ret;
+    if (uc->delta)
+    {
+        changed = 1;
+        ret = upload_delta_FIN(uc);
+    }
+    else if (send_FIRST(uc) < 0)
     {
         printf("FIRST 실패\n");
+        ret = -1;
+    }
+    else if (changed && uc->offset > uc->file_size)
+    {
+        // 서버에 있는 것보다 원본이 작아졌으면 위치 지정 쓰기로는 줄일 수 없으므로 델타 업로드로 재구성
+        printf("[STATE] %s 원본이 줄어듦 -- 델타 업로드\n", uc->filename);
+        ret = upload_delta_FIN(uc);
+    }
+    else
+    {
+        // 원본이 바뀌었으면 이미 보낸 부분부터 맞춘 뒤 이어서 전송
+        if (changed && resend_changed(uc, &sb) == 0)
+            changed = 0;
+
+        // 파일 업로드 시작 (병렬 경로 지정 시 구멍 단위로 나눠 전송)
+        if (uc->paths > 1)
+            ret = upload_parallel(uc);
+        else
+            ret = upload_file(uc);
+    }
+    readahead_stop(uc->ra);
+    uc->ra = NULL;
+    zpool_stop(uc->zp);
+    uc->zp = NULL;
+    if (uc->zip_raw > 0)
+        printf("[ZIP  ] %s 원본 %lld bytes -> 전송 %lld bytes\n", uc->filename, uc->zip_raw, uc->zip_sent);
+
+    // 완료 기록 (델타로 다시 만들었으면 해시도 처음부터 다시 계산)
+    if (uc->state)
+    {
+        if (ret == 0)
+        {
+            if (changed)
+                st.nsums = 0;
+            state_set_source(&st, &sb);
+            state_hash_blocks(&st, uc->fd, uc->file_size);
+            if (uc->sha256[0])
+                memcpy(st.sha256, uc->sha256, sizeof(st.sha256));
+            st.offset = uc->file_size;
+            st.done = 1;
+        }
+        state_save(uc->state_dir, &st);
+        state_free(&st);
+        uc->state = NULL;
+    }
+
+    // 파일 및 소켓 닫기
+    close(uc->fd);
+    close(uc->sd);
+    return ret;
+}
+
+// 여러 파일 업로드 대기열 (작업 스레드들이 앞에서부터 하나씩 가져감)
+typedef struct
+{
+    UploadClient *base;
+    char (*names)[256];
+    char (*sources)[512];
+    int cnt;
+    int next;
+    int failed;
+    pthread_mutex_t lock;
+} UploadQueue;
+
+// 대기열 작업 스레드 - 파일마다 독립된 연결로 업로드
+static void *queue_worker(void *arg)
+{
+    UploadQueue *q = arg;
+
+    while (1)
+    {
+        pthread_mutex_lock(&q->lock);
+        int idx = q->next < q->cnt ? q->next++ : -1;
+        pthread_mutex_unlock(&q->lock);
+        if (idx < 0)
+            break;
+
+        UploadClient uc = *q->base;
+        snprintf(uc.filename, sizeof(uc.filename), "%s", q->names[idx]);
+        int ret = upload_one(&uc, q->sources[idx]);
+        printf("[QUEUE] %s %s\n", uc.filename, ret == 0 ? "완료" : "실패");
+        fflush(stdout);
+        if (ret < 0)
+        {
+            pthread_mutex_lock(&q->lock);
+            q->failed++;
+            pthread_mutex_unlock(&q->lock);
+        }
+    }
+    return NULL;
+}
+
+// 대기열에 파일 추가 (이미 있는 이름이면 그 항목), 항목 번호 반환 (가득 차면 -1)
+static int queue_add(UploadQueue *q, const char *name, const char *source)
+{
+    // 명령 줄은 공백으로 인자를 나누므로 (FIRST <id> <file> ...) 공백이 들어간 이름은 서버에 보낼 수 없음
+    if (name[strcspn(name, " \t\r\n")] != '\0')
+    {
+        printf("파일 이름에 공백이 있어 전송할 수 없음 (이름을 바꿔서 다시 실행): %s\n", name);
+        q->failed++;
         return -1;
     }
+    for (int i = 0; i < q->cnt; i++)
+        if (strcmp(q->names[i], name) == 0)
+            return i;
+    if (q->cnt >= MAX_QUEUE)
+    {
+        printf("대기열이 가득 참 (최대 %d): %s\n", MAX_QUEUE, name);
+        return -1;
+    }
+    snprintf(q->names[q->cnt], 256, "%s", name);
+    snprintf(q->sources[q->cnt], 512, "%s", source);
+    return q->cnt++;
+}
+
+// 메인 함수
+int main(int argc, char *argv[])
+{
+    // UploadClient 구조체 초기화
+    UploadClient uc;
+    memset(&uc, 0, sizeof(uc));
+    uc.chunk = CHUNK;
+    uc.ahead = READ_AHEAD;
+
+    // 끊긴 연결에 쓰면 SIGPIPE로 종료되지 않고 오류를 받아 재접속하도록 무시
+    signal(SIGPIPE, SIG_IGN);
+
+    // 옵션 처리
+    char *trace_path = NULL;
+    int jobs = QUEUE_JOBS;
+    char *alt[MAX_ENDPOINTS];
+    int alt_cnt = 0;
+    int failover = FAILOVER_SEC;
+    char *list_prefix = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "dzHp:b:c:T:u:a:s:j:F:w:B:L:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            uc.delta = 1;
+            break;
+        case 'z':
+            uc.compress = 1;
+            break;
+        case 'H':
+            uc.hash = 1;
+            break;
+        case 'B':
+            tune_set_rate(atoll(optarg));
+            break;
+        case 'L':
+            list_prefix = optarg;
+            break;
+        case 'p':
+            uc.paths = atoi(optarg);
+            if (uc.paths < 1 || uc.paths > MAX_PATHS)
+                argc = 0;
+            break;
+        case 'c':
+            uc.chunk = atoll(optarg);
+            if (uc.chunk < 1 || uc.chunk > MAX_CHUNK_SIZE)
+                argc = 0;
+            break;
+        case 'T':
+            trace_path = optarg;
+            break;
+        case 'a':
+            uc.ahead = atoi(optarg);
+            if (uc.ahead < 0 || uc.ahead > 64)
+                argc = 0;
+            break;
+        case 'u':
+            uc.unix_path = optarg;
+            uc.pass_fd = 1;
+            break;
+        case 'b':
+            if (uc.bind_cnt < MAX_PATHS)
+                uc.bind_ips[uc.bind_cnt++] = optarg;
+            break;
+        case 's':
+            uc.state_dir = optarg;
+            break;
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs < 1 || jobs > MAX_JOBS)
+                argc = 0;
+            break;
+        case 'F':
+            if (alt_cnt < MAX_ENDPOINTS - 1)
+                alt[alt_cnt++] = optarg;
+            break;
+        case 'w':
+            failover = atoi(optarg);
+            if (failover < 1)
+                argc = 0;
+            break;
+        default:
+            argc = 0;
+            break;
+        }
+    }
 
-    // 파일 업로드 시작
-    upload_file(&uc);
+    // 인자 개수 확인 (상태 디렉토리가 있거나 목록 조회면 파일 없이 실행 가능)
+    if (argc - optind < 4 && !((uc.state_dir || list_prefix) && argc - optind == 3))
+    {
+        printf("Usage: %s [-d] [-z] [-H] [-c chunk] [-a depth] [-p paths] [-b local_ip]... [-T trace.json] [-u socket_path] [-s state_dir] [-j jobs] [-F ip:port]... [-w sec] [-B bytes_per_sec] [-L prefix] <IP> <port> <ClientID> <File>...\n", argv[0]);
+        printf("  -d  서버에 있는 기존 파일과의 차이만 전송 (델타 업로드)\n");
+        printf("  -z  청크를 압축해서 전송 (서버가 지원할 때만, 줄지 않는 청크는 원본 전송)\n");
+        printf("  -H  파일 전체의 sha256을 알려 서버가 같은 내용의 업로드와 합치게 함 (서버 -H)\n");
+        printf("  -c  DATA 한 청크 크기 (bytes, 기본 %d, 최대 %lld)\n", CHUNK, MAX_CHUNK_SIZE);
+        printf("  -a  미리 읽어 두는 %d KB 버퍼 수 (기본 %d, 0: 미리 읽지 않음)\n", SEND_BUF / 1024, READ_AHEAD);
+        printf("  -p  여러 연결로 빈 구간을 나눠 동시에 전송 (최대 %d)\n", MAX_PATHS);
+        printf("  -b  경로별 출발지 주소 (여러 번 지정 시 경로마다 번갈아 사용)\n");
+        printf("  -T  FIRST/RESUME/DATA/재접속/FIN 타임라인을 Chrome/Perfetto 트레이스(JSON)로 기록\n");
+        printf("  -u  같은 호스트 서버의 유닉스 도메인 소켓으로 접속해 파일 디스크립터를 넘김 (실패 시 IP:port)\n");
+        printf("  -s  업로드 상태를 기록할 디렉토리 (다시 실행하면 끝나지 않은 업로드를 이어서 전송, <File> 생략 가능)\n");
+        printf("  -j  동시에 업로드할 파일 수 (기본 %d, 최대 %d)\n", QUEUE_JOBS, MAX_JOBS);
+        printf("  -F  같은 저장소를 공유/복제하는 대체 서버 (최대 %d개, 기본 서버가 계속 실패하면 옮겨서 RESUME)\n", MAX_ENDPOINTS - 1);
+        printf("  -B  소켓 버퍼를 정할 목표 대역폭 (bytes/s, 기본 %lld: 버퍼 = 대역폭 x 접속 때 잰 RTT)\n", TUNE_DEFAULT_RATE);
+        printf("  -L  업로드하지 않고 서버에 완료된 이 ID의 업로드 중 prefix로 시작하는 것을 출력 (\"\": 전체)\n");
+        printf("  -w  대체 서버로 옮기기 전까지 기본 서버 실패를 기다리는 시간 (초, 기본 %d)\n", FAILOVER_SEC);
+        exit(1);
+    }
 
-    // 파일 및 소켓 닫기
-    fclose(uc.fp);
-    close(uc.sd);
-    return 0;
+    // 서버 목록: 명령행의 서버가 기본, -F 로 지정한 서버가 대체
+    if (endpoint_add(argv[optind], atoi(argv[optind + 1])) < 0)
+    {
+        printf("잘못된 서버 주소: %s %s\n", argv[optind], argv[optind + 1]);
+        exit(1);
+    }
+    for (int i = 0; i < alt_cnt; i++)
+    {
+        if (endpoint_parse(alt[i]) < 0)
+        {
+            printf("잘못된 대체 서버 주소: %s\n", alt[i]);
+            exit(1);
+        }
+    }
+    endpoint_set_threshold(failover * 1000LL);
+    snprintf(uc.client_id, sizeof(uc.client_id), "%s", argv[optind + 2]);
+
+    // 목록 조회 (-L)
+    if (list_prefix)
+        return list_uploads(&uc, list_prefix) < 0 ? 1 : 0;
+
+    // 트레이스 파일 열기 (프로세스 이름에 클라이언트 ID 표시)
+    if (trace_path)
+    {
+        char name[96];
+        snprintf(name, sizeof(name), "client %s", uc.client_id);
+        if (trace_open(trace_path, name) < 0)
+        {
+            perror(trace_path);
+            exit(1);
+        }
+    }
+
+    // 대기열 구성: 명령행의 파일 + 상태 디렉토리에 남은 같은 ID의 끝나지 않은 업로드
+    UploadQueue q;
+    memset(&q, 0, sizeof(q));
+    pthread_mutex_init(&q.lock, NULL);
+    q.base = &uc;
+    q.names = malloc(sizeof(*q.names) * MAX_QUEUE);
+    q.sources = malloc(sizeof(*q.sources) * MAX_QUEUE);
+    if (!q.names || !q.sources)
+    {
+        perror("malloc");
+        exit(1);
+    }
+    if (uc.state_dir)
+        mkdir(uc.state_dir, 0755);
+
+    for (int i = optind + 3; i < argc; i++)
+    {
+        // 다시 실행할 때 작업 디렉토리가 달라도 찾을 수 있도록 절대 경로로 기록
+        char *real = realpath(argv[i], NULL);
+        int idx = queue_add(&q, argv[i], real ? real : argv[i]);
+        free(real);
+
+        // 새 파일은 시작 전에 상태를 만들어 두어 전송 전에 죽어도 대기열에 남게 함
+        UploadState st;
+        struct stat sb;
+        if (!uc.state_dir || idx < 0)
+            continue;
+        if (state_load(uc.state_dir, uc.client_id, argv[i], &st) == 0)
+            state_free(&st);
+        else if (stat(q.sources[idx], &sb) == 0)
+        {
+            state_init(&st, uc.client_id, argv[i], q.sources[idx], &sb);
+            state_save(uc.state_dir, &st);
+        }
+    }
+    if (uc.state_dir)
+    {
+        char (*left)[256] = malloc(sizeof(*left) * MAX_QUEUE);
+        int n = left ? state_list(uc.state_dir, uc.client_id, left, MAX_QUEUE) : 0;
+        for (int i = 0; i < n; i++)
+        {
+            UploadState st;
+            if (state_load(uc.state_dir, uc.client_id, left[i], &st) < 0)
+                continue;
+            queue_add(&q, st.filename, st.source);
+            state_free(&st);
+        }
+        free(left);
+        printf("[QUEUE] 업로드 %d개 (동시 %d개)\n", q.cnt, q.cnt < jobs ? q.cnt : jobs);
+    }
+
+    // 파일 하나면 현재 스레드에서, 여러 개면 작업 스레드들이 나눠서 업로드
+    if (q.cnt == 1)
+    {
+        snprintf(uc.filename, sizeof(uc.filename), "%s", q.names[0]);
+        q.failed = upload_one(&uc, q.sources[0]) < 0;
+    }
+    else
+    {
+        pthread_t tids[MAX_JOBS];
+        int n = q.cnt < jobs ? q.cnt : jobs;
+        for (int i = 0; i < n; i++)
+            pthread_create(&tids[i], NULL, queue_worker, &q);
+        for (int i = 0; i < n; i++)
+            pthread_join(tids[i], NULL);
+    }
+
+    free(q.names);
+    free(q.sources);
+    pthread_mutex_destroy(&q.lock);
+    return q.failed ? 1 : 0;
 }
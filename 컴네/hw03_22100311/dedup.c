@@ -0,0 +1,303 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "dedup.h"
+#include "sha256.h"
+#include "filetable.h"
+#include "netio.h"
+
+// 분리할 때 복사하는 단위
+#define UNSHARE_BUF (1024 * 1024)
+
+// 대표 상태
+#define FLIGHT_ACTIVE 0
+#define FLIGHT_DONE 1   // 완료 (완료 기록으로 연결 시도)
+#define FLIGHT_FAILED 2 // 대표가 끊김 (기다리던 연결 하나가 이어받음)
+
+struct DedupFlight
+{
+    char hash[SHA256_HEX + 1];
+    long long size;
+    long long progress; // 대표가 받은 0부터 연속된 끝
+    time_t touched;     // 마지막으로 진행한 시각
+    int state;
+    int refs; // 대표 1 + 기다리는 연결 수 (0이 되면 해제)
+    struct DedupFlight *next;
+};
+
+// 받는 중인 업로드 목록, 상태가 바뀌면 기다리는 연결을 모두 깨움
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t changed = PTHREAD_COND_INITIALIZER;
+static DedupFlight *flights = NULL;
+
+// 완료 기록 디렉토리 생성
+int dedup_open(void)
+{
+    if (mkdir(DEDUP_DIR, 0755) < 0 && errno != EEXIST)
+        return -1;
+    return 0;
+}
+
+// 같은 해시와 크기로 받는 중인 업로드 찾기
+static DedupFlight *flight_find(const char *hash, long long size)
+{
+    for (DedupFlight *f = flights; f; f = f->next)
+        if (f->size == size && strcmp(f->hash, hash) == 0)
+            return f;
+    return NULL;
+}
+
+// 목록에서 빼기 (완료되거나 끊긴 대표는 다시 찾지 않음)
+static void flight_unlink(DedupFlight *f)
+{
+    for (DedupFlight **pp = &flights; *pp; pp = &(*pp)->next)
+        if (*pp == f)
+        {
+            *pp = f->next;
+            return;
+        }
+}
+
+// 참조 해제 (lock 잡은 상태)
+static void flight_put(DedupFlight *f)
+{
+    if (--f->refs == 0)
+        free(f);
+}
+
+// 기록한 뒤 파일이 바뀌지 않았는지 (크기, inode, 수정 시각)
+static int unchanged(const char *path, long long size, unsigned long long ino, long long mtime_ns)
+{
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISREG(st.st_mode) && st.st_size == size &&
+           (unsigned long long)st.st_ino == ino &&
+           st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec == mtime_ns;
+}
+
+// 완료 기록에 있는 같은 내용의 파일을 path에 하드 링크 (연결했으면 1)
+// 기록한 뒤 파일이 바뀌었거나(크기, inode, 수정 시각) 다른 연결이 쓰는 중이면 연결하지 않음
+static int link_completed(const char *hash, long long size, const char *path)
+{
+    char rec[300], src[512];
+    snprintf(rec, sizeof(rec), "%s/%s", DEDUP_DIR, hash);
+    FILE *fp = fopen(rec, "r");
+    if (!fp)
+        return 0;
+    long long rsize, mtime_ns;
+    unsigned long long ino;
+    int n = fscanf(fp, "%511s %lld %llu %lld", src, &rsize, &ino, &mtime_ns);
+    fclose(fp);
+    if (n != 4 || rsize != size || strcmp(src, path) == 0)
+        return 0;
+
+    int created;
+    UploadFile *uf = filetable_acquire(src, &created);
+    if (!uf)
+        return 0;
+    if (created)
+        pthread_mutex_unlock(&uf->lock);
+
+    int linked = 0;
+    if (created && unchanged(src, size, ino, mtime_ns))
+        linked = link(src, path) == 0;
+    filetable_release(uf);
+    return linked;
+}
+
+// 완료된 업로드를 해시 이름으로 기록 (임시 파일에 쓴 뒤 rename)
+static void record_completed(const char *hash, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+        return;
+
+    char rec[300], tmp[310];
+    snprintf(rec, sizeof(rec), "%s/%s", DEDUP_DIR, hash);
+    snprintf(tmp, sizeof(tmp), "%s/.%s.tmp", DEDUP_DIR, hash);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp)
+        return;
+    fprintf(fp, "%s %lld %llu %lld\n", path, (long long)st.st_size, (unsigned long long)st.st_ino,
+            st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec);
+    if (fclose(fp) != 0 || rename(tmp, rec) < 0)
+        unlink(tmp);
+}
+
+// 대표가 끝날 때까지 DEDUP_WAIT_SEC마다 진행 상황을 보내며 기다림 (lock 잡은 상태로 호출하고 반환)
+// (대표가 끝났으면 0, 멈췄으면 1, 연결이 끊기면 -1)
+static int flight_wait(DedupFlight *f, int sd, void (*alive)(void *), void *arg)
+{
+    while (f->state == FLIGHT_ACTIVE)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += DEDUP_WAIT_SEC;
+        pthread_cond_timedwait(&changed, &lock, &ts);
+        if (f->state != FLIGHT_ACTIVE)
+            break;
+        if (time(NULL) - f->touched > DEDUP_STALL_SEC)
+            return 1;
+
+        // 소켓 쓰기는 잠금 밖에서
+        char msg[64];
+        int len = snprintf(msg, sizeof(msg), "WAIT %lld %lld\n", f->progress, f->size);
+        pthread_mutex_unlock(&lock);
+        int ret = write_all(sd, msg, len);
+        if (ret == 0 && alive)
+            alive(arg);
+        pthread_mutex_lock(&lock);
+        if (ret < 0)
+            return -1;
+    }
+    return 0;
+}
+
+// 같은 해시의 업로드에 합류 - 완료 기록이 있으면 연결, 받는 중이면 기다림, 둘 다 아니면 대표로 등록
+int dedup_join(const char *hash, long long size, const char *path, int sd,
+               void (*alive)(void *), void *arg, DedupFlight **lead)
+{
+    *lead = NULL;
+    pthread_mutex_lock(&lock);
+    while (1)
+    {
+        DedupFlight *f = flight_find(hash, size);
+        if (!f)
+        {
+            // 완료 기록 확인과 대표 등록을 같은 잠금 안에서 해서 동시에 두 대표가 생기지 않음
+            int linked = link_completed(hash, size, path);
+            if (!linked)
+            {
+                f = calloc(1, sizeof(DedupFlight));
+                if (f)
+                {
+                    strcpy(f->hash, hash);
+                    f->size = size;
+                    f->touched = time(NULL);
+                    f->refs = 1;
+                    f->next = flights;
+                    flights = f;
+                }
+                *lead = f;
+            }
+            pthread_mutex_unlock(&lock);
+            return linked;
+        }
+
+        f->refs++;
+        int r = flight_wait(f, sd, alive, arg);
+        int state = f->state;
+        flight_put(f);
+        if (r != 0)
+        {
+            // 끊겼거나 대표가 멈췄으면 기다리지 않고 직접 받음
+            pthread_mutex_unlock(&lock);
+            return r < 0 ? -1 : 0;
+        }
+        if (state == FLIGHT_DONE)
+        {
+            // 완료 기록이 없으면 (검증 실패, 팩/샤드로 옮겨짐) 각자 직접 받음
+            int linked = link_completed(hash, size, path);
+            pthread_mutex_unlock(&lock);
+            return linked;
+        }
+        // 대표가 끊겼으면 다시 찾아서 먼저 깬 연결이 대표를 이어받음
+    }
+}
+
+// 대표의 진행 상황 갱신
+void dedup_progress(DedupFlight *f, long long offset)
+{
+    pthread_mutex_lock(&lock);
+    if (offset > f->progress)
+    {
+        f->progress = offset;
+        f->touched = time(NULL);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+// 대표 종료 - 완료 기록을 남긴 뒤 기다리던 연결을 모두 깨움
+void dedup_done(DedupFlight *f, const char *path, int ok)
+{
+    if (!f)
+        return;
+    pthread_mutex_lock(&lock);
+    if (ok)
+        record_completed(f->hash, path);
+    f->state = ok ? FLIGHT_DONE : FLIGHT_FAILED;
+    flight_unlink(f);
+    pthread_cond_broadcast(&changed);
+    flight_put(f);
+    pthread_mutex_unlock(&lock);
+}
+
+// DEDUP_DIR 의 <sha256> 기록을 하나씩 읽어서 아직 그 내용 그대로인 파일만 전달
+void dedup_foreach(void (*cb)(const char *hash, const char *path, void *arg), void *arg)
+{
+    DIR *d = opendir(DEDUP_DIR);
+    if (!d)
+        return;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        if (!sha256_valid_hex(e->d_name))
+            continue;
+        char rec[300], src[512];
+        snprintf(rec, sizeof(rec), "%s/%s", DEDUP_DIR, e->d_name);
+        FILE *fp = fopen(rec, "r");
+        if (!fp)
+            continue;
+        long long size, mtime_ns;
+        unsigned long long ino;
+        int n = fscanf(fp, "%511s %lld %llu %lld", src, &size, &ino, &mtime_ns);
+        fclose(fp);
+        if (n == 4 && unchanged(src, size, ino, mtime_ns))
+            cb(e->d_name, src, arg);
+    }
+    closedir(d);
+}
+
+// 링크 수가 2 이상이면 같은 디렉토리의 임시 파일로 복사한 뒤 rename으로 교체
+int dedup_unshare(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) < 0 || st.st_nlink < 2)
+        return 0;
+
+    char tmp[600];
+    const char *slash = strrchr(path, '/');
+    if (slash)
+        snprintf(tmp, sizeof(tmp), "%.*s/.%s.unshare.tmp", (int)(slash - path), path, slash + 1);
+    else
+        snprintf(tmp, sizeof(tmp), ".%s.unshare.tmp", path);
+
+    int in = open(path, O_RDONLY);
+    int out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    char *buf = malloc(UNSHARE_BUF);
+    int ret = in >= 0 && out >= 0 && buf ? 0 : -1;
+    for (long long off = 0; ret == 0 && off < st.st_size;)
+    {
+        ssize_t n = pread(in, buf, UNSHARE_BUF, off);
+        if (n <= 0 || pwrite_all(out, buf, n, off) < 0)
+            ret = -1;
+        off += n;
+    }
+    free(buf);
+    if (in >= 0)
+        close(in);
+    if (out >= 0 && close(out) < 0)
+        ret = -1;
+    if (ret == 0 && rename(tmp, path) < 0)
+        ret = -1;
+    if (ret < 0)
+        unlink(tmp);
+    return ret;
+}
@@ -0,0 +1,43 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+// 같은 내용의 업로드 합치기 (-H): 배포 때 여러 호스트가 같은 파일을 동시에 올리는 경우
+// 클라이언트가 FIRST/RESUME 에 파일 전체의 sha256 을 붙이면
+//   - 같은 해시로 완료된 업로드가 있으면 바로 하드 링크로 연결하고 끝까지 받은 것으로 ACK
+//   - 같은 해시를 받는 중인 업로드(대표)가 있으면 그 진행 상황을 "WAIT <offset> <size>" 로 보내며 기다렸다가
+//     대표가 끝나면 연결, 대표가 끊기거나 멈추면 기다리던 연결 하나가 대표를 이어받아 직접 받음
+// 대표의 해시는 서버가 받은 내용으로 다시 계산해서 맞을 때만 기록 (클라이언트가 보낸 값은 믿지 않음)
+//   ./.hashes/<sha256>   완료된 업로드 경로, 크기, inode
+#define DEDUP_DIR "./.hashes"
+
+// 기다리는 연결에 진행 상황을 보내는 간격 (초)
+#define DEDUP_WAIT_SEC 1
+
+// 대표의 진행이 이 시간(초) 동안 멈추면 기다리던 연결이 직접 받음
+#define DEDUP_STALL_SEC 30
+
+// 같은 해시를 받는 중인 업로드
+typedef struct DedupFlight DedupFlight;
+
+// 완료 기록 디렉토리 생성 (성공 0, 실패 -1)
+int dedup_open(void);
+
+// 비어 있는 path를 같은 해시(hash)와 크기의 업로드에 합류시킴 - sd로 WAIT 진행 상황을 보내고 보낼 때마다 alive(arg) 호출
+// (path에 연결했으면 1, 직접 받아야 하면 0, 기다리는 중에 연결이 끊기면 -1)
+// 0 이고 *lead 가 NULL이 아니면 이 연결이 대표 - 업로드가 끝나거나 끊기면 dedup_done 호출
+int dedup_join(const char *hash, long long size, const char *path, int sd,
+               void (*alive)(void *), void *arg, DedupFlight **lead);
+
+// 대표가 받은 0부터 연속된 끝 (기다리는 연결에 보낼 진행 상황)
+void dedup_progress(DedupFlight *f, long long offset);
+
+// 대표 업로드 종료 - ok면 path를 완료 기록에 남기고 기다리던 연결을 연결, 아니면 다음 연결이 이어받음
+void dedup_done(DedupFlight *f, const char *path, int ok);
+
+// 완료 기록마다 cb(해시, 경로, arg) 호출 - 기록한 뒤 바뀌지 않은 파일만 (카탈로그 다시 만들기)
+void dedup_foreach(void (*cb)(const char *hash, const char *path, void *arg), void *arg);
+
+// 하드 링크로 다른 업로드와 공유하는 파일이면 쓰기 전에 자기 사본으로 분리 (성공 0, 실패 -1)
+int dedup_unshare(const char *path);
+
+#endif
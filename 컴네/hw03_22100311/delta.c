@@ -0,0 +1,73 @@
+#include "delta.h"
+
+// 기존 파일 크기에 맞는 블록 크기 계산
+// 대략 sqrt(file_size)를 2의 거듭제곱으로 올림하고 범위를 제한
+uint32_t delta_block_size(long long file_size)
+{
+    uint32_t bs = DELTA_MIN_BLOCK;
+
+    while (bs < DELTA_MAX_BLOCK && (long long)bs * bs < file_size)
+        bs <<= 1;
+    return bs;
+}
+
+// 블록 전체로 롤링 체크섬 초기화
+void delta_roll_init(DeltaRoll *r, const unsigned char *p, size_t len)
+{
+    uint32_t a = 0, b = 0;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        a += p[i];
+        b += (uint32_t)(len - i) * p[i];
+    }
+    r->a = a & 0xffff;
+    r->b = b & 0xffff;
+    r->len = len;
+}
+
+// 윈도우를 한 바이트 이동
+void delta_roll_rotate(DeltaRoll *r, unsigned char out, unsigned char in)
+{
+    r->a = (r->a - out + in) & 0xffff;
+    r->b = (r->b - (uint32_t)r->len * out + r->a) & 0xffff;
+}
+
+// 현재 윈도우의 weak 체크섬
+uint32_t delta_roll_value(const DeltaRoll *r)
+{
+    return r->a | (r->b << 16);
+}
+
+// 블록의 strong 해시 (64비트 FNV-1a)
+uint64_t delta_strong(const unsigned char *p, size_t len)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// 서명 레코드 직렬화 (빅 엔디언)
+void delta_sig_pack(const DeltaSig *sig, unsigned char *out)
+{
+    for (int i = 0; i < 4; i++)
+        out[i] = (unsigned char)(sig->weak >> (24 - 8 * i));
+    for (int i = 0; i < 8; i++)
+        out[4 + i] = (unsigned char)(sig->strong >> (56 - 8 * i));
+}
+
+// 서명 레코드 역직렬화
+void delta_sig_unpack(const unsigned char *in, DeltaSig *sig)
+{
+    sig->weak = 0;
+    sig->strong = 0;
+    for (int i = 0; i < 4; i++)
+        sig->weak = (sig->weak << 8) | in[i];
+    for (int i = 0; i < 8; i++)
+        sig->strong = (sig->strong << 8) | in[4 + i];
+}
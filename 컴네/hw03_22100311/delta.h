@@ -0,0 +1,48 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 블록 크기 범위 (파일 크기의 제곱근 근처에서 선택)
+#define DELTA_MIN_BLOCK 2048
+#define DELTA_MAX_BLOCK (128 * 1024)
+
+// 서명 레코드 1개의 전송 크기: weak 4바이트 + strong 8바이트 (네트워크 바이트 순서)
+#define DELTA_SIG_LEN 12
+
+// 블록 하나의 서명
+typedef struct
+{
+    uint32_t weak;
+    uint64_t strong;
+} DeltaSig;
+
+// rsync 방식의 롤링 체크섬 상태
+typedef struct
+{
+    uint32_t a;
+    uint32_t b;
+    size_t len;
+} DeltaRoll;
+
+// 기존 파일 크기에 맞는 블록 크기 계산
+uint32_t delta_block_size(long long file_size);
+
+// 블록 전체로 롤링 체크섬 초기화
+void delta_roll_init(DeltaRoll *r, const unsigned char *p, size_t len);
+
+// 윈도우를 한 바이트 이동 (out: 빠지는 바이트, in: 들어오는 바이트)
+void delta_roll_rotate(DeltaRoll *r, unsigned char out, unsigned char in);
+
+// 현재 윈도우의 weak 체크섬
+uint32_t delta_roll_value(const DeltaRoll *r);
+
+// 블록의 strong 해시 (64비트 FNV-1a)
+uint64_t delta_strong(const unsigned char *p, size_t len);
+
+// 서명 레코드 직렬화 / 역직렬화
+void delta_sig_pack(const DeltaSig *sig, unsigned char *out);
+void delta_sig_unpack(const unsigned char *in, DeltaSig *sig);
+
+#endif
@@ -0,0 +1,599 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "netio.h"
+#include "journal.h"
+#include "rs.h"
+#include "ecstore.h"
+#include "filetable.h"
+#include "catalog.h"
+
+#define SHARD_MAGIC 0x48534345U // "ECSH"
+
+// 샤드 파일 헤더 (뒤에 스트라이프 수 x EC_UNIT 바이트)
+typedef struct
+{
+    uint32_t magic;
+    uint16_t k;
+    uint16_t m;
+    uint16_t index; // 샤드 번호 (k 미만: 데이터, 나머지: 패리티)
+    uint16_t pad;
+    uint32_t unit;
+    uint64_t size;    // 원본 파일 크기
+    uint32_t crc;     // 샤드 데이터 CRC32
+    uint32_t hdr_crc; // 위 필드들의 CRC32
+} ShardHeader;
+
+static int ec_k = 0, ec_m = 0;
+static char *ec_dirs[EC_MAX_DIRS];
+
+// 봉인 대기 중인 업로드 (원형 큐, 스레드 하나가 차례로 처리)
+typedef struct
+{
+    char client_id[64];
+    char filename[256];
+} EcJob;
+
+static EcJob ec_queue[EC_QUEUE_LEN];
+static int ec_head = 0, ec_count = 0;
+static pthread_mutex_t ec_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ec_cond = PTHREAD_COND_INITIALIZER;
+
+// 샤드 하나를 맡은 스레드의 작업 (배치마다 모든 샤드를 동시에 씀)
+typedef struct
+{
+    int fd;
+    int index;
+    const uint8_t *buf; // 데이터 샤드: 원본 배치 전체, 패리티 샤드: 이 샤드의 패리티 버퍼
+    long long stripe;   // 배치 첫 스트라이프 번호
+    int nstripes;
+    long long size;     // 원본 크기 (헤더에 기록)
+    uint32_t crc;
+    int err;
+} ShardWriter;
+
+// 밀리초 시각
+static long long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+// 헤더 CRC 계산
+static uint32_t header_crc(const ShardHeader *h)
+{
+    return crc32_update(0, h, offsetof(ShardHeader, hdr_crc));
+}
+
+// 샤드 파일 경로
+static void shard_path(char *out, size_t size, int index, const char *id, const char *file, int tmp)
+{
+    if (tmp)
+        snprintf(out, size, "%s/%s/.%s.ec.tmp", ec_dirs[index], id, file);
+    else
+        snprintf(out, size, "%s/%s/%s.ec", ec_dirs[index], id, file);
+}
+
+// 업로드 하나 봉인 - 파일 lock을 잡은 채로 저장해서 이어받기(open_upload)와 엇갈리지 않게 함
+// 다른 연결이 이미 열었거나 받다 만 업로드(저널 있음)면 그 업로드의 FIN이 다시 등록하므로 건너뜀
+static void seal_one(const char *client_id, const char *filename)
+{
+    char path[400], journal[400];
+    snprintf(path, sizeof(path), "./%s/%s", client_id, filename);
+    snprintf(journal, sizeof(journal), "./%s/.%s.journal", client_id, filename);
+
+    int created;
+    UploadFile *f = filetable_acquire(path, &created);
+    if (!f)
+        return;
+    if (created)
+    {
+        struct stat st;
+        if (stat(journal, &st) < 0 && ec_finish(client_id, filename, path) == 1)
+            catalog_set_state(client_id, filename, CATALOG_EC);
+        pthread_mutex_unlock(&f->lock);
+    }
+    filetable_release(f);
+}
+
+// 봉인 스레드 - 큐에서 하나씩 꺼내 저장
+static void *seal_worker(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&ec_lock);
+        while (ec_count == 0)
+            pthread_cond_wait(&ec_cond, &ec_lock);
+        EcJob job = ec_queue[ec_head];
+        ec_head = (ec_head + 1) % EC_QUEUE_LEN;
+        ec_count--;
+        pthread_mutex_unlock(&ec_lock);
+
+        seal_one(job.client_id, job.filename);
+    }
+    return NULL;
+}
+
+// 소거 부호 저장 시작
+int ec_open(const char *spec)
+{
+    int k, m, used;
+    if (sscanf(spec, "%d+%d:%n", &k, &m, &used) != 2 || k < 1 || m < 1 || k + m > EC_MAX_DIRS)
+        return -1;
+
+    // 디렉토리 목록 (개수가 k+m과 같아야 함)
+    char *list = strdup(spec + used);
+    int n = 0;
+    for (char *save = NULL, *d = strtok_r(list, ",", &save); d; d = strtok_r(NULL, ",", &save))
+    {
+        if (n == k + m)
+        {
+            n++;
+            break;
+        }
+        ec_dirs[n++] = d;
+    }
+    if (n != k + m)
+    {
+        free(list);
+        return -1;
+    }
+    for (int i = 0; i < n; i++)
+        mkdir(ec_dirs[i], 0777);
+
+    ec_k = k;
+    ec_m = m;
+    printf("[EC   ] k=%d m=%d unit=%d kernel=%s dirs=%s\n", k, m, EC_UNIT, rs_kernel(), spec + used);
+
+    pthread_t t;
+    pthread_create(&t, NULL, seal_worker, NULL);
+    pthread_detach(t);
+    return 0;
+}
+
+// 봉인 큐에 등록 (가득 차면 기다리지 않고 이 스레드에서 바로 저장)
+void ec_enqueue(const char *client_id, const char *filename)
+{
+    if (ec_k == 0)
+        return;
+
+    pthread_mutex_lock(&ec_lock);
+    int queued = ec_count < EC_QUEUE_LEN;
+    if (queued)
+    {
+        EcJob *job = &ec_queue[(ec_head + ec_count) % EC_QUEUE_LEN];
+        snprintf(job->client_id, sizeof(job->client_id), "%s", client_id);
+        snprintf(job->filename, sizeof(job->filename), "%s", filename);
+        ec_count++;
+        pthread_cond_signal(&ec_cond);
+    }
+    pthread_mutex_unlock(&ec_lock);
+
+    if (!queued)
+        seal_one(client_id, filename);
+}
+
+// 샤드 스레드 - 배치 안의 스트라이프마다 자기 조각을 쓰면서 CRC 누적
+static void *shard_write(void *arg)
+{
+    ShardWriter *w = arg;
+    for (int t = 0; t < w->nstripes && !w->err; t++)
+    {
+        const uint8_t *unit = w->index < ec_k ? w->buf + ((size_t)t * ec_k + w->index) * EC_UNIT
+                                              : w->buf + (size_t)t * EC_UNIT;
+        w->crc = crc32_update(w->crc, unit, EC_UNIT);
+        if (pwrite_all(w->fd, unit, EC_UNIT, sizeof(ShardHeader) + (w->stripe + t) * EC_UNIT) < 0)
+            w->err = 1;
+    }
+    return NULL;
+}
+
+// 샤드 스레드 - 헤더를 쓰고 디스크에 반영 (원본을 지우기 전)
+static void *shard_seal(void *arg)
+{
+    ShardWriter *w = arg;
+    ShardHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SHARD_MAGIC;
+    h.k = ec_k;
+    h.m = ec_m;
+    h.index = w->index;
+    h.unit = EC_UNIT;
+    h.size = w->size;
+    h.crc = w->crc;
+    h.hdr_crc = header_crc(&h);
+    if (pwrite_all(w->fd, &h, sizeof(h), 0) < 0 || fsync(w->fd) < 0)
+        w->err = 1;
+    return NULL;
+}
+
+// 모든 샤드 스레드를 동시에 실행하고 기다림 (하나라도 실패하면 -1)
+static int run_writers(ShardWriter *w, int n, void *(*fn)(void *))
+{
+    pthread_t t[EC_MAX_DIRS];
+    int started[EC_MAX_DIRS];
+    for (int i = 0; i < n; i++)
+    {
+        started[i] = pthread_create(&t[i], NULL, fn, &w[i]) == 0;
+        if (!started[i])
+            fn(&w[i]);
+    }
+    int ret = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (started[i])
+            pthread_join(t[i], NULL);
+        if (w[i].err)
+            ret = -1;
+    }
+    return ret;
+}
+
+// 완료된 업로드를 샤드로 나눠 저장
+int ec_finish(const char *client_id, const char *filename, const char *path)
+{
+    if (ec_k == 0)
+        return 0;
+
+    int in = open(path, O_RDONLY);
+    struct stat st;
+    if (in < 0 || fstat(in, &st) < 0)
+    {
+        if (in >= 0)
+            close(in);
+        return 0;
+    }
+
+    long long t0 = now_ms();
+    int n = ec_k + ec_m;
+    long long size = st.st_size;
+    size_t stripe_bytes = (size_t)ec_k * EC_UNIT;
+    long long stripes = (size + stripe_bytes - 1) / stripe_bytes;
+    int batch = EC_BATCH / stripe_bytes > 0 ? EC_BATCH / stripe_bytes : 1;
+
+    // 디렉토리마다 임시 샤드 파일 (하나라도 만들 수 없으면 원본 유지)
+    ShardWriter w[EC_MAX_DIRS];
+    char tmp[EC_MAX_DIRS][600];
+    int ok = 1;
+    for (int i = 0; i < n; i++)
+    {
+        char dir[400];
+        snprintf(dir, sizeof(dir), "%s/%s", ec_dirs[i], client_id);
+        mkdir(ec_dirs[i], 0777);
+        mkdir(dir, 0777);
+        shard_path(tmp[i], sizeof(tmp[i]), i, client_id, filename, 1);
+        memset(&w[i], 0, sizeof(w[i]));
+        w[i].index = i;
+        w[i].size = size;
+        w[i].fd = ok ? open(tmp[i], O_WRONLY | O_CREAT | O_TRUNC, 0644) : -1;
+        if (w[i].fd < 0)
+        {
+            if (ok)
+                printf("[EC   ] %s: %s\n", tmp[i], strerror(errno));
+            ok = 0;
+        }
+    }
+
+    uint8_t *buf = ok ? malloc((size_t)batch * stripe_bytes) : NULL;
+    uint8_t *parity = ok ? malloc((size_t)batch * ec_m * EC_UNIT) : NULL;
+    ok = ok && buf && parity;
+
+    // 배치 단위: 원본을 읽어 스트라이프마다 패리티를 계산한 뒤 k+m개 디렉토리에 동시에 씀
+    for (long long s0 = 0; ok && s0 < stripes; s0 += batch)
+    {
+        int ns = stripes - s0 < batch ? (int)(stripes - s0) : batch;
+        long long from = s0 * (long long)stripe_bytes;
+        size_t want = size - from < (long long)(ns * stripe_bytes) ? (size_t)(size - from) : ns * stripe_bytes;
+        if (pread_all(in, buf, want, from) < 0)
+        {
+            ok = 0;
+            break;
+        }
+        memset(buf + want, 0, ns * stripe_bytes - want);
+
+        for (int t = 0; t < ns; t++)
+        {
+            uint8_t *data[RS_MAX_SHARDS], *par[RS_MAX_SHARDS];
+            for (int j = 0; j < ec_k; j++)
+                data[j] = buf + ((size_t)t * ec_k + j) * EC_UNIT;
+            for (int p = 0; p < ec_m; p++)
+                par[p] = parity + ((size_t)p * batch + t) * EC_UNIT;
+            rs_encode(ec_k, ec_m, data, par, EC_UNIT);
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            w[i].buf = i < ec_k ? buf : parity + (size_t)(i - ec_k) * batch * EC_UNIT;
+            w[i].stripe = s0;
+            w[i].nstripes = ns;
+        }
+        ok = run_writers(w, n, shard_write) == 0;
+    }
+    free(buf);
+    free(parity);
+    close(in);
+
+    // 헤더 기록과 fsync도 디렉토리마다 동시에
+    if (ok)
+        ok = run_writers(w, n, shard_seal) == 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (w[i].fd >= 0)
+            close(w[i].fd);
+        char final[600];
+        shard_path(final, sizeof(final), i, client_id, filename, 0);
+        if (!ok)
+            unlink(tmp[i]);
+        else if (rename(tmp[i], final) < 0)
+            ok = 0;
+    }
+    if (!ok)
+    {
+        printf("[EC   ] id=%s file=%s 샤드 저장 실패, 원본 유지\n", client_id, filename);
+        ec_remove(client_id, filename);
+        return 0;
+    }
+
+    unlink(path);
+    printf("[EC   ] id=%s file=%s size=%lld stripes=%lld -> %d+%d shards (%lld ms)\n",
+           client_id, filename, size, stripes, ec_k, ec_m, now_ms() - t0);
+    return 1;
+}
+
+// 샤드 파일을 열고 헤더 확인 (설정과 다르거나 깨졌으면 -1)
+static int shard_open(int index, const char *id, const char *file, ShardHeader *h)
+{
+    char path[600];
+    shard_path(path, sizeof(path), index, id, file, 0);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (pread_all(fd, h, sizeof(*h), 0) < 0 || h->magic != SHARD_MAGIC || h->hdr_crc != header_crc(h) ||
+        h->k != ec_k || h->m != ec_m || h->index != index || h->unit != EC_UNIT)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// 샤드로 저장된 업로드의 원래 크기 (헤더가 맞는 샤드가 k개 이상일 때만)
+int ec_stat(const char *client_id, const char *filename, long long *len)
+{
+    int avail = 0;
+    for (int i = 0; i < ec_k + ec_m; i++)
+    {
+        ShardHeader h;
+        int fd = shard_open(i, client_id, filename, &h);
+        if (fd < 0)
+            continue;
+        close(fd);
+        if (avail++ == 0)
+            *len = h.size;
+        else if ((long long)h.size != *len)
+            avail--;
+    }
+    return avail >= ec_k && ec_k > 0 ? 0 : -1;
+}
+
+// 고른 샤드 k개(rows)로 원본을 out에 복원 (샤드 CRC가 틀리면 그 번호를 *bad 에 넣고 -1)
+static int restore(int *fds, const int *rows, long long size, int out, int *bad)
+{
+    int k = ec_k;
+    size_t stripe_bytes = (size_t)k * EC_UNIT;
+    long long stripes = (size + stripe_bytes - 1) / stripe_bytes;
+    int batch = EC_BATCH / stripe_bytes > 0 ? EC_BATCH / stripe_bytes : 1;
+    size_t span = (size_t)batch * EC_UNIT;
+
+    // 고른 샤드의 부호화 행렬 역행렬 - 빠진 데이터 샤드 j = sum_i dec[j][i] * 샤드 rows[i]
+    uint8_t dec[RS_MAX_SHARDS * RS_MAX_SHARDS];
+    for (int i = 0; i < k; i++)
+        rs_matrix_row(k, rows[i], dec + i * k);
+    if (rs_invert(dec, k) < 0)
+        return -1;
+
+    // 데이터 샤드 j의 배치 버퍼 (있으면 읽은 샤드, 없으면 복원 버퍼)
+    uint8_t *in = malloc(span * k);
+    uint8_t *rec = malloc(span * k);
+    uint32_t crc[RS_MAX_SHARDS] = {0};
+    int ret = in && rec ? 0 : -1;
+
+    for (long long s0 = 0; ret == 0 && s0 < stripes; s0 += batch)
+    {
+        int ns = stripes - s0 < batch ? (int)(stripes - s0) : batch;
+        size_t len = (size_t)ns * EC_UNIT;
+        for (int i = 0; i < k && ret == 0; i++)
+        {
+            ret = pread_all(fds[rows[i]], in + i * span, len, sizeof(ShardHeader) + s0 * EC_UNIT);
+            crc[i] = crc32_update(crc[i], in + i * span, len);
+        }
+        if (ret < 0)
+            break;
+
+        uint8_t *data[RS_MAX_SHARDS];
+        for (int j = 0; j < k; j++)
+        {
+            data[j] = NULL;
+            for (int i = 0; i < k; i++)
+                if (rows[i] == j)
+                    data[j] = in + i * span;
+            if (data[j])
+                continue;
+            data[j] = rec + j * span;
+            memset(data[j], 0, len);
+            for (int i = 0; i < k; i++)
+                rs_mul_add(data[j], in + i * span, dec[j * k + i], len);
+        }
+
+        // 스트라이프 순서대로 조각을 이어 붙여 원본 위치에 씀 (마지막 스트라이프의 채움 바이트 제외)
+        for (int t = 0; t < ns && ret == 0; t++)
+        {
+            for (int j = 0; j < k && ret == 0; j++)
+            {
+                long long pos = (s0 + t) * (long long)stripe_bytes + (long long)j * EC_UNIT;
+                if (pos >= size)
+                    break;
+                size_t n = size - pos < EC_UNIT ? (size_t)(size - pos) : EC_UNIT;
+                ret = pwrite_all(out, data[j] + (size_t)t * EC_UNIT, n, pos);
+            }
+        }
+    }
+    free(in);
+    free(rec);
+
+    // 읽은 샤드 중 CRC가 헤더와 다른 샤드가 있으면 그 샤드를 빼고 다시 복원
+    for (int i = 0; ret == 0 && i < k; i++)
+    {
+        ShardHeader h;
+        if (pread_all(fds[rows[i]], &h, sizeof(h), 0) == 0 && h.crc != crc[i])
+        {
+            *bad = rows[i];
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+// 샤드로 저장된 업로드를 임시 파일로 복원
+int ec_lookup(const char *client_id, const char *filename, int *fd, long long *offset, long long *len)
+{
+    if (ec_k == 0)
+        return -1;
+
+    int n = ec_k + ec_m;
+    int fds[EC_MAX_DIRS];
+    long long size = -1;
+    int avail = 0;
+    for (int i = 0; i < n; i++)
+    {
+        ShardHeader h;
+        fds[i] = shard_open(i, client_id, filename, &h);
+        if (fds[i] < 0)
+            continue;
+        if (size >= 0 && (long long)h.size != size)
+        {
+            close(fds[i]);
+            fds[i] = -1;
+            continue;
+        }
+        size = h.size;
+        avail++;
+    }
+
+    // 이름 없는 임시 파일 (지원하지 않는 파일 시스템이면 만들고 바로 삭제)
+    int out = avail >= ec_k ? open(".", O_TMPFILE | O_RDWR, 0600) : -1;
+    if (avail >= ec_k && out < 0)
+    {
+        char tmpl[] = "./.ec-restore-XXXXXX";
+        out = mkstemp(tmpl);
+        if (out >= 0)
+            unlink(tmpl);
+    }
+
+    // 데이터 샤드를 먼저 고르고 모자라는 만큼 패리티 샤드로 채움 (CRC가 틀린 샤드는 빼고 재시도)
+    int ret = -1;
+    while (out >= 0 && avail >= ec_k)
+    {
+        int rows[RS_MAX_SHARDS], cnt = 0;
+        for (int i = 0; i < n && cnt < ec_k; i++)
+            if (fds[i] >= 0)
+                rows[cnt++] = i;
+
+        int bad = -1;
+        if (ftruncate(out, 0) == 0 && restore(fds, rows, size, out, &bad) == 0 && ftruncate(out, size) == 0)
+        {
+            ret = 0;
+            if (rows[ec_k - 1] >= ec_k)
+                printf("[EC   ] id=%s file=%s restored from %d/%d shards\n", client_id, filename, avail, n);
+            break;
+        }
+        if (bad < 0)
+            break;
+        printf("[EC   ] id=%s file=%s shard %d CRC 불일치, 제외\n", client_id, filename, bad);
+        close(fds[bad]);
+        fds[bad] = -1;
+        avail--;
+    }
+
+    for (int i = 0; i < n; i++)
+        if (fds[i] >= 0)
+            close(fds[i]);
+    if (ret < 0)
+    {
+        if (out >= 0)
+            close(out);
+        if (avail < ec_k && size >= 0)
+            printf("[EC   ] id=%s file=%s 남은 샤드 %d개 < k=%d, 복원 불가\n", client_id, filename, avail, ec_k);
+        return -1;
+    }
+    *fd = out;
+    *offset = 0;
+    *len = size;
+    return 0;
+}
+
+// 디렉토리마다 <dir>/<client_id>/*.ec 를 훑음 (앞 디렉토리에 같은 샤드 이름이 있으면 이미 전달한 것)
+void ec_foreach(const char *client_id, void (*cb)(const char *filename, long long len, long long mtime_ns, void *arg),
+                void *arg)
+{
+    for (int i = 0; i < ec_k + ec_m; i++)
+    {
+        char dir[600];
+        snprintf(dir, sizeof(dir), "%s/%s", ec_dirs[i], client_id);
+        DIR *d = opendir(dir);
+        if (!d)
+            continue;
+
+        struct dirent *e;
+        while ((e = readdir(d)) != NULL)
+        {
+            size_t n = strlen(e->d_name);
+            if (e->d_name[0] == '.' || n <= 3 || strcmp(e->d_name + n - 3, ".ec") != 0 || n - 3 >= 256)
+                continue;
+            char file[256];
+            memcpy(file, e->d_name, n - 3);
+            file[n - 3] = '\0';
+
+            char path[900];
+            struct stat st;
+            shard_path(path, sizeof(path), i, client_id, file, 0);
+            if (stat(path, &st) < 0)
+                continue;
+
+            int seen = 0;
+            for (int j = 0; j < i && !seen; j++)
+            {
+                shard_path(path, sizeof(path), j, client_id, file, 0);
+                seen = access(path, F_OK) == 0;
+            }
+            long long len;
+            if (!seen && ec_stat(client_id, file, &len) == 0)
+                cb(file, len, st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec, arg);
+        }
+        closedir(d);
+    }
+}
+
+// 샤드 삭제
+void ec_remove(const char *client_id, const char *filename)
+{
+    for (int i = 0; i < ec_k + ec_m; i++)
+    {
+        char path[600];
+        shard_path(path, sizeof(path), i, client_id, filename, 0);
+        unlink(path);
+    }
+}
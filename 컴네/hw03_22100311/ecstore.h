@@ -0,0 +1,46 @@
+#ifndef ECSTORE_H
+#define ECSTORE_H
+
+// 완료된 업로드를 여러 저장 디렉토리에 소거 부호(리드-솔로몬 k+m)로 나눠 저장
+//   <dir_i>/<client_id>/<filename>.ec   샤드 i (헤더 + 스트라이프마다 EC_UNIT 바이트)
+// 파일을 k * EC_UNIT 바이트 스트라이프로 자르고, 스트라이프의 j번째 조각은 데이터 샤드 j에,
+// 그 k개 조각으로 계산한 패리티 m개는 패리티 샤드 k..k+m-1 에 씀 (디렉토리마다 별도 스레드로 동시에)
+// 읽을 때는 디렉토리가 없거나 샤드가 깨져도 남은 샤드 k개로 원본을 복원
+#define EC_MAX_DIRS 16
+
+// 스트라이프 조각 크기
+#define EC_UNIT (64 * 1024)
+
+// 한 번에 읽어서 부호화하는 원본 크기 (이만큼씩 모든 디렉토리에 동시에 씀)
+#define EC_BATCH (8 * 1024 * 1024)
+
+// 백그라운드 봉인 대기열 길이 (가득 차면 FIN을 처리하는 스레드에서 바로 저장)
+#define EC_QUEUE_LEN 256
+
+// 소거 부호 저장 시작 - spec: "k+m:dir,dir,..." (디렉토리 k+m개, 성공 0, 실패 -1)
+int ec_open(const char *spec);
+
+// 완료된 업로드를 샤드로 나눠 저장한 뒤 원본 파일 삭제
+// (사용하지 않거나 실패하면 원본 그대로 둠, 저장했으면 1, 아니면 0)
+int ec_finish(const char *client_id, const char *filename, const char *path);
+
+// 완료된 업로드를 백그라운드 스레드에서 ec_finish로 봉인 (FIN 응답을 부호화/쓰기 시간만큼 늦추지 않음)
+// 그 사이 같은 파일을 다시 연 연결이 있거나 받다 만 업로드(저널 있음)면 건너뜀, 저장하면 카탈로그 상태를 ec로 바꿈
+void ec_enqueue(const char *client_id, const char *filename);
+
+// 샤드로 저장된 업로드의 원래 크기 (헤더만 읽음, 복원할 수 있는 샤드가 k개보다 적으면 -1)
+int ec_stat(const char *client_id, const char *filename, long long *len);
+
+// 샤드로 저장된 업로드를 이름 없는 임시 파일로 복원 - 디스크립터(호출자가 close), 시작 위치, 길이
+// (pack_lookup 과 같은 형태, 남은 샤드가 k개보다 적으면 -1)
+int ec_lookup(const char *client_id, const char *filename, int *fd, long long *offset, long long *len);
+
+// client_id 의 샤드로 저장된 업로드마다 cb(filename, 원래 크기, 샤드 수정 시각(ns), arg) 호출 (카탈로그 다시 만들기)
+// 어느 디렉토리에 처음 나오는 이름만, 복원할 수 있는 것만 전달
+void ec_foreach(const char *client_id, void (*cb)(const char *filename, long long len, long long mtime_ns, void *arg),
+                void *arg);
+
+// 샤드 삭제 (같은 이름이 다른 방식으로 다시 저장됐을 때)
+void ec_remove(const char *client_id, const char *filename);
+
+#endif
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "endpoint.h"
+
+static Endpoint eps[MAX_ENDPOINTS];
+static int ep_cnt = 0;
+static int current = 0;
+static long long threshold_ms = 5000;
+static pthread_mutex_t ep_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 단조 시계 (us)
+long long endpoint_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// 서버 추가
+int endpoint_add(const char *ip, int port)
+{
+    if (ep_cnt >= MAX_ENDPOINTS || port <= 0 || port > 65535)
+        return -1;
+    Endpoint *e = &eps[ep_cnt++];
+    memset(e, 0, sizeof(*e));
+    snprintf(e->ip, sizeof(e->ip), "%s", ip);
+    e->port = port;
+    return 0;
+}
+
+// "ip:port" 형식으로 서버 추가
+int endpoint_parse(const char *spec)
+{
+    char ip[64];
+    int port;
+    if (sscanf(spec, "%63[^:]:%d", ip, &port) != 2)
+        return -1;
+    return endpoint_add(ip, port);
+}
+
+// 다른 서버로 옮기기까지의 연속 실패 시간
+void endpoint_set_threshold(long long ms)
+{
+    threshold_ms = ms;
+}
+
+// 등록된 서버 수
+int endpoint_count(void)
+{
+    return ep_cnt;
+}
+
+// 대체 서버 고르기 (ep_lock 상태) - 재시도 대기 중이 아닌 서버 중
+// 정상인 서버를 먼저, 그 안에서는 왕복 시간이 짧은 서버, 실패 중이면 실패 횟수가 적은 서버
+static int best_other(long long now)
+{
+    int best = -1;
+    for (int i = 0; i < ep_cnt; i++)
+    {
+        Endpoint *e = &eps[i];
+        if (i == current || e->retry_ms > now)
+            continue;
+        if (best < 0)
+        {
+            best = i;
+            continue;
+        }
+        Endpoint *b = &eps[best];
+        if ((e->down_ms == 0) != (b->down_ms == 0))
+        {
+            if (e->down_ms == 0)
+                best = i;
+        }
+        else if (e->down_ms == 0 ? e->srtt_us < b->srtt_us : e->fails < b->fails)
+            best = i;
+    }
+    return best;
+}
+
+// 이번에 접속할 서버
+int endpoint_pick(Endpoint *out)
+{
+    pthread_mutex_lock(&ep_lock);
+    long long now = endpoint_now_us() / 1000;
+
+    // 대체 서버 사용 중이면 재시도 간격이 지난 기본 서버를 먼저 확인 (살아났으면 돌아감)
+    if (current != 0 && eps[0].retry_ms <= now)
+    {
+        printf("[FAILOVER] 기본 서버 확인 %s:%d\n", eps[0].ip, eps[0].port);
+        current = 0;
+    }
+
+    // 현재 서버가 기준 시간 이상 계속 실패하면 다른 서버로 옮김
+    Endpoint *c = &eps[current];
+    if (c->down_ms != 0 && now - c->down_ms >= threshold_ms)
+    {
+        int next = best_other(now);
+        if (next >= 0)
+        {
+            printf("[FAILOVER] %s:%d -> %s:%d (%lld ms 동안 실패 %d회)\n",
+                   c->ip, c->port, eps[next].ip, eps[next].port, now - c->down_ms, c->fails);
+            current = next;
+        }
+    }
+
+    int idx = current;
+    *out = eps[idx];
+    pthread_mutex_unlock(&ep_lock);
+    fflush(stdout);
+    return idx;
+}
+
+// 결과 기록 - 실패하면 재시도 간격을 두 배씩 늘림 (1초부터 ENDPOINT_MAX_BACKOFF까지)
+void endpoint_report(int idx, int ok, long long rtt_us)
+{
+    if (idx < 0 || idx >= ep_cnt)
+        return;
+
+    pthread_mutex_lock(&ep_lock);
+    Endpoint *e = &eps[idx];
+    long long now = endpoint_now_us() / 1000;
+    if (ok)
+    {
+        e->fails = 0;
+        e->down_ms = 0;
+        e->retry_ms = 0;
+        e->connected = 1;
+        e->srtt_us = e->srtt_us ? (e->srtt_us * 7 + rtt_us) / 8 : rtt_us;
+    }
+    else
+    {
+        if (e->down_ms == 0)
+            e->down_ms = now;
+        long long backoff = 1000LL << (e->fails < 5 ? e->fails : 5);
+        e->retry_ms = now + (backoff < ENDPOINT_MAX_BACKOFF ? backoff : ENDPOINT_MAX_BACKOFF);
+        e->fails++;
+    }
+    pthread_mutex_unlock(&ep_lock);
+}
@@ -0,0 +1,44 @@
+#ifndef ENDPOINT_H
+#define ENDPOINT_H
+
+// 업로드 서버 목록과 상태 (모든 업로드 스레드가 공유)
+// 첫 번째가 기본 서버, 나머지는 같은 저장소를 공유하거나 복제받는 대체 서버 (-F)
+// 현재 서버가 threshold 이상 계속 실패하면 가장 상태가 좋은 대체 서버로 옮겨 RESUME 하고,
+// 기본 서버는 실패할수록 간격을 늘려 가며 다시 시도해서 살아나면 돌아감
+#define MAX_ENDPOINTS 8
+
+// 실패한 서버를 다시 후보로 보기까지의 최대 간격 (ms)
+#define ENDPOINT_MAX_BACKOFF 30000
+
+typedef struct
+{
+    char ip[64];
+    int port;
+
+    int fails;          // 연속 실패 횟수
+    long long down_ms;  // 연속 실패가 시작된 시각 (0이면 정상)
+    long long retry_ms; // 이 시각 전에는 대체 후보로 고르지 않음
+    long long srtt_us;  // FIRST/RESUME 왕복 시간 평활값 (0이면 아직 모름)
+    int connected;      // 한 번이라도 응답을 받았음 (TCP Fast Open 쿠키가 있을 수 있음)
+} Endpoint;
+
+// 서버 추가 ("ip:port" 또는 ip와 port), 목록이 가득 차거나 형식이 틀리면 -1
+int endpoint_add(const char *ip, int port);
+int endpoint_parse(const char *spec);
+
+// 현재 서버가 이 시간(ms) 이상 계속 실패하면 다른 서버로 옮김
+void endpoint_set_threshold(long long threshold_ms);
+
+// 이번에 접속할 서버 번호 (서버 정보는 out에 복사)
+int endpoint_pick(Endpoint *out);
+
+// 접속/왕복 결과 기록 (ok: 성공 여부, rtt_us: 성공 시 왕복 시간)
+void endpoint_report(int idx, int ok, long long rtt_us);
+
+// 등록된 서버 수
+int endpoint_count(void);
+
+// 단조 시계 (us)
+long long endpoint_now_us(void);
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "extent.h"
+
+void extent_init(ExtentMap *m)
+{
+    m->v = NULL;
+    m->n = 0;
+    m->cap = 0;
+}
+
+void extent_free(ExtentMap *m)
+{
+    free(m->v);
+    extent_init(m);
+}
+
+// 구간 추가 (겹치거나 맞닿은 구간과 병합)
+int extent_add(ExtentMap *m, long long start, long long end)
+{
+    if (end <= start)
+        return 0;
+
+    // 새 구간 앞에 오는(병합되지 않는) 구간 개수: start보다 먼저 끝나는 구간
+    int lo = 0;
+    while (lo < m->n && m->v[lo].end < start)
+        lo++;
+
+    // 새 구간과 겹치거나 맞닿는 구간들 [lo, hi)
+    int hi = lo;
+    while (hi < m->n && m->v[hi].start <= end)
+    {
+        if (m->v[hi].start < start)
+            start = m->v[hi].start;
+        if (m->v[hi].end > end)
+            end = m->v[hi].end;
+        hi++;
+    }
+
+    // 병합할 구간이 없으면 lo 위치에 새로 삽입
+    if (hi == lo)
+    {
+        if (m->n == m->cap)
+        {
+            int cap = m->cap ? m->cap * 2 : 8;
+            Extent *v = realloc(m->v, sizeof(Extent) * cap);
+            if (!v)
+                return -1;
+            m->v = v;
+            m->cap = cap;
+        }
+        memmove(&m->v[lo + 1], &m->v[lo], sizeof(Extent) * (m->n - lo));
+        m->n++;
+    }
+
+    // [lo, hi) 를 하나로 합침
+    else if (hi - lo > 1)
+    {
+        memmove(&m->v[lo + 1], &m->v[hi], sizeof(Extent) * (m->n - hi));
+        m->n -= hi - lo - 1;
+    }
+
+    m->v[lo].start = start;
+    m->v[lo].end = end;
+    return 0;
+}
+
+// 0부터 끊김 없이 이어진 구간의 끝
+long long extent_prefix(const ExtentMap *m)
+{
+    if (m->n > 0 && m->v[0].start == 0)
+        return m->v[0].end;
+    return 0;
+}
+
+// 가장 뒤 구간의 끝
+long long extent_max_end(const ExtentMap *m)
+{
+    return m->n > 0 ? m->v[m->n - 1].end : 0;
+}
+
+// [0, size) 에서 비어 있는 구간 목록
+int extent_holes(const ExtentMap *m, long long size, Extent *out, int max)
+{
+    int cnt = 0;
+    long long pos = 0;
+
+    for (int i = 0; i <= m->n && pos < size; i++)
+    {
+        long long next = i < m->n ? m->v[i].start : size;
+        if (next > size)
+            next = size;
+        if (next > pos)
+        {
+            if (cnt < max)
+            {
+                out[cnt].start = pos;
+                out[cnt].end = next;
+            }
+            cnt++;
+        }
+        if (i < m->n && m->v[i].end > pos)
+            pos = m->v[i].end;
+    }
+    return cnt;
+}
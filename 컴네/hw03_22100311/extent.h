@@ -0,0 +1,34 @@
+#ifndef EXTENT_H
+#define EXTENT_H
+
+// 수신이 끝난 구간 [start, end)
+typedef struct
+{
+    long long start;
+    long long end;
+} Extent;
+
+// 정렬되고 서로 겹치지 않는 구간 목록 (인접 구간은 자동 병합)
+typedef struct
+{
+    Extent *v;
+    int n;
+    int cap;
+} ExtentMap;
+
+void extent_init(ExtentMap *m);
+void extent_free(ExtentMap *m);
+
+// 구간 추가 (겹치거나 맞닿은 구간과 병합), 실패 시 -1
+int extent_add(ExtentMap *m, long long start, long long end);
+
+// 0부터 끊김 없이 이어진 구간의 끝 (이어받기 오프셋)
+long long extent_prefix(const ExtentMap *m);
+
+// 가장 뒤 구간의 끝
+long long extent_max_end(const ExtentMap *m);
+
+// [0, size) 에서 비어 있는 구간을 out에 최대 max개 저장, 전체 구멍 개수 반환
+int extent_holes(const ExtentMap *m, long long size, Extent *out, int max);
+
+#endif
@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+// 클라이언트와 서버 사이에서 지연, 대역폭 제한, 임의 RST, 반쯤 열린 정지, 잘린 쓰기를 주입하는 TCP 프록시
+// 이벤트 루프 하나로 모든 연결을 처리 (연결마다 방향별 링 버퍼 + 지연 해제 시각 큐)
+
+#define PIPE_BUF_LEN (256 * 1024)
+#define READ_CHUNK (16 * 1024)
+#define MAX_MARKS 1024
+#define MAX_CONNS 4096
+
+// 한 방향의 전달 상태 (src -> dst)
+typedef struct
+{
+    char buf[PIPE_BUF_LEN];
+    long long in;  // src에서 읽은 누적 바이트
+    long long out; // dst로 쓴 누적 바이트
+
+    // 지연 주입: [이전 mark, mark_end) 구간은 mark_due 이후에 전달 가능
+    long long mark_end[MAX_MARKS];
+    double mark_due[MAX_MARKS];
+    int mhead;
+    int mcnt;
+
+    // 대역폭 제한 토큰
+    double tokens;
+    double refill_at;
+
+    int src_eof;
+    int read_blocked;      // 버퍼가 가득 차서 읽기를 멈춤 (엣지 트리거라 다시 시도해야 함)
+    int shut;              // dst에 FIN을 보냈는지
+    long long cut_at;      // 잘린 쓰기: 이 위치까지만 전달하고 연결 종료 (-1: 없음)
+    double stall_until;    // 반쯤 열린 정지: 이 시각까지 아무것도 전달하지 않다가 RST (0: 없음)
+} Pipe;
+
+// 프록시 연결 하나 (fd[0]: 클라이언트, fd[1]: 서버, p[0]: 0->1, p[1]: 1->0)
+typedef struct
+{
+    int id;
+    int fd[2];
+    int connected;
+    Pipe p[2];
+} Conn;
+
+// 주입 설정
+static double latency = 0;     // 한 방향 지연 (초)
+static double bandwidth = 0;   // 방향별 대역폭 (bytes/s, 0: 제한 없음)
+static double reset_prob = 0;  // 읽은 청크마다 RST로 끊을 확률
+static double stall_prob = 0;  // 읽은 청크마다 전달을 멈출 확률
+static double stall_time = 5;  // 멈춘 뒤 RST까지 시간 (초)
+static double trunc_prob = 0;  // 읽은 청크마다 앞부분만 전달하고 닫을 확률
+static unsigned long long rng = 88172645463325252ULL;
+
+static struct sockaddr_in target;
+static Conn *conns[MAX_CONNS];
+static int conn_seq = 0;
+static int epfd;
+
+// 단조 시계 (초)
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64 난수
+static unsigned long long rand_next(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static double rand_unit(void)
+{
+    return (rand_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// 비블로킹 + 엣지 트리거로 epoll에 등록 (깨우기 용도, 실제 처리는 pump에서 시도)
+static void watch(int fd, Conn *c)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = c;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+// 연결 종료 (rst면 SO_LINGER 0 으로 RST 전송)
+static void close_conn(Conn *c, int rst, const char *why)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (c->fd[i] < 0)
+            continue;
+        if (rst)
+        {
+            struct linger lg = {1, 0};
+            setsockopt(c->fd[i], SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        }
+        close(c->fd[i]);
+    }
+    if (why)
+        printf("[%-5s] conn %d up=%lld down=%lld\n", why, c->id, c->p[0].out, c->p[1].out);
+    fflush(stdout);
+
+    for (int i = 0; i < MAX_CONNS; i++)
+    {
+        if (conns[i] == c)
+            conns[i] = NULL;
+    }
+    free(c);
+}
+
+// src에서 읽어 링 버퍼에 넣고 이 청크에 대한 장애를 결정 (연결을 닫았으면 -1)
+static int pipe_read(Conn *c, int dir)
+{
+    Pipe *p = &c->p[dir];
+    int src = c->fd[dir];
+
+    p->read_blocked = 0;
+    while (!p->src_eof && p->cut_at < 0)
+    {
+        long long space = PIPE_BUF_LEN - (p->in - p->out);
+        if (space <= 0 || p->mcnt == MAX_MARKS)
+        {
+            p->read_blocked = 1;
+            break;
+        }
+
+        // 링 버퍼의 연속 구간까지만 읽음
+        long long pos = p->in % PIPE_BUF_LEN;
+        long long want = PIPE_BUF_LEN - pos;
+        if (want > space)
+            want = space;
+        if (want > READ_CHUNK)
+            want = READ_CHUNK;
+
+        ssize_t n = read(src, p->buf + pos, want);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0)
+        {
+            close_conn(c, 1, "ERROR");
+            return -1;
+        }
+        if (n == 0)
+        {
+            p->src_eof = 1;
+            break;
+        }
+
+        p->in += n;
+        int tail = (p->mhead + p->mcnt) % MAX_MARKS;
+        p->mark_end[tail] = p->in;
+        p->mark_due[tail] = now_sec() + latency;
+        p->mcnt++;
+
+        // 장애 주입 (방향 구분 없이 읽은 청크마다 한 번씩 판정)
+        if (rand_unit() < reset_prob)
+        {
+            close_conn(c, 1, "RESET");
+            return -1;
+        }
+        if (p->stall_until == 0 && rand_unit() < stall_prob)
+        {
+            p->stall_until = now_sec() + stall_time;
+            printf("[STALL] conn %d dir=%d for %.1fs\n", c->id, dir, stall_time);
+        }
+        if (rand_unit() < trunc_prob)
+        {
+            p->cut_at = p->in - n + rand_next() % n;
+            printf("[TRUNC] conn %d dir=%d at %lld\n", c->id, dir, p->cut_at);
+        }
+    }
+    return 0;
+}
+
+// 전달 가능한 데이터를 dst로 씀 (연결을 닫았으면 -1)
+static int pipe_write(Conn *c, int dir)
+{
+    Pipe *p = &c->p[dir];
+    int dst = c->fd[1 - dir];
+    double now = now_sec();
+
+    // 정지 중이면 아무것도 전달하지 않다가 시간이 지나면 RST
+    if (p->stall_until > 0)
+    {
+        if (now < p->stall_until)
+            return 0;
+        close_conn(c, 1, "STALL");
+        return -1;
+    }
+
+    // 대역폭 제한 토큰 보충 (최대 50ms 분량까지 모아둘 수 있음)
+    if (bandwidth > 0)
+    {
+        double cap = bandwidth / 20 > READ_CHUNK ? bandwidth / 20 : READ_CHUNK;
+        p->tokens += (now - p->refill_at) * bandwidth;
+        if (p->tokens > cap)
+            p->tokens = cap;
+        p->refill_at = now;
+    }
+
+    while (1)
+    {
+        // 지연 시간이 지난 구간만 해제
+        while (p->mcnt > 0 && p->mark_end[p->mhead] <= p->out)
+        {
+            p->mhead = (p->mhead + 1) % MAX_MARKS;
+            p->mcnt--;
+        }
+        long long limit = p->out;
+        for (int k = 0; k < p->mcnt; k++)
+        {
+            int idx = (p->mhead + k) % MAX_MARKS;
+            if (p->mark_due[idx] > now)
+                break;
+            limit = p->mark_end[idx];
+        }
+        if (p->cut_at >= 0 && limit > p->cut_at)
+            limit = p->cut_at;
+
+        long long want = limit - p->out;
+        long long pos = p->out % PIPE_BUF_LEN;
+        if (want > PIPE_BUF_LEN - pos)
+            want = PIPE_BUF_LEN - pos;
+        if (bandwidth > 0 && want > (long long)p->tokens)
+            want = (long long)p->tokens;
+        if (want <= 0)
+            break;
+
+        ssize_t n = write(dst, p->buf + pos, want);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+        {
+            close_conn(c, 1, "ERROR");
+            return -1;
+        }
+        p->out += n;
+        if (bandwidth > 0)
+            p->tokens -= n;
+    }
+
+    // 잘린 쓰기: 자른 위치까지 전달했으면 양쪽을 정상 종료
+    if (p->cut_at >= 0 && p->out >= p->cut_at)
+    {
+        close_conn(c, 0, "TRUNC");
+        return -1;
+    }
+
+    // src가 닫혔고 모두 전달했으면 dst에도 FIN 전달
+    if (p->src_eof && p->out == p->in && !p->shut)
+    {
+        shutdown(dst, SHUT_WR);
+        p->shut = 1;
+    }
+    return 0;
+}
+
+// 연결 하나 처리, 아직 전달을 기다리는 데이터가 있으면 1
+static int pump(Conn *c)
+{
+    // 서버 쪽 비블로킹 접속 완료 확인
+    if (!c->connected)
+    {
+        if (connect(c->fd[1], (struct sockaddr *)&target, sizeof(target)) < 0 &&
+            errno != EISCONN)
+        {
+            if (errno == EINPROGRESS || errno == EALREADY)
+                return 0;
+            close_conn(c, 1, "REFUS");
+            return 0;
+        }
+        c->connected = 1;
+    }
+
+    for (int dir = 0; dir < 2; dir++)
+    {
+        if (pipe_read(c, dir) < 0 || pipe_write(c, dir) < 0)
+            return 0;
+    }
+
+    // 양방향 모두 끝났으면 정리
+    if (c->p[0].shut && c->p[1].shut)
+    {
+        close_conn(c, 0, NULL);
+        return 0;
+    }
+    return c->p[0].out < c->p[0].in || c->p[1].out < c->p[1].in ||
+           c->p[0].read_blocked || c->p[1].read_blocked ||
+           c->p[0].stall_until > 0 || c->p[1].stall_until > 0;
+}
+
+// 새 클라이언트 연결을 받아 서버로 비블로킹 접속 시작
+static void accept_conn(int lsd)
+{
+    while (1)
+    {
+        int cs = accept(lsd, NULL, NULL);
+        if (cs < 0)
+            return;
+
+        int slot = -1;
+        for (int i = 0; i < MAX_CONNS && slot < 0; i++)
+        {
+            if (!conns[i])
+                slot = i;
+        }
+        Conn *c = slot >= 0 ? calloc(1, sizeof(Conn)) : NULL;
+        int ss = socket(PF_INET, SOCK_STREAM, 0);
+        if (!c || ss < 0)
+        {
+            close(cs);
+            if (ss >= 0)
+                close(ss);
+            free(c);
+            continue;
+        }
+
+        c->id = conn_seq++;
+        c->fd[0] = cs;
+        c->fd[1] = ss;
+        c->p[0].cut_at = c->p[1].cut_at = -1;
+        c->p[0].refill_at = c->p[1].refill_at = now_sec();
+        conns[slot] = c;
+
+        watch(cs, c);
+        watch(ss, c);
+        connect(ss, (struct sockaddr *)&target, sizeof(target));
+    }
+}
+
+// 메인 함수
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "l:b:R:s:w:t:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l':
+            latency = atof(optarg) / 1000;
+            break;
+        case 'b':
+            bandwidth = atof(optarg);
+            break;
+        case 'R':
+            reset_prob = atof(optarg);
+            break;
+        case 's':
+            stall_prob = atof(optarg);
+            break;
+        case 'w':
+            stall_time = atof(optarg) / 1000;
+            break;
+        case 't':
+            trunc_prob = atof(optarg);
+            break;
+        case 'r':
+            rng = strtoull(optarg, NULL, 10) | 1;
+            break;
+        default:
+            argc = 0;
+            break;
+        }
+    }
+
+    if (argc - optind != 3)
+    {
+        printf("Usage: %s [-l ms] [-b bytes_per_sec] [-R prob] [-s prob] [-w ms] [-t prob] [-r seed] <listen_port> <server_ip> <server_port>\n", argv[0]);
+        printf("  -l  방향별 지연 (ms)\n");
+        printf("  -b  연결/방향별 대역폭 제한 (bytes/s)\n");
+        printf("  -R  읽은 청크마다 RST로 끊을 확률\n");
+        printf("  -s  읽은 청크마다 전달을 멈출 확률 (반쯤 열린 연결, -w 뒤 RST)\n");
+        printf("  -w  멈춘 연결을 RST로 끊기까지 시간 (ms, 기본 5000)\n");
+        printf("  -t  읽은 청크마다 앞부분만 전달하고 닫을 확률 (잘린 쓰기)\n");
+        printf("  -r  장애 패턴 난수 시드\n");
+        exit(1);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_addr.s_addr = inet_addr(argv[optind + 1]);
+    target.sin_port = htons(atoi(argv[optind + 2]));
+
+    // 연결마다 fd 2개를 쓰므로 fd 한도를 올림
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    int lsd = socket(PF_INET, SOCK_STREAM, 0);
+    int option = 1;
+    setsockopt(lsd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(atoi(argv[optind]));
+    if (bind(lsd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(lsd, SOMAXCONN) < 0)
+    {
+        perror("bind");
+        exit(1);
+    }
+    fcntl(lsd, F_SETFL, fcntl(lsd, F_GETFL) | O_NONBLOCK);
+
+    epfd = epoll_create1(0);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, lsd, &ev);
+
+    printf("Proxy start port: %s -> %s:%s\n", argv[optind], argv[optind + 1], argv[optind + 2]);
+    fflush(stdout);
+
+    // 이벤트 루프: 깨어날 때마다 모든 연결을 한 번씩 처리
+    // (지연/대역폭 대기 중인 데이터가 있으면 1ms마다 다시 확인)
+    struct epoll_event events[256];
+    int pending = 0;
+    while (1)
+    {
+        int n = epoll_wait(epfd, events, 256, pending ? 1 : -1);
+        for (int i = 0; i < n; i++)
+        {
+            if (events[i].data.ptr == NULL)
+                accept_conn(lsd);
+        }
+
+        pending = 0;
+        for (int i = 0; i < MAX_CONNS; i++)
+        {
+            if (conns[i])
+                pending |= pump(conns[i]);
+        }
+    }
+    return 0;
+}
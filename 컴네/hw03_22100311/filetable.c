@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "filetable.h"
+
+static UploadFile *table = NULL;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 경로에 해당하는 공유 상태를 얻음
+UploadFile *filetable_acquire(const char *path, int *created)
+{
+    pthread_mutex_lock(&table_lock);
+
+    UploadFile *f;
+    for (f = table; f; f = f->next)
+    {
+        if (strcmp(f->path, path) == 0)
+        {
+            f->refcnt++;
+            *created = 0;
+            pthread_mutex_unlock(&table_lock);
+            return f;
+        }
+    }
+
+    f = calloc(1, sizeof(*f));
+    if (f)
+    {
+        snprintf(f->path, sizeof(f->path), "%s", path);
+        f->refcnt = 1;
+        f->trim_end = -1;
+        pthread_mutex_init(&f->lock, NULL);
+        extent_init(&f->extents);
+        f->next = table;
+        table = f;
+    }
+    *created = 1;
+
+    // 복구가 끝날 때까지 다른 연결이 extents를 보지 못하도록 잠근 채 반환
+    if (f)
+        pthread_mutex_lock(&f->lock);
+    pthread_mutex_unlock(&table_lock);
+    return f;
+}
+
+// 참조 해제 (마지막 참조면 제거)
+void filetable_release(UploadFile *f)
+{
+    if (!f)
+        return;
+
+    pthread_mutex_lock(&table_lock);
+    if (--f->refcnt > 0)
+    {
+        pthread_mutex_unlock(&table_lock);
+        return;
+    }
+
+    // 먼저 끝난 연결이 미뤄 둔 자르기 (그 뒤에 받은 구간까지는 남김)
+    // 새로 여는 연결이 자르기 전의 크기를 보지 않도록 table_lock을 잡은 채로 처리
+    if (f->trim_end >= 0)
+    {
+        long long end = extent_max_end(&f->extents);
+        truncate(f->path, end > f->trim_end ? end : f->trim_end);
+    }
+
+    UploadFile **pp = &table;
+    while (*pp && *pp != f)
+        pp = &(*pp)->next;
+    if (*pp)
+        *pp = f->next;
+    pthread_mutex_unlock(&table_lock);
+
+    extent_free(&f->extents);
+    pthread_mutex_destroy(&f->lock);
+    free(f);
+}
+
+// 미리 할당한 파일 자르기 (이 연결만 쓰고 있으면 바로, 아니면 마지막 참조가 놓일 때)
+int filetable_trim(UploadFile *f, long long size)
+{
+    pthread_mutex_lock(&table_lock);
+    int now = f->refcnt == 1;
+    if (now)
+    {
+        truncate(f->path, size);
+        f->trim_end = -1;
+    }
+    else if (size > f->trim_end)
+    {
+        f->trim_end = size;
+    }
+    pthread_mutex_unlock(&table_lock);
+    return now;
+}
@@ -0,0 +1,37 @@
+#ifndef FILETABLE_H
+#define FILETABLE_H
+
+#include <pthread.h>
+
+#include "extent.h"
+
+// 여러 연결이 동시에 쓰는 업로드 파일의 공유 상태
+typedef struct UploadFile
+{
+    char path[512];
+    int refcnt;
+
+    // 마지막 참조가 놓일 때 잘라낼 크기 (-1: 없음, 다른 연결이 매핑 중이라 미룬 filetable_trim)
+    long long trim_end;
+
+    // extents 보호 (같은 파일에 여러 경로로 들어오는 DATA)
+    pthread_mutex_t lock;
+    ExtentMap extents;
+
+    struct UploadFile *next;
+} UploadFile;
+
+// 경로에 해당하는 공유 상태를 얻음 (참조 카운트 증가)
+// 처음 여는 경우 *created = 1 이고 lock을 잡은 상태로 반환
+// (호출자가 복구로 extents를 채운 뒤 unlock)
+UploadFile *filetable_acquire(const char *path, int *created);
+
+// 참조 해제 (마지막 참조면 미뤄 둔 자르기를 적용하고 제거)
+void filetable_release(UploadFile *f);
+
+// 미리 할당한 파일을 size로 자름 (mmap 수신 완료 시)
+// 다른 연결이 아직 같은 파일을 매핑하고 있을 수 있으면 (SIGBUS) 마지막 참조가 놓일 때까지 미룸
+// (바로 잘랐으면 1, 미뤘으면 0)
+int filetable_trim(UploadFile *f, long long size);
+
+#endif
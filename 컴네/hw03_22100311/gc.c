@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "gc.h"
+#include "journal.h"
+#include "filetable.h"
+#include "pack.h"
+
+// ioprio_set 인자 (glibc에 래퍼가 없어서 직접 정의)
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_CLASS_SHIFT 13
+
+static int ttl = 0;
+static time_t last_io = 0;
+static pthread_mutex_t io_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 업로드 데이터 수신을 알림
+void gc_note_io(void)
+{
+    pthread_mutex_lock(&io_lock);
+    last_io = time(NULL);
+    pthread_mutex_unlock(&io_lock);
+}
+
+// 최근 GC_QUIET_SEC 안에 업로드 데이터가 들어왔는지
+int gc_uploads_active(void)
+{
+    pthread_mutex_lock(&io_lock);
+    int active = time(NULL) - last_io < GC_QUIET_SEC;
+    pthread_mutex_unlock(&io_lock);
+    return active;
+}
+
+// 업로드가 멈출 때까지 대기 (조용해지면 1, GC_MAX_DEFER_SEC 뒤에도 바쁘면 0)
+static int wait_quiet(void)
+{
+    for (int waited = 0; gc_uploads_active(); waited += GC_QUIET_SEC)
+    {
+        if (waited >= GC_MAX_DEFER_SEC)
+            return 0;
+        sleep(GC_QUIET_SEC);
+    }
+    return 1;
+}
+
+// 이 스레드만 가장 낮은 CPU / I/O 우선순위로 낮춤 (idle 클래스: 다른 I/O가 없을 때만 디스크 사용)
+void gc_lower_priority(void)
+{
+    pid_t tid = syscall(SYS_gettid);
+    setpriority(PRIO_PROCESS, tid, 19);
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+
+// 이름이 suffix로 끝나는지
+static int ends_with(const char *name, const char *suffix)
+{
+    size_t n = strlen(name), k = strlen(suffix);
+    return n > k && strcmp(name + n - k, suffix) == 0;
+}
+
+// 부분 업로드 하나 처리 (name: .<file>.journal)
+// TTL이 지났으면 데이터와 저널 삭제, 아니면 오래 쉬고 있는 큰 저널을 압축
+static void sweep_journal(const char *dir, const char *name, time_t now)
+{
+    char jpath[600], dpath[600];
+    snprintf(jpath, sizeof(jpath), "%s/%s", dir, name);
+    snprintf(dpath, sizeof(dpath), "%s/%.*s", dir, (int)(strlen(name) - strlen(".journal") - 1), name + 1);
+
+    // 마지막으로 쓰인 시각 (저널과 데이터 중 늦은 쪽)
+    struct stat jst, dst;
+    if (stat(jpath, &jst) < 0)
+        return;
+    time_t mtime = jst.st_mtime;
+    if (stat(dpath, &dst) == 0 && dst.st_mtime > mtime)
+        mtime = dst.st_mtime;
+    long long idle = now - mtime;
+    long nrec = jst.st_size / sizeof(JournalRecord);
+
+    int expire = ttl > 0 && idle > ttl;
+    int compact = !expire && nrec > GC_COMPACT_RECORDS && idle > GC_COMPACT_IDLE_SEC;
+    if (!expire && !compact)
+        return;
+
+    // 업로드가 계속 바쁘면 데이터를 읽는 압축은 미룸
+    if (!wait_quiet() && compact)
+        return;
+
+    // 다른 연결이 쓰는 중이면 건너뜀
+    // (처음 잡은 경우 lock을 쥔 상태라 그동안 새로 여는 연결은 open_upload에서 대기)
+    int created;
+    UploadFile *f = filetable_acquire(dpath, &created);
+    if (!f)
+        return;
+    if (!created)
+    {
+        filetable_release(f);
+        return;
+    }
+
+    if (expire)
+    {
+        unlink(dpath);
+        unlink(jpath);
+
+        // HTTP(tus) 업로드의 전체 크기 기록도 함께 삭제
+        char lpath[600];
+        snprintf(lpath, sizeof(lpath), "%s/%.*s.length", dir, (int)(strlen(name) - strlen(".journal")), name);
+        unlink(lpath);
+        printf("[GC   ] expired %s (idle %llds)\n", dpath, idle);
+    }
+    else
+    {
+        // 압축하면서 복구한 구간은 공유 상태에 남겨 대기 중인 연결이 그대로 사용
+        long long offset = journal_compact(jpath, dpath, &f->extents);
+        if (offset >= 0 && stat(jpath, &jst) == 0)
+            printf("[GC   ] compacted %s journal %ld -> %ld records (offset=%lld)\n",
+                   jpath, nrec, (long)(jst.st_size / sizeof(JournalRecord)), offset);
+    }
+    pthread_mutex_unlock(&f->lock);
+    filetable_release(f);
+}
+
+// 중단된 델타 재구성/압축 임시 파일 처리 (TTL이 지났으면 삭제)
+static void sweep_temp(const char *dir, const char *name, time_t now)
+{
+    char path[600];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+    struct stat st;
+    if (ttl <= 0 || stat(path, &st) < 0 || now - st.st_mtime <= ttl)
+        return;
+
+    wait_quiet();
+    if (unlink(path) == 0)
+        printf("[GC   ] removed stale %s\n", path);
+}
+
+// ./<client_id>/ 디렉토리들을 훑으면서 부분 업로드 정리
+static void sweep_all(void)
+{
+    DIR *top = opendir(".");
+    if (!top)
+        return;
+
+    struct dirent *e;
+    while ((e = readdir(top)) != NULL)
+    {
+        if (e->d_name[0] == '.')
+            continue;
+
+        char dir[300];
+        struct stat st;
+        snprintf(dir, sizeof(dir), "./%s", e->d_name);
+        if (stat(dir, &st) < 0 || !S_ISDIR(st.st_mode))
+            continue;
+
+        DIR *d = opendir(dir);
+        if (!d)
+            continue;
+
+        struct dirent *f;
+        while ((f = readdir(d)) != NULL)
+        {
+            // 부분 업로드 관련 파일은 모두 '.'으로 시작
+            if (f->d_name[0] != '.' || strcmp(f->d_name, ".") == 0 || strcmp(f->d_name, "..") == 0)
+                continue;
+
+            if (ends_with(f->d_name, ".journal"))
+                sweep_journal(dir, f->d_name, time(NULL));
+            else if (ends_with(f->d_name, ".delta") || ends_with(f->d_name, ".tmp"))
+                sweep_temp(dir, f->d_name, time(NULL));
+            else
+                continue;
+
+            // 파일 단위로 쉬어서 디스크 메타데이터 I/O를 분산
+            usleep(1000000 / GC_OPS_PER_SEC);
+        }
+        closedir(d);
+    }
+    closedir(top);
+}
+
+// 정리 스레드 - 시작 시 한 번, 이후 GC_SCAN_SEC마다 훑음
+static void *gc_thread(void *arg)
+{
+    (void)arg;
+    gc_lower_priority();
+
+    while (1)
+    {
+        sweep_all();
+
+        // 죽은 데이터가 많은 팩 파일 압축 (업로드가 바쁘면 다음 주기로 미룸)
+        if (wait_quiet())
+            pack_compact();
+        fflush(stdout);
+        sleep(GC_SCAN_SEC);
+    }
+    return NULL;
+}
+
+// 미완료 업로드 정리 스레드 시작
+void gc_start(int ttl_sec)
+{
+    ttl = ttl_sec;
+
+    pthread_t t;
+    pthread_create(&t, NULL, gc_thread, NULL);
+    pthread_detach(t);
+}
@@ -0,0 +1,32 @@
+#ifndef GC_H
+#define GC_H
+
+// 디렉토리 전체를 다시 훑는 주기 (초)
+#define GC_SCAN_SEC 60
+
+// 파일 하나를 처리한 뒤 쉬는 간격 (초당 최대 처리 파일 수)
+#define GC_OPS_PER_SEC 20
+
+// 최근 이 시간(초) 안에 DATA 수신이 있었으면 업로드 중으로 보고 양보
+#define GC_QUIET_SEC 2
+
+// 업로드가 계속되는 동안 기다리는 최대 시간, 넘으면 만료만 느리게 진행 (압축은 건너뜀)
+#define GC_MAX_DEFER_SEC 30
+
+// 저널 레코드가 이보다 많고 GC_COMPACT_IDLE_SEC 동안 쓰이지 않았으면 압축
+#define GC_COMPACT_RECORDS 4096
+#define GC_COMPACT_IDLE_SEC 60
+
+// 미완료 업로드 정리 스레드 시작 (ttl_sec 동안 갱신되지 않은 부분 파일은 삭제)
+void gc_start(int ttl_sec);
+
+// 업로드 데이터 수신을 알림 (정리 스레드가 I/O를 양보하는 기준)
+void gc_note_io(void);
+
+// 최근 GC_QUIET_SEC 안에 업로드 데이터가 들어왔는지 (다른 백그라운드 작업도 같은 기준으로 양보)
+int gc_uploads_active(void);
+
+// 호출한 스레드를 가장 낮은 CPU / I/O 우선순위로 낮춤
+void gc_lower_priority(void);
+
+#endif
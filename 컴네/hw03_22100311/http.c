@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "netio.h"
+#include "http.h"
+
+// 상태 코드별 설명 문구
+static const char *http_reason(int status)
+{
+    switch (status)
+    {
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 412: return "Precondition Failed";
+    case 413: return "Request Entity Too Large";
+    case 415: return "Unsupported Media Type";
+    case 416: return "Range Not Satisfiable";
+    default: return "Internal Server Error";
+    }
+}
+
+// 명령 줄이 HTTP 요청 줄인지 (업로드 프로토콜 명령과 겹치지 않는 메서드 이름)
+int http_is_request(const char *line)
+{
+    static const char *methods[] = {"POST ", "PATCH ", "HEAD ", "OPTIONS ", "GET ", "PUT ", "DELETE "};
+    for (size_t i = 0; i < sizeof(methods) / sizeof(methods[0]); i++)
+        if (strncmp(line, methods[i], strlen(methods[i])) == 0)
+            return 1;
+    return 0;
+}
+
+// 요청 줄 파싱: "<METHOD> <path> HTTP/1.x"
+int http_parse_request_line(HttpRequest *req, const char *line)
+{
+    memset(req, 0, sizeof(*req));
+    req->upload_offset = -1;
+    req->upload_length = -1;
+    req->range_start = -1;
+    req->range_end = -1;
+
+    char version[16];
+    if (sscanf(line, "%15s %511s %15s", req->method, req->path, version) != 3)
+        return -1;
+    if (strncmp(version, "HTTP/1.", 7) != 0)
+        return -1;
+    if (strcmp(version, "HTTP/1.0") == 0)
+        req->close = 1;
+    return 0;
+}
+
+// 헤더 한 줄 파싱
+int http_parse_header(HttpRequest *req, char *line)
+{
+    // 줄 끝의 CR/LF 제거
+    size_t n = strlen(line);
+    while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r'))
+        line[--n] = '\0';
+    if (n == 0)
+        return 1;
+
+    char *colon = strchr(line, ':');
+    if (!colon)
+        return 0;
+    *colon = '\0';
+    char *value = colon + 1;
+    while (*value == ' ' || *value == '\t')
+        value++;
+
+    if (strcasecmp(line, "Content-Length") == 0)
+        req->content_length = atoll(value);
+    else if (strcasecmp(line, "Upload-Offset") == 0)
+        req->upload_offset = atoll(value);
+    else if (strcasecmp(line, "Upload-Length") == 0)
+        req->upload_length = atoll(value);
+    else if (strcasecmp(line, "Upload-Metadata") == 0)
+        snprintf(req->metadata, sizeof(req->metadata), "%s", value);
+    else if (strcasecmp(line, "Content-Type") == 0)
+        req->octet_stream = strncasecmp(value, "application/offset+octet-stream", 31) == 0;
+    else if (strcasecmp(line, "Tus-Resumable") == 0)
+        req->tus = 1;
+    else if (strcasecmp(line, "Connection") == 0)
+        req->close = strcasecmp(value, "close") == 0;
+    else if (strcasecmp(line, "Range") == 0)
+    {
+        // 구간 하나만 (끝에서부터 세는 bytes=-n 이나 여러 구간은 무시하고 전체 전송)
+        long long a, b;
+        int n = sscanf(value, "bytes=%lld-%lld", &a, &b);
+        if (n >= 1 && a >= 0 && !strchr(value, ','))
+        {
+            req->range_start = a;
+            req->range_end = n == 2 ? b : -1;
+        }
+    }
+    return 0;
+}
+
+// base64 문자 하나의 값 (잘못된 문자면 -1)
+static int b64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+')
+        return 62;
+    if (c == '/')
+        return 63;
+    return -1;
+}
+
+// base64 디코딩 (in: len 글자, 끝의 '=' 허용), 디코딩한 길이 반환, 실패 시 -1
+static int b64_decode(const char *in, size_t len, char *out, size_t size)
+{
+    size_t pos = 0;
+    unsigned int acc = 0;
+    int bits = 0;
+
+    for (size_t i = 0; i < len && in[i] != '='; i++)
+    {
+        int v = b64_value(in[i]);
+        if (v < 0)
+            return -1;
+        acc = (acc << 6) | v;
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            if (pos + 1 >= size)
+                return -1;
+            out[pos++] = (acc >> bits) & 0xFF;
+        }
+    }
+    out[pos] = '\0';
+    return (int)pos;
+}
+
+// Upload-Metadata 에서 key 값 찾기: "filename ZGF0YS5iaW4=,clientid d2Vi"
+int http_metadata(const HttpRequest *req, const char *key, char *out, size_t size)
+{
+    size_t klen = strlen(key);
+    const char *p = req->metadata;
+
+    while (*p)
+    {
+        while (*p == ' ' || *p == ',')
+            p++;
+        const char *end = strchr(p, ',');
+        if (!end)
+            end = p + strlen(p);
+
+        if (strncmp(p, key, klen) == 0 && (p[klen] == ' ' || p + klen == end))
+        {
+            const char *v = p + klen;
+            while (v < end && *v == ' ')
+                v++;
+            return b64_decode(v, end - v, out, size) < 0 ? -1 : 0;
+        }
+        p = end;
+    }
+    return -1;
+}
+
+// 응답 헤더 전송 (브라우저에서 호출할 수 있도록 CORS 헤더 포함)
+int http_respond_length(int sd, int status, const char *headers, long long length)
+{
+    char msg[HTTP_LINE];
+    int len = snprintf(msg, sizeof(msg),
+                       "HTTP/1.1 %d %s\r\n"
+                       "Tus-Resumable: " TUS_VERSION "\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Access-Control-Expose-Headers: Location, Upload-Offset, Upload-Length, Tus-Resumable, Content-Range\r\n"
+                       "%s"
+                       "Content-Length: %lld\r\n"
+                       "\r\n",
+                       status, http_reason(status), headers ? headers : "", length);
+    if (len < 0 || len >= (int)sizeof(msg))
+        return -1;
+    return write_all(sd, msg, len);
+}
+
+// 본문 없는 응답 전송
+int http_respond(int sd, int status, const char *headers)
+{
+    return http_respond_length(sd, status, headers, 0);
+}
@@ -0,0 +1,52 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <stddef.h>
+
+// 브라우저용 tus(1.0.0) 방식 이어받기 업로드: 같은 포트로 들어온 HTTP 요청을 구분해서 처리
+//   POST    /files                     업로드 생성 (Upload-Length, Upload-Metadata: filename/clientid)
+//   HEAD    /files/<client_id>/<file>  현재 오프셋 조회 (Upload-Offset)
+//   PATCH   /files/<client_id>/<file>  Upload-Offset 위치부터 본문을 이어서 저장
+//   GET     /files/<client_id>/<file>  완료된 업로드 내용 (Range: bytes=a-b 지원)
+//   OPTIONS *                          지원 버전/확장 조회 (CORS preflight 포함)
+#define HTTP_PREFIX "/files"
+#define TUS_VERSION "1.0.0"
+
+// 헤더 한 줄의 최대 길이
+#define HTTP_LINE 2048
+
+// 요청 한 건 (요청 줄 + 필요한 헤더만)
+typedef struct
+{
+    char method[16];
+    char path[512];
+    long long content_length; // 없으면 0
+    long long upload_offset;  // 없으면 -1
+    long long upload_length;  // 없으면 -1
+    long long range_start;    // Range: bytes=a-b 의 a (없으면 -1)
+    long long range_end;      // b (생략했으면 -1: 끝까지)
+    char metadata[HTTP_LINE]; // Upload-Metadata (key base64,key base64,...)
+    int octet_stream;         // Content-Type: application/offset+octet-stream
+    int tus;                  // Tus-Resumable 헤더 존재
+    int close;                // Connection: close 또는 HTTP/1.0
+} HttpRequest;
+
+// 명령 줄이 HTTP 요청 줄인지 (메서드 이름으로 구분)
+int http_is_request(const char *line);
+
+// 요청 줄 파싱 후 헤더 필드 초기화 (성공 0, 실패 -1)
+int http_parse_request_line(HttpRequest *req, const char *line);
+
+// 헤더 한 줄 파싱 (관심 없는 헤더는 무시), 빈 줄(헤더 끝)이면 1 반환
+int http_parse_header(HttpRequest *req, char *line);
+
+// Upload-Metadata 에서 key 값을 base64 디코딩해서 out에 저장 (성공 0, 없거나 잘못되면 -1)
+int http_metadata(const HttpRequest *req, const char *key, char *out, size_t size);
+
+// 상태 코드와 추가 헤더(각 줄 "\r\n"으로 끝남, 없으면 NULL)로 본문 없는 응답 전송 (성공 0, 실패 -1)
+int http_respond(int sd, int status, const char *headers);
+
+// 본문이 있는 응답의 헤더 부분만 전송 (본문 length 바이트는 호출자가 이어서 씀)
+int http_respond_length(int sd, int status, const char *headers, long long length);
+
+#endif
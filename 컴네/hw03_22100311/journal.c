@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+
+#define VERIFY_BUF 65536
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+// CRC32 테이블 생성 (최초 1회)
+static void crc_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+// CRC32 (IEEE) 계산
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len)
+{
+    const unsigned char *p = buf;
+
+    pthread_once(&crc_once, crc_init);
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++)
+        crc = crc_table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+// 레코드 자체의 체크섬 (rec_crc, pad 제외)
+static uint32_t record_crc(const JournalRecord *r)
+{
+    return crc32_update(0, r, offsetof(JournalRecord, rec_crc));
+}
+
+// 저널 파일 열기 (이어쓰기)
+int journal_open(const char *path)
+{
+    return open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+}
+
+// 레코드 한 개를 한 번의 write로 추가
+static int journal_write(int fd, JournalRecord *r)
+{
+    r->pad = 0;
+    r->rec_crc = record_crc(r);
+    if (write(fd, r, sizeof(*r)) != (ssize_t)sizeof(*r))
+        return -1;
+    return 0;
+}
+
+// 청크 기록 (데이터를 파일에 쓴 직후 호출)
+int journal_append(int fd, long long offset, uint32_t len, const void *data)
+{
+    JournalRecord r;
+    memset(&r, 0, sizeof(r));
+    r.offset = offset;
+    r.len = len;
+    r.crc = crc32_update(0, data, len);
+    return journal_write(fd, &r);
+}
+
+// CRC를 이미 계산한 청크 기록
+int journal_append_crc(int fd, long long offset, uint32_t len, uint32_t crc)
+{
+    JournalRecord r;
+    memset(&r, 0, sizeof(r));
+    r.offset = offset;
+    r.len = len;
+    r.crc = crc;
+    return journal_write(fd, &r);
+}
+
+// 기준 오프셋 레코드 기록
+int journal_append_base(int fd, long long offset)
+{
+    JournalRecord r;
+    memset(&r, 0, sizeof(r));
+    r.offset = offset;
+    return journal_write(fd, &r);
+}
+
+// 레코드가 가리키는 데이터가 파일에 온전히 있는지 검증
+static int verify_record(int data_fd, long long data_size, const JournalRecord *r, char *buf)
+{
+    if (record_crc(r) != r->rec_crc)
+        return 0;
+
+    // 기준 레코드는 범위만 확인
+    if ((long long)(r->offset + r->len) > data_size)
+        return 0;
+    if (r->len == 0)
+        return 1;
+
+    uint32_t crc = 0;
+    uint32_t done = 0;
+    while (done < r->len)
+    {
+        uint32_t want = r->len - done < VERIFY_BUF ? r->len - done : VERIFY_BUF;
+        if (pread(data_fd, buf, want, r->offset + done) != (ssize_t)want)
+            return 0;
+        crc = crc32_update(crc, buf, want);
+        done += want;
+    }
+    return crc == r->crc;
+}
+
+// 저널의 마지막 레코드들을 검증하고 수신 구간을 복구
+long long journal_recover(const char *journal_path, const char *data_path, ExtentMap *extents)
+{
+    int jfd = open(journal_path, O_RDWR);
+    if (jfd < 0)
+        return -1;
+
+    int dfd = open(data_path, O_RDWR);
+    struct stat st;
+    long long data_size = 0;
+    if (dfd >= 0 && fstat(dfd, &st) == 0)
+        data_size = st.st_size;
+
+    long nrec = 0;
+    if (fstat(jfd, &st) == 0)
+        nrec = st.st_size / sizeof(JournalRecord);
+
+    // 끝에서부터 검사: 마지막 JOURNAL_VERIFY_TAIL개는 각각 검증해서 실패한 것만 버리고,
+    // 그 범위에서 하나도 검증되지 않으면 검증되는 레코드가 나올 때까지 앞쪽으로 계속 검사
+    // (찢어진 마지막 레코드의 꼬리 바이트는 nrec 계산에서 버려짐)
+    char *buf = malloc(VERIFY_BUF);
+    JournalRecord tail[JOURNAL_VERIFY_TAIL];
+    int tail_ok[JOURNAL_VERIFY_TAIL];
+    int tail_cnt = 0;
+    long trusted = nrec;
+    int found = 0;
+
+    for (long i = nrec - 1; i >= 0; i--)
+    {
+        if (found && i < nrec - JOURNAL_VERIFY_TAIL)
+            break;
+
+        JournalRecord r;
+        int ok = buf && dfd >= 0 &&
+                 pread(jfd, &r, sizeof(r), i * (off_t)sizeof(r)) == (ssize_t)sizeof(r) &&
+                 verify_record(dfd, data_size, &r, buf);
+        trusted = i;
+
+        // 꼬리 범위 안의 레코드는 결과를 기억 (나중에 검증된 것만 다시 기록)
+        if (i >= nrec - JOURNAL_VERIFY_TAIL)
+        {
+            tail[nrec - 1 - i] = r;
+            tail_ok[nrec - 1 - i] = ok;
+            tail_cnt = nrec - i;
+        }
+        if (ok)
+        {
+            found = 1;
+            if (i < nrec - JOURNAL_VERIFY_TAIL)
+            {
+                // 꼬리 범위 밖에서 찾은 경우: 이 레코드까지 신뢰하고 꼬리는 모두 버림
+                trusted = i + 1;
+                tail_cnt = 0;
+                break;
+            }
+        }
+    }
+    if (!found)
+    {
+        trusted = 0;
+        tail_cnt = 0;
+    }
+    free(buf);
+
+    // 신뢰 구간 [0, trusted) 의 레코드로 수신 구간 복원 (검증 없이 읽기만 함)
+    JournalRecord batch[256];
+    for (long i = 0; i < trusted; i += 256)
+    {
+        long want = trusted - i < 256 ? trusted - i : 256;
+        ssize_t n = pread(jfd, batch, want * sizeof(JournalRecord), i * (off_t)sizeof(JournalRecord));
+        for (long k = 0; n > 0 && k < n / (long)sizeof(JournalRecord); k++)
+        {
+            if (batch[k].len == 0)
+                extent_add(extents, 0, batch[k].offset);
+            else
+                extent_add(extents, batch[k].offset, batch[k].offset + batch[k].len);
+        }
+    }
+
+    // 검증된 꼬리 레코드만 원래 순서대로 다시 기록하고 나머지는 잘라냄
+    off_t jend = trusted * (off_t)sizeof(JournalRecord);
+    for (int k = tail_cnt - 1; k >= 0; k--)
+    {
+        if (!tail_ok[k] || (long)(nrec - 1 - k) < trusted)
+            continue;
+        if (pwrite(jfd, &tail[k], sizeof(JournalRecord), jend) == (ssize_t)sizeof(JournalRecord))
+            jend += sizeof(JournalRecord);
+        if (tail[k].len == 0)
+            extent_add(extents, 0, tail[k].offset);
+        else
+            extent_add(extents, tail[k].offset, tail[k].offset + tail[k].len);
+    }
+    ftruncate(jfd, jend);
+    close(jfd);
+
+    // 검증되지 않은 꼬리 데이터 제거
+    if (dfd >= 0)
+    {
+        long long end = extent_max_end(extents);
+        if (data_size > end)
+            ftruncate(dfd, end);
+        close(dfd);
+    }
+    return extent_prefix(extents);
+}
+
+// 복구 후 저널을 최소 레코드로 다시 작성
+long long journal_compact(const char *journal_path, const char *data_path, ExtentMap *extents)
+{
+    long long prefix = journal_recover(journal_path, data_path, extents);
+    if (prefix < 0)
+        return -1;
+
+    // 임시 파일에 새로 쓴 뒤 rename으로 교체 (중간에 죽어도 원래 저널 유지)
+    char tmp[600];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", journal_path);
+    int jfd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int dfd = open(data_path, O_RDONLY);
+    char *buf = malloc(VERIFY_BUF);
+    int ok = jfd >= 0 && dfd >= 0 && buf;
+
+    // 0부터 연속된 구간은 기준 레코드 하나로 대체
+    if (ok && prefix > 0)
+        ok = journal_append_base(jfd, prefix) == 0;
+
+    // 그 뒤의 구간은 CRC를 다시 계산해서 구간마다 레코드 작성 (len은 32비트라 나눠서 기록)
+    for (int i = 0; ok && i < extents->n; i++)
+    {
+        long long start = extents->v[i].start;
+        long long end = extents->v[i].end;
+        if (start < prefix)
+            start = prefix;
+
+        while (ok && start < end)
+        {
+            uint32_t len = end - start > JOURNAL_MAX_RECORD ? JOURNAL_MAX_RECORD : (uint32_t)(end - start);
+            uint32_t crc = 0;
+            for (uint32_t done = 0; ok && done < len;)
+            {
+                uint32_t want = len - done < VERIFY_BUF ? len - done : VERIFY_BUF;
+                ok = pread(dfd, buf, want, start + done) == (ssize_t)want;
+                crc = crc32_update(crc, buf, want);
+                done += want;
+            }
+            if (ok)
+                ok = journal_append_crc(jfd, start, len, crc) == 0;
+            start += len;
+        }
+    }
+
+    if (ok)
+        ok = fsync(jfd) == 0 && rename(tmp, journal_path) == 0;
+    if (!ok && jfd >= 0)
+        unlink(tmp);
+
+    free(buf);
+    if (jfd >= 0)
+        close(jfd);
+    if (dfd >= 0)
+        close(dfd);
+    return ok ? prefix : -1;
+}
@@ -0,0 +1,50 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "extent.h"
+
+// 복구 시 각각 데이터까지 검증하는 마지막 레코드 수
+#define JOURNAL_VERIFY_TAIL 8
+
+// 레코드 하나가 가리킬 수 있는 최대 길이 (압축 시 큰 구간은 나눠서 기록)
+#define JOURNAL_MAX_RECORD (1U << 30)
+
+// 청크 하나의 저널 레코드
+// len == 0 이면 저널 생성 전에 이미 있던 데이터의 기준 오프셋(검증 없이 신뢰)
+typedef struct
+{
+    uint64_t offset;
+    uint32_t len;
+    uint32_t crc;     // 데이터 [offset, offset+len) 의 CRC32
+    uint32_t rec_crc; // 위 필드들의 CRC32 (찢어진 레코드 검출)
+    uint32_t pad;
+} JournalRecord;
+
+// CRC32 (IEEE) 계산, 이어서 계산할 때는 이전 값을 crc로 전달
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len);
+
+// 저널 파일 열기 (이어쓰기), 실패 시 -1
+int journal_open(const char *path);
+
+// 청크 기록 (데이터를 파일에 쓴 직후 호출)
+int journal_append(int fd, long long offset, uint32_t len, const void *data);
+
+// CRC를 이미 계산한 청크 기록 (mmap 수신 경로)
+int journal_append_crc(int fd, long long offset, uint32_t len, uint32_t crc);
+
+// 기준 오프셋 레코드 기록 (저널 없이 존재하던 파일)
+int journal_append_base(int fd, long long offset);
+
+// 저널의 마지막 레코드들을 검증하고, 살아남은 레코드로 수신 구간(extents)을 복원
+// 검증에 실패한 꼬리 레코드와 마지막 구간 뒤의 데이터는 잘라냄
+// 이어받기 오프셋(0부터 연속된 구간의 끝) 반환, 저널이 없으면 -1
+long long journal_recover(const char *journal_path, const char *data_path, ExtentMap *extents);
+
+// 복구 후 저널을 (기준 레코드 + 구간별 레코드)로 다시 작성해서 크기를 줄임
+// 아무도 쓰지 않는 파일에만 호출, 이어받기 오프셋 반환, 실패 시 -1
+long long journal_compact(const char *journal_path, const char *data_path, ExtentMap *extents);
+
+#endif
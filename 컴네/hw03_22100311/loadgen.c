@@ -0,0 +1,597 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+// 한 프로세스에서 수천 개의 업로드를 이벤트 루프로 동시에 흉내 내는 부하 생성기
+// 전송 중 임의로 연결을 끊어 RESUME 경로를 반복해서 태우고, 결과를 JSON으로 출력
+
+#define PATTERN_LEN (1024 * 1024)
+#define RETRY_DELAY 0.1
+#define MAX_RETRIES 50
+
+// 업로더 상태
+#define ST_CONNECTING 0
+#define ST_SEND 1
+#define ST_WAIT 2
+#define ST_RETRY 3
+#define ST_DONE 4
+#define ST_FAILED 5
+
+// 가상 업로더 하나 (client_config.c 의 업로드 흐름을 비블로킹으로 수행)
+typedef struct
+{
+    int id;
+    int sd;
+    int state;
+    char filename[32];
+
+    long long size;
+    long long offset; // 서버가 ACK한 오프셋
+    int started;      // FIRST를 보냈는지 (이후 재접속은 RESUME)
+    int fin_sent;
+
+    // 보낼 명령 헤더와 뒤따르는 DATA 페이로드
+    char out[128];
+    int out_len;
+    int out_sent;
+    long long payload_len;
+    long long payload_sent;
+
+    // 이 요청을 보내다가 끊을 위치 (헤더+페이로드 기준 바이트, -1이면 끊지 않음)
+    long long drop_at;
+
+    // 응답 한 줄 수신 버퍼
+    char in[128];
+    int in_len;
+
+    // 끊긴 뒤 RESUME 응답까지 걸린 시간 측정
+    int resuming;
+    double drop_time;
+    double retry_at;
+    int retries;
+} Uploader;
+
+// 실행 설정
+static const char *server_ip;
+static int server_port;
+static int uploader_cnt = 1000;
+static long long file_size = 256 * 1024;
+static long long chunk_size = 16 * 1024;
+static double drop_prob = 0.01;
+static int server_pid = 0;
+static unsigned long long rng = 88172645463325252ULL;
+
+static char client_id[64];
+static char pattern[PATTERN_LEN];
+static int epfd;
+
+// 결과 집계
+static long long total_acked = 0;
+static long drops = 0, errors = 0, resumes = 0;
+static double *ttr = NULL;
+static long ttr_cnt = 0, ttr_cap = 0;
+
+// 단조 시계 (초)
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64 난수 (시드가 같으면 같은 끊김 패턴 재현)
+static unsigned long long rand_next(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+static double rand_unit(void)
+{
+    return (rand_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// RESUME 응답까지 걸린 시간 기록
+static void add_ttr(double sec)
+{
+    if (ttr_cnt == ttr_cap)
+    {
+        long cap = ttr_cap ? ttr_cap * 2 : 1024;
+        double *p = realloc(ttr, sizeof(double) * cap);
+        if (!p)
+            return;
+        ttr = p;
+        ttr_cap = cap;
+    }
+    ttr[ttr_cnt++] = sec;
+}
+
+// epoll 관심 이벤트 변경
+static void watch(Uploader *u, unsigned int events)
+{
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = u;
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, u->sd, &ev) < 0)
+        epoll_ctl(epfd, EPOLL_CTL_ADD, u->sd, &ev);
+}
+
+// 소켓 닫기 (epoll에서도 자동으로 빠짐)
+static void drop_socket(Uploader *u)
+{
+    if (u->sd >= 0)
+        close(u->sd);
+    u->sd = -1;
+}
+
+// 비블로킹 접속 시작
+static void start_connect(Uploader *u)
+{
+    u->sd = socket(PF_INET, SOCK_STREAM, 0);
+    if (u->sd < 0)
+    {
+        u->state = ST_RETRY;
+        u->retry_at = now_sec() + RETRY_DELAY;
+        return;
+    }
+    fcntl(u->sd, F_SETFL, fcntl(u->sd, F_GETFL) | O_NONBLOCK);
+
+    // 헤더와 페이로드를 따로 쓰므로 Nagle 지연이 측정값에 섞이지 않도록 끔
+    int one = 1;
+    setsockopt(u->sd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in serv;
+    memset(&serv, 0, sizeof(serv));
+    serv.sin_family = AF_INET;
+    serv.sin_addr.s_addr = inet_addr(server_ip);
+    serv.sin_port = htons(server_port);
+
+    u->state = ST_CONNECTING;
+    u->in_len = 0;
+    if (connect(u->sd, (struct sockaddr *)&serv, sizeof(serv)) < 0 && errno != EINPROGRESS)
+    {
+        drop_socket(u);
+        u->state = ST_RETRY;
+        u->retry_at = now_sec() + RETRY_DELAY;
+        return;
+    }
+    watch(u, EPOLLOUT);
+}
+
+// 오류로 연결이 끊긴 경우 잠시 후 다시 접속 (재시도가 너무 많으면 실패 처리)
+static void fail_connection(Uploader *u)
+{
+    drop_socket(u);
+    errors++;
+    if (++u->retries > MAX_RETRIES)
+    {
+        u->state = ST_FAILED;
+        return;
+    }
+    if (!u->resuming)
+    {
+        u->resuming = 1;
+        u->drop_time = now_sec();
+    }
+    u->state = ST_RETRY;
+    u->retry_at = now_sec() + RETRY_DELAY;
+}
+
+// 명령 전송 준비 (payload_len > 0 이면 DATA 페이로드가 뒤따름)
+static void queue_request(Uploader *u, long long payload_len)
+{
+    u->out_sent = 0;
+    u->payload_len = payload_len;
+    u->payload_sent = 0;
+    u->drop_at = -1;
+
+    // DATA 전송 중 일정 확률로 임의 위치에서 연결을 끊음
+    if (payload_len > 0 && rand_unit() < drop_prob)
+        u->drop_at = rand_next() % (u->out_len + payload_len);
+
+    u->state = ST_SEND;
+    watch(u, EPOLLOUT);
+}
+
+// 현재 오프셋에 맞는 다음 명령 (DATA 또는 FIN)
+static void next_request(Uploader *u)
+{
+    if (u->offset >= u->size)
+    {
+        u->out_len = sprintf(u->out, "FIN\n");
+        u->fin_sent = 1;
+        queue_request(u, 0);
+        return;
+    }
+
+    long long n = u->size - u->offset;
+    if (n > chunk_size)
+        n = chunk_size;
+    u->out_len = sprintf(u->out, "DATA %lld\n", n);
+    queue_request(u, n);
+}
+
+// 접속 완료 후 FIRST 또는 RESUME 전송
+static void on_connected(Uploader *u)
+{
+    if (!u->started)
+    {
+        u->out_len = snprintf(u->out, sizeof(u->out), "FIRST %s %s %lld\n",
+                              client_id, u->filename, u->size);
+        u->started = 1;
+    }
+    else
+    {
+        u->out_len = snprintf(u->out, sizeof(u->out), "RESUME %s %s %lld\n",
+                              client_id, u->filename, u->size);
+    }
+    u->fin_sent = 0;
+    queue_request(u, 0);
+}
+
+// 헤더와 페이로드를 보낼 수 있는 만큼 전송
+static void on_writable(Uploader *u)
+{
+    while (1)
+    {
+        long long total_sent = u->out_sent + u->payload_sent;
+
+        // 정해둔 위치에 도달하면 전송 도중 연결을 끊음
+        if (u->drop_at >= 0 && total_sent >= u->drop_at)
+        {
+            drop_socket(u);
+            drops++;
+            u->resuming = 1;
+            u->drop_time = now_sec();
+            start_connect(u);
+            return;
+        }
+
+        const char *p;
+        size_t len;
+        if (u->out_sent < u->out_len)
+        {
+            p = u->out + u->out_sent;
+            len = u->out_len - u->out_sent;
+        }
+        else if (u->payload_sent < u->payload_len)
+        {
+            long long pos = (u->offset + u->payload_sent) % PATTERN_LEN;
+            p = pattern + pos;
+            len = PATTERN_LEN - pos;
+            if ((long long)len > u->payload_len - u->payload_sent)
+                len = u->payload_len - u->payload_sent;
+        }
+        else
+        {
+            // 요청을 모두 보냈으면 응답 대기
+            u->state = ST_WAIT;
+            watch(u, EPOLLIN);
+            return;
+        }
+
+        // 끊을 위치를 넘지 않도록 잘라서 전송
+        if (u->drop_at >= 0 && total_sent + (long long)len > u->drop_at)
+            len = u->drop_at - total_sent;
+
+        ssize_t n = write(u->sd, p, len);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (n <= 0)
+        {
+            fail_connection(u);
+            return;
+        }
+        if (u->out_sent < u->out_len)
+            u->out_sent += n;
+        else
+            u->payload_sent += n;
+    }
+}
+
+// 응답 한 줄 처리 (ACK <offset> 또는 COMPLETE)
+static void on_line(Uploader *u)
+{
+    long long ack;
+    if (strncmp(u->in, "COMPLETE", 8) == 0 && u->fin_sent)
+    {
+        drop_socket(u);
+        u->state = ST_DONE;
+        return;
+    }
+    if (sscanf(u->in, "ACK %lld", &ack) != 1)
+    {
+        fail_connection(u);
+        return;
+    }
+
+    if (ack > u->offset)
+        total_acked += ack - u->offset;
+    u->offset = ack;
+    u->retries = 0;
+    if (u->resuming)
+    {
+        add_ttr(now_sec() - u->drop_time);
+        resumes++;
+        u->resuming = 0;
+    }
+    next_request(u);
+}
+
+// 응답 수신
+static void on_readable(Uploader *u)
+{
+    while (1)
+    {
+        ssize_t n = read(u->sd, u->in + u->in_len, 1);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        if (n <= 0)
+        {
+            fail_connection(u);
+            return;
+        }
+
+        char c = u->in[u->in_len++];
+        if (c == '\n' || u->in_len >= (int)sizeof(u->in) - 1)
+        {
+            u->in[u->in_len] = '\0';
+            u->in_len = 0;
+            on_line(u);
+            return;
+        }
+    }
+}
+
+// 서버 프로세스가 사용한 CPU 시간 (초, /proc/<pid>/stat 의 utime + stime)
+static double server_cpu(void)
+{
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", server_pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    // 프로세스 이름에 공백이 있을 수 있으므로 마지막 ')' 다음부터 필드를 셈
+    char *p = strrchr(buf, ')');
+    unsigned long utime, stime;
+    if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2)
+        return -1;
+    return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+// 노드 간 메모리 할당 페이지 수 (모든 노드 합, /sys/devices/system/node/node<n>/numastat)
+//   local_node: 실행 중인 CPU의 노드에서 할당, other_node: 다른 노드 CPU가 이 노드 메모리를 할당
+typedef struct
+{
+    int nodes;
+    long long local_node;
+    long long other_node;
+} NumaStat;
+
+static void numa_sample(NumaStat *st)
+{
+    memset(st, 0, sizeof(*st));
+    for (int n = 0; n < 64; n++)
+    {
+        char path[64], key[32];
+        long long val;
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/numastat", n);
+        FILE *fp = fopen(path, "r");
+        if (!fp)
+            continue;
+        st->nodes++;
+        while (fscanf(fp, "%31s %lld", key, &val) == 2)
+        {
+            if (strcmp(key, "local_node") == 0)
+                st->local_node += val;
+            else if (strcmp(key, "other_node") == 0)
+                st->other_node += val;
+        }
+        fclose(fp);
+    }
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// 정렬된 배열의 백분위 값
+static double percentile(double q)
+{
+    if (ttr_cnt == 0)
+        return 0;
+    return ttr[(long)(q * (ttr_cnt - 1))];
+}
+
+// 메인 함수
+int main(int argc, char *argv[])
+{
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:c:d:P:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            uploader_cnt = atoi(optarg);
+            break;
+        case 's':
+            file_size = atoll(optarg);
+            break;
+        case 'c':
+            chunk_size = atoll(optarg);
+            break;
+        case 'd':
+            drop_prob = atof(optarg);
+            break;
+        case 'P':
+            server_pid = atoi(optarg);
+            break;
+        case 'r':
+            rng = strtoull(optarg, NULL, 10) | 1;
+            break;
+        default:
+            argc = 0;
+            break;
+        }
+    }
+
+    if (argc - optind != 2 || uploader_cnt < 1 || file_size < 0 || chunk_size < 1)
+    {
+        printf("Usage: %s [-n uploaders] [-s file_bytes] [-c chunk_bytes] [-d drop_prob] [-P server_pid] [-r seed] <IP> <port>\n", argv[0]);
+        printf("  -n  동시에 업로드하는 가상 클라이언트 수 (기본 1000)\n");
+        printf("  -s  업로더마다 보내는 파일 크기 (기본 262144)\n");
+        printf("  -c  DATA 청크 크기 (기본 16384)\n");
+        printf("  -d  DATA 하나를 보내다가 연결을 끊을 확률 (기본 0.01)\n");
+        printf("  -P  서버 PID (지정하면 GB당 서버 CPU 시간을 측정)\n");
+        printf("  -r  끊김 패턴 난수 시드\n");
+        exit(1);
+    }
+    server_ip = argv[optind];
+    server_port = atoi(argv[optind + 1]);
+    snprintf(client_id, sizeof(client_id), "lg%d", (int)getpid());
+    signal(SIGPIPE, SIG_IGN);
+
+    // 업로더 수만큼 소켓을 열 수 있도록 fd 한도를 올림
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    for (int i = 0; i < PATTERN_LEN; i++)
+        pattern[i] = rand_next() & 0xff;
+
+    Uploader *ups = calloc(uploader_cnt, sizeof(Uploader));
+    struct epoll_event *events = malloc(sizeof(struct epoll_event) * 1024);
+    epfd = epoll_create1(0);
+    if (!ups || !events || epfd < 0)
+    {
+        perror("init");
+        exit(1);
+    }
+
+    double cpu_start = server_pid > 0 ? server_cpu() : -1;
+    NumaStat numa_start, numa_end;
+    numa_sample(&numa_start);
+    double start = now_sec();
+
+    for (int i = 0; i < uploader_cnt; i++)
+    {
+        Uploader *u = &ups[i];
+        u->id = i;
+        u->sd = -1;
+        u->size = file_size;
+        snprintf(u->filename, sizeof(u->filename), "f%d.bin", i);
+        start_connect(u);
+    }
+
+    // 이벤트 루프: 모든 업로더가 완료(또는 실패)할 때까지
+    int active = uploader_cnt;
+    while (active > 0)
+    {
+        int n = epoll_wait(epfd, events, 1024, 50);
+        for (int i = 0; i < n; i++)
+        {
+            Uploader *u = events[i].data.ptr;
+            if (u->sd < 0)
+                continue;
+
+            if (u->state == ST_CONNECTING)
+            {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(u->sd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err != 0)
+                    fail_connection(u);
+                else
+                    on_connected(u);
+            }
+            else if (u->state == ST_SEND)
+            {
+                on_writable(u);
+            }
+            else if (u->state == ST_WAIT)
+            {
+                on_readable(u);
+            }
+        }
+
+        // 재접속 대기 시간이 지난 업로더 재시도, 끝난 업로더 집계
+        double now = now_sec();
+        active = 0;
+        for (int i = 0; i < uploader_cnt; i++)
+        {
+            Uploader *u = &ups[i];
+            if (u->state == ST_RETRY && now >= u->retry_at)
+                start_connect(u);
+            if (u->state != ST_DONE && u->state != ST_FAILED)
+                active++;
+        }
+    }
+
+    double elapsed = now_sec() - start;
+    double cpu_end = server_pid > 0 ? server_cpu() : -1;
+    numa_sample(&numa_end);
+
+    int completed = 0, failed = 0;
+    for (int i = 0; i < uploader_cnt; i++)
+    {
+        if (ups[i].state == ST_DONE)
+            completed++;
+        else
+            failed++;
+    }
+    qsort(ttr, ttr_cnt, sizeof(double), cmp_double);
+    double ttr_sum = 0;
+    for (long i = 0; i < ttr_cnt; i++)
+        ttr_sum += ttr[i];
+
+    // 결과를 JSON 한 개로 출력 (회귀 추적용)
+    double gb = total_acked / 1e9;
+    printf("{\n");
+    printf("  \"config\": {\"uploaders\": %d, \"file_bytes\": %lld, \"chunk_bytes\": %lld, \"drop_prob\": %g},\n",
+           uploader_cnt, file_size, chunk_size, drop_prob);
+    printf("  \"elapsed_sec\": %.3f,\n", elapsed);
+    printf("  \"bytes_acked\": %lld,\n", total_acked);
+    printf("  \"throughput_MBps\": %.2f,\n", elapsed > 0 ? total_acked / 1e6 / elapsed : 0);
+    printf("  \"uploads\": {\"completed\": %d, \"failed\": %d},\n", completed, failed);
+    printf("  \"drops_injected\": %ld,\n", drops);
+    printf("  \"connection_errors\": %ld,\n", errors);
+    printf("  \"time_to_resume_ms\": {\"count\": %ld, \"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+           resumes, ttr_cnt ? ttr_sum / ttr_cnt * 1e3 : 0, percentile(0.50) * 1e3,
+           percentile(0.99) * 1e3, percentile(1.0) * 1e3);
+    // 실행 중 시스템 전체의 노드 간 할당 (서버 -A 로 고정했을 때와 비교)
+    long long local = numa_end.local_node - numa_start.local_node;
+    long long other = numa_end.other_node - numa_start.other_node;
+    printf("  \"numa\": {\"nodes\": %d, \"local_node_pages\": %lld, \"other_node_pages\": %lld, \"cross_node_pct\": %.2f},\n",
+           numa_end.nodes, local, other, local + other > 0 ? 100.0 * other / (local + other) : 0);
+    if (cpu_start >= 0 && cpu_end >= 0)
+        printf("  \"server_cpu_sec\": %.3f,\n  \"server_cpu_sec_per_GB\": %.3f\n",
+               cpu_end - cpu_start, gb > 0 ? (cpu_end - cpu_start) / gb : 0);
+    else
+        printf("  \"server_cpu_sec\": null,\n  \"server_cpu_sec_per_GB\": null\n");
+    printf("}\n");
+
+    free(ups);
+    free(events);
+    free(ttr);
+    return failed > 0 ? 1 : 0;
+}
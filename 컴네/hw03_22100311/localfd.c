@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "netio.h"
+#include "localfd.h"
+
+// 대체 복사 버퍼 크기
+#define COPY_BUF (256 * 1024)
+
+// 소켓 경로를 sockaddr_un에 채우기 (경로가 너무 길면 -1)
+static int unix_addr(struct sockaddr_un *addr, const char *path)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr->sun_path))
+        return -1;
+    strcpy(addr->sun_path, path);
+    return 0;
+}
+
+// 유닉스 도메인 소켓 경로에서 연결 대기
+int unix_listen(const char *path)
+{
+    struct sockaddr_un addr;
+    if (unix_addr(&addr, path) < 0)
+        return -1;
+
+    int sd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sd < 0)
+        return -1;
+
+    // 이전 실행이 남긴 소켓 파일 제거
+    unlink(path);
+    if (bind(sd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sd, SOMAXCONN) < 0)
+    {
+        close(sd);
+        return -1;
+    }
+    return sd;
+}
+
+// 유닉스 도메인 소켓 경로로 접속
+int unix_connect(const char *path)
+{
+    struct sockaddr_un addr;
+    if (unix_addr(&addr, path) < 0)
+        return -1;
+
+    int sd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sd < 0)
+        return -1;
+    if (connect(sd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(sd);
+        return -1;
+    }
+    return sd;
+}
+
+// 첫 바이트에 디스크립터를 붙여 보내고 나머지는 일반 write로 전송
+int send_with_fd(int sd, const void *buf, size_t len, int fd)
+{
+    char ctrl[CMSG_SPACE(sizeof(int))];
+    memset(ctrl, 0, sizeof(ctrl));
+
+    struct iovec iov;
+    iov.iov_base = (void *)buf;
+    iov.iov_len = len;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    struct cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+
+    ssize_t n = sendmsg(sd, &msg, MSG_NOSIGNAL);
+    if (n <= 0)
+        return -1;
+    return write_all(sd, (const char *)buf + n, len - n);
+}
+
+// 데이터와 함께 온 SCM_RIGHTS 디스크립터 수신
+// (일반 read로 읽으면 커널이 붙어 온 디스크립터를 버리므로 유닉스 소켓은 항상 이 함수로 읽음)
+ssize_t recv_with_fd(int sd, void *buf, size_t len, int *fd)
+{
+    char ctrl[CMSG_SPACE(sizeof(int))];
+
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+
+    ssize_t n = recvmsg(sd, &msg, MSG_CMSG_CLOEXEC);
+    if (n <= 0)
+        return n;
+
+    for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+    {
+        if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS &&
+            cm->cmsg_len == CMSG_LEN(sizeof(int)))
+        {
+            int got;
+            memcpy(&got, CMSG_DATA(cm), sizeof(int));
+
+            // 이전에 받고 쓰지 않은 디스크립터는 닫고 새 것으로 교체
+            if (*fd >= 0)
+                close(*fd);
+            *fd = got;
+        }
+    }
+    return n;
+}
+
+// pread/pwrite로 복사 (copy_file_range를 쓸 수 없는 커널/파일시스템 조합)
+static int copy_range_rw(int in_fd, int out_fd, long long offset, long long len)
+{
+    char *buf = malloc(COPY_BUF);
+    if (!buf)
+        return -1;
+
+    for (long long done = 0; done < len;)
+    {
+        size_t want = len - done < COPY_BUF ? (size_t)(len - done) : COPY_BUF;
+        if (pread_all(in_fd, buf, want, offset + done) < 0 ||
+            pwrite_all(out_fd, buf, want, offset + done) < 0)
+        {
+            free(buf);
+            return -1;
+        }
+        done += want;
+    }
+    free(buf);
+    return 0;
+}
+
+// 커널 안에서 파일 대 파일 복사
+// 같은 파일시스템이 reflink를 지원하면(btrfs, XFS 등) 데이터 블록을 공유해서 복사가 거의 없음
+int copy_range(int in_fd, int out_fd, long long offset, long long len)
+{
+    loff_t in_off = offset, out_off = offset;
+    long long done = 0;
+
+    while (done < len)
+    {
+        long long want = len - done < MAX_CHUNK_SIZE ? len - done : MAX_CHUNK_SIZE;
+        ssize_t n = copy_file_range(in_fd, &in_off, out_fd, &out_off, (size_t)want, 0);
+
+        // 원본이 생각보다 짧음
+        if (n == 0)
+            return -1;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            // 지원하지 않는 조합(다른 파일시스템, 오래된 커널 등)은 남은 구간을 일반 복사
+            if (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)
+                return copy_range_rw(in_fd, out_fd, offset + done, len - done);
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef LOCALFD_H
+#define LOCALFD_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// 같은 호스트 업로드: 유닉스 도메인 소켓으로 원본 파일 디스크립터를 넘기고
+// 서버가 파일 대 파일 복사(copy_file_range, 지원하는 파일시스템은 reflink)로 저장
+
+// 유닉스 도메인 소켓 경로에서 연결 대기 (남아 있는 소켓 파일은 지우고 다시 만듦), 실패 시 -1
+int unix_listen(const char *path);
+
+// 유닉스 도메인 소켓 경로로 접속, 실패 시 -1
+int unix_connect(const char *path);
+
+// buf 전체를 전송하면서 파일 디스크립터 fd를 SCM_RIGHTS로 함께 전달 (성공 0, 실패 -1)
+int send_with_fd(int sd, const void *buf, size_t len, int fd);
+
+// 최대 len 바이트 수신, 함께 전달된 디스크립터가 있으면 *fd에 저장 (없으면 그대로 둠)
+// 읽은 길이 반환, 연결 종료 0, 오류 -1
+ssize_t recv_with_fd(int sd, void *buf, size_t len, int *fd);
+
+// in_fd의 [offset, offset+len) 을 out_fd의 같은 위치로 복사 (성공 0, 실패 -1)
+// 커널 안에서 복사하고, 지원하지 않는 조합이면 pread/pwrite로 대체
+int copy_range(int in_fd, int out_fd, long long offset, long long len);
+
+#endif
@@ -0,0 +1,178 @@
+#include <string.h>
+#include <stdint.h>
+
+#include "lz.h"
+
+#define HASH_BITS 13
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+
+// 끝부분 제한: 마지막 LAST_LITERALS 바이트는 항상 리터럴, 일치는 끝에서 MATCH_LIMIT 바이트 전까지만 시작
+#define LAST_LITERALS 5
+#define MATCH_LIMIT 12
+
+static uint32_t read32(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static uint32_t hash32(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - HASH_BITS);
+}
+
+// 15 이상 길이의 나머지를 255 단위로 기록
+static unsigned char *put_length(unsigned char *op, size_t len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+// 시퀀스 하나 기록 (mlen == 0 이면 마지막 리터럴만), 공간이 부족하면 NULL
+static unsigned char *put_sequence(unsigned char *op, unsigned char *oend, const unsigned char *lit,
+                                   size_t lit_len, size_t offset, size_t mlen)
+{
+    size_t need = 1 + lit_len / 255 + 1 + lit_len + (mlen ? 2 + mlen / 255 + 1 : 0);
+    if (need > (size_t)(oend - op))
+        return NULL;
+
+    unsigned char *token = op++;
+    *token = (unsigned char)((lit_len < 15 ? lit_len : 15) << 4);
+    if (lit_len >= 15)
+        op = put_length(op, lit_len - 15);
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (mlen)
+    {
+        *op++ = (unsigned char)(offset & 0xff);
+        *op++ = (unsigned char)(offset >> 8);
+        size_t m = mlen - MIN_MATCH;
+        *token |= (unsigned char)(m < 15 ? m : 15);
+        if (m >= 15)
+            op = put_length(op, m - 15);
+    }
+    return op;
+}
+
+// 압축 - 4바이트 해시로 이전 위치를 찾아 일치를 앞뒤로 늘림
+// 일치가 없는 구간이 길어질수록 건너뛰는 폭을 늘려 압축되지 않는 데이터에서 빨리 포기
+size_t lz_compress(const void *src, size_t n, void *dst, size_t cap)
+{
+    const unsigned char *in = src;
+    const unsigned char *end = in + n;
+    const unsigned char *ip = in, *anchor = in;
+    unsigned char *op = dst, *oend = op + cap;
+    uint32_t table[1 << HASH_BITS];
+
+    if (n > MATCH_LIMIT)
+    {
+        memset(table, 0, sizeof(table));
+        const unsigned char *mlimit = end - MATCH_LIMIT;
+        ip++;
+        while (ip < mlimit)
+        {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash32(seq);
+            const unsigned char *ref = in + table[h];
+            table[h] = (uint32_t)(ip - in);
+            if (ref >= ip || ip - ref > MAX_OFFSET || read32(ref) != seq)
+            {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            // 앞쪽 리터럴과 겹치는 부분까지 일치를 뒤로 늘림
+            while (ip > anchor && ref > in && ip[-1] == ref[-1])
+            {
+                ip--;
+                ref--;
+            }
+            const unsigned char *mend = ip + MIN_MATCH;
+            const unsigned char *r = ref + MIN_MATCH;
+            while (mend < end - LAST_LITERALS && *mend == *r)
+            {
+                mend++;
+                r++;
+            }
+
+            op = put_sequence(op, oend, anchor, ip - anchor, ip - ref, mend - ip);
+            if (!op)
+                return 0;
+            ip = anchor = mend;
+        }
+    }
+
+    op = put_sequence(op, oend, anchor, end - anchor, 0, 0);
+    return op ? (size_t)(op - (unsigned char *)dst) : 0;
+}
+
+// 추가 길이 읽기 (255가 이어지는 동안 누적)
+static int get_length(const unsigned char **ip, const unsigned char *iend, size_t *len)
+{
+    unsigned b;
+    do
+    {
+        if (*ip >= iend)
+            return -1;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 0;
+}
+
+// 압축 해제 - 모든 길이와 거리를 입력/출력 범위 안에서 검증 (신뢰할 수 없는 네트워크 입력)
+long long lz_decompress(const void *src, size_t n, void *dst, size_t cap)
+{
+    const unsigned char *ip = src, *iend = ip + n;
+    unsigned char *out = dst, *op = out, *oend = out + cap;
+
+    while (ip < iend)
+    {
+        unsigned token = *ip++;
+
+        size_t lit = token >> 4;
+        if (lit == 15 && get_length(&ip, iend, &lit) < 0)
+            return -1;
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op))
+            return -1;
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        // 마지막 시퀀스는 리터럴로 끝남
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return -1;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - out))
+            return -1;
+
+        size_t mlen = token & 15;
+        if (mlen == 15 && get_length(&ip, iend, &mlen) < 0)
+            return -1;
+        mlen += MIN_MATCH;
+        if (mlen > (size_t)(oend - op))
+            return -1;
+
+        // 거리가 길이보다 짧으면 방금 쓴 바이트를 다시 읽어야 하므로 한 바이트씩 복사
+        const unsigned char *ref = op - offset;
+        if (offset >= mlen)
+            memcpy(op, ref, mlen);
+        else
+            for (size_t i = 0; i < mlen; i++)
+                op[i] = ref[i];
+        op += mlen;
+    }
+    return op - out;
+}
@@ -0,0 +1,21 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stddef.h>
+
+// 청크 압축 코덱: LZ4 블록 형식과 같은 구조의 빠른 LZ77 (해시 테이블 하나, 엔트로피 코딩 없음)
+//   시퀀스 = 토큰(리터럴 길이 4비트 | 일치 길이-4 4비트) + 추가 길이 + 리터럴 + 거리(2바이트 LE) + 추가 길이
+//   마지막 시퀀스는 리터럴만 있음
+// FIRST/RESUME 끝에 코덱 이름을 붙여 협상하고, 압축한 청크는 ZDATA <원본 길이> <압축 길이> 로 전송
+#define LZ_CODEC "lz"
+
+// ZDATA 청크 하나의 원본 최대 크기 (서버가 압축 해제 버퍼로 한 번에 할당)
+#define LZ_CHUNK_MAX (1024 * 1024)
+
+// src의 n 바이트를 압축해서 dst에 기록, 압축 크기 반환 (cap 안에 들어가지 않으면 0)
+size_t lz_compress(const void *src, size_t n, void *dst, size_t cap);
+
+// 압축 해제, 풀어낸 크기 반환 (형식이 잘못됐거나 cap을 넘으면 -1)
+long long lz_decompress(const void *src, size_t n, void *dst, size_t cap);
+
+#endif
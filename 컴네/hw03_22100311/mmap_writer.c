@@ -0,0 +1,135 @@
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "journal.h"
+#include "mmap_writer.h"
+
+// 현재 윈도우를 비동기로 flush하고 페이지 캐시 매핑을 놓아줌
+static void retire_window(MmapWriter *mw)
+{
+    if (!mw->map)
+        return;
+
+    msync(mw->map, mw->map_len, MS_ASYNC);
+    madvise(mw->map, mw->map_len, MADV_DONTNEED);
+    munmap(mw->map, mw->map_len);
+    mw->map = NULL;
+    mw->map_len = 0;
+}
+
+// offset을 포함하는 윈도우 매핑
+// (파일 끝을 넘는 부분도 매핑은 되지만 접근 전에 ensure_size로 파일을 늘려야 함)
+static int map_window(MmapWriter *mw, long long offset)
+{
+    long long base = offset - offset % MMAP_WINDOW;
+
+    if (mw->map && base == mw->map_base)
+        return 0;
+    retire_window(mw);
+
+    char *p = mmap(NULL, MMAP_WINDOW, PROT_READ | PROT_WRITE, MAP_SHARED, mw->fd, base);
+    if (p == MAP_FAILED)
+        return -1;
+    madvise(p, MMAP_WINDOW, MADV_SEQUENTIAL);
+
+    mw->map = p;
+    mw->map_base = base;
+    mw->map_len = MMAP_WINDOW;
+    return 0;
+}
+
+// 예상 크기를 넘는 데이터는 필요한 만큼 파일을 늘려서 수용
+// (같은 파일을 다른 연결이 늘렸을 수 있으므로 실제 크기를 다시 확인)
+static int ensure_size(MmapWriter *mw, long long end)
+{
+    if (end <= mw->size)
+        return 0;
+
+    struct stat st;
+    if (fstat(mw->fd, &st) == 0)
+        mw->size = st.st_size;
+    if (end > mw->size)
+    {
+        if (ftruncate(mw->fd, end) < 0)
+            return -1;
+        mw->size = end;
+    }
+    return 0;
+}
+
+// 파일을 열고 expected_size 만큼 미리 할당
+int mmap_writer_open(MmapWriter *mw, const char *path, long long expected_size)
+{
+    memset(mw, 0, sizeof(*mw));
+    mw->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (mw->fd < 0)
+        return -1;
+
+    struct stat st;
+    if (fstat(mw->fd, &st) < 0)
+    {
+        close(mw->fd);
+        return -1;
+    }
+    mw->size = st.st_size;
+
+    // 블록을 미리 확보해서 수신 중 할당/단편화를 줄임
+    if (expected_size > mw->size)
+    {
+        if (posix_fallocate(mw->fd, 0, expected_size) != 0 &&
+            ftruncate(mw->fd, expected_size) < 0)
+        {
+            close(mw->fd);
+            return -1;
+        }
+        mw->size = expected_size;
+    }
+    return 0;
+}
+
+// 소켓에서 매핑으로 직접 수신 (사용자 버퍼 -> 파일 복사 제거)
+int mmap_writer_recv(MmapWriter *mw, int sd, long long offset, size_t len, uint32_t *crc)
+{
+    *crc = 0;
+    while (len > 0)
+    {
+        if (map_window(mw, offset) < 0)
+            return -1;
+
+        char *dst = mw->map + (offset - mw->map_base);
+        size_t room = mw->map_base + mw->map_len - offset;
+        size_t want = len < room ? len : room;
+        if (ensure_size(mw, offset + want) < 0)
+            return -1;
+
+        size_t received = 0;
+        while (received < want)
+        {
+            ssize_t n = read(sd, dst + received, want - received);
+            if (n <= 0)
+                return -1;
+            received += n;
+        }
+
+        *crc = crc32_update(*crc, dst, want);
+        offset += want;
+        len -= want;
+    }
+    return 0;
+}
+
+// 윈도우를 정리하고 파일을 final_size로 맞춘 뒤 닫기
+void mmap_writer_close(MmapWriter *mw, long long final_size)
+{
+    if (mw->fd < 0)
+        return;
+
+    retire_window(mw);
+    if (final_size >= 0)
+        ftruncate(mw->fd, final_size);
+    close(mw->fd);
+    mw->fd = -1;
+}
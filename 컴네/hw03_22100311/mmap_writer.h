@@ -0,0 +1,29 @@
+#ifndef MMAP_WRITER_H
+#define MMAP_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 한 번에 매핑하는 윈도우 크기 (페이지 크기의 배수)
+#define MMAP_WINDOW (8 * 1024 * 1024)
+
+// 미리 할당한 파일을 슬라이딩 윈도우로 매핑해서 소켓에서 바로 수신
+typedef struct
+{
+    int fd;
+    long long size;     // 현재 파일 크기 (미리 할당된 크기)
+    char *map;          // 현재 윈도우 매핑 (없으면 NULL)
+    long long map_base; // 윈도우 시작 오프셋
+    size_t map_len;
+} MmapWriter;
+
+// 파일을 열고 expected_size 만큼 미리 할당, 실패 시 -1
+int mmap_writer_open(MmapWriter *mw, const char *path, long long expected_size);
+
+// 소켓에서 len 바이트를 offset 위치의 매핑으로 직접 수신, 수신한 데이터의 CRC32를 crc에 저장
+int mmap_writer_recv(MmapWriter *mw, int sd, long long offset, size_t len, uint32_t *crc);
+
+// 윈도우를 정리하고 파일을 final_size로 맞춘 뒤 닫기
+void mmap_writer_close(MmapWriter *mw, long long final_size);
+
+#endif
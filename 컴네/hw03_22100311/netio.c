@@ -0,0 +1,94 @@
+#include <unistd.h>
+#include "netio.h"
+
+// 전체 길이가 전송될 때까지 반복해서 write
+int write_all(int sd, const void *buf, size_t len)
+{
+    const char *p = buf;
+    size_t sent = 0;
+
+    while (sent < len)
+    {
+        ssize_t write_cnt = write(sd, p + sent, len - sent);
+
+        // 조건: 전송 실패 시 -1 반환
+        if (write_cnt <= 0)
+            return -1;
+        sent += write_cnt;
+    }
+    return 0;
+}
+
+// 전체 길이를 수신할 때까지 반복해서 read
+int read_all(int sd, void *buf, size_t len)
+{
+    char *p = buf;
+    size_t received = 0;
+
+    while (received < len)
+    {
+        ssize_t n = read(sd, p + received, len - received);
+
+        // 연결 종료 또는 오류
+        if (n <= 0)
+            return -1;
+        received += n;
+    }
+    return 0;
+}
+
+// 개행 문자까지 한 글자씩 읽어서 한 줄 생성
+int read_line(int sd, char *line, int size)
+{
+    int pos = 0;
+    int read_len;
+    char c;
+
+    while ((read_len = read(sd, &c, 1)) > 0)
+    {
+        line[pos++] = c;
+
+        // 개행 문자이거나 버퍼가 가득 찼으면 종료
+        if (c == '\n' || pos >= size - 1)
+            break;
+    }
+
+    // 아무것도 읽지 못하고 연결이 끊긴 경우
+    if (read_len <= 0 && pos == 0)
+        return -1;
+
+    line[pos] = '\0';
+    return pos;
+}
+
+// 파일의 지정 위치에 전체 길이를 쓰기
+int pwrite_all(int fd, const void *buf, size_t len, long long offset)
+{
+    const char *p = buf;
+    size_t done = 0;
+
+    while (done < len)
+    {
+        ssize_t n = pwrite(fd, p + done, len - done, offset + done);
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
+
+// 파일의 지정 위치에서 전체 길이를 읽기 (파일 끝에 먼저 닿으면 실패)
+int pread_all(int fd, void *buf, size_t len, long long offset)
+{
+    char *p = buf;
+    size_t done = 0;
+
+    while (done < len)
+    {
+        ssize_t n = pread(fd, p + done, len - done, offset + done);
+        if (n <= 0)
+            return -1;
+        done += n;
+    }
+    return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef NETIO_H
+#define NETIO_H
+
+#include <stddef.h>
+
+// DATA 한 청크의 최대 크기 (서버는 넘는 요청을 거부, 수신은 작은 버퍼로 나눠서 처리)
+#define MAX_CHUNK_SIZE (1024LL * 1024 * 1024)
+
+// 전체 길이가 전송될 때까지 반복해서 write (성공 0, 실패 -1)
+int write_all(int sd, const void *buf, size_t len);
+
+// 전체 길이를 수신할 때까지 반복해서 read (성공 0, 실패 -1)
+int read_all(int sd, void *buf, size_t len);
+
+// 개행 문자까지 한 줄 읽기 (읽은 길이 반환, 연결 종료/오류 시 -1)
+int read_line(int sd, char *line, int size);
+
+// 파일의 지정 위치(64비트 오프셋)에 전체 길이를 쓰기 / 읽기 (성공 0, 실패 -1)
+int pwrite_all(int fd, const void *buf, size_t len, long long offset);
+int pread_all(int fd, void *buf, size_t len, long long offset);
+
+#endif
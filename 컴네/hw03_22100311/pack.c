@@ -0,0 +1,714 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "netio.h"
+#include "journal.h"
+#include "pack.h"
+
+#define PACK_MAGIC 0x4b434150U  // "PACK"
+#define INDEX_MAGIC 0x58444950U // "PIDX"
+
+// 키 "<client_id>/<filename>" 최대 길이
+#define KEY_MAX 330
+
+// 압축할 때 한 번에 옮기는 레코드 수 (그 사이 잠금을 풀어 FIN이 오래 기다리지 않게 함)
+#define COMPACT_BATCH 64
+
+// 팩 레코드 헤더 (뒤에 key_len 바이트 키, data_len 바이트 데이터)
+typedef struct
+{
+    uint32_t magic;
+    uint32_t key_len;
+    uint32_t data_len;
+    uint32_t flags;   // REC_TOMBSTONE: 삭제 표시 (데이터 없음)
+    uint32_t crc;     // 키 + 데이터의 CRC32
+    uint32_t hdr_crc; // 위 필드들의 CRC32 (찢어진 레코드 검출)
+} PackRecord;
+
+#define REC_TOMBSTONE 1
+
+// 인덱스 파일 헤더 (뒤에 capacity개의 슬롯)
+typedef struct
+{
+    uint32_t magic;
+    uint32_t cur_pack; // 마지막으로 레코드를 추가한 팩 번호와 그 끝 위치
+    uint64_t cur_size; // (비정상 종료로 뒤에 남은 찢어진 레코드는 덮어씀)
+    uint64_t capacity; // 슬롯 수 (2의 거듭제곱)
+    uint64_t used;     // 사용 중 + 삭제 표시 슬롯 수
+    uint64_t live;
+} IndexHeader;
+
+#define SLOT_EMPTY 0
+#define SLOT_LIVE 1
+#define SLOT_DELETED 2
+
+// 인덱스 슬롯 하나 (32 bytes)
+typedef struct
+{
+    uint64_t hash;
+    uint32_t pack;
+    uint32_t state;
+    uint64_t offset; // 레코드 시작 위치
+    uint32_t len;    // 데이터 길이
+    uint32_t key_len;
+} IndexSlot;
+
+static long long threshold = 0;
+
+// 조회는 읽기 잠금, 추가/삭제/압축은 쓰기 잠금
+static pthread_rwlock_t pack_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static IndexHeader *index_hdr = NULL;
+static IndexSlot *slots = NULL;
+static size_t index_len = 0;
+static unsigned long index_gen = 0; // 인덱스를 다시 만들 때마다 증가 (압축 중 슬롯 위치가 바뀌었는지 확인)
+
+// 팩 번호별 디스크립터 (없으면 -1)
+static int *pack_fds = NULL;
+static int pack_cnt = 0;
+
+// FNV-1a 64비트 해시 (0은 피함)
+static uint64_t key_hash(const char *key, size_t len)
+{
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+// 키 생성, 길이 반환 (너무 길면 -1)
+static int make_key(char *key, const char *client_id, const char *filename)
+{
+    int n = snprintf(key, KEY_MAX, "%s/%s", client_id, filename);
+    return n > 0 && n < KEY_MAX ? n : -1;
+}
+
+// 레코드 헤더의 체크섬
+static uint32_t record_hdr_crc(const PackRecord *r)
+{
+    return crc32_update(0, r, offsetof(PackRecord, hdr_crc));
+}
+
+// 팩 파일 열기 (pack_fds 에 보관, 쓰기 잠금 상태 또는 시작할 때만 호출)
+static int pack_fd(int n, int create)
+{
+    if (n >= pack_cnt)
+    {
+        int cnt = pack_cnt ? pack_cnt : 16;
+        while (cnt <= n)
+            cnt *= 2;
+        int *fds = realloc(pack_fds, sizeof(int) * cnt);
+        if (!fds)
+            return -1;
+        for (int i = pack_cnt; i < cnt; i++)
+            fds[i] = -1;
+        pack_fds = fds;
+        pack_cnt = cnt;
+    }
+
+    if (pack_fds[n] < 0)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "%s/pack-%04d.dat", PACK_DIR, n);
+        pack_fds[n] = open(path, O_RDWR | (create ? O_CREAT : 0), 0644);
+    }
+    return pack_fds[n];
+}
+
+// 인덱스 파일 매핑 (capacity > 0 이면 빈 인덱스를 새로 만듦, 0이면 기존 파일 검증)
+static int index_map(const char *path, uint64_t capacity, IndexHeader **hdr, size_t *len)
+{
+    int fd = open(path, O_RDWR | (capacity ? O_CREAT | O_TRUNC : 0), 0644);
+    if (fd < 0)
+        return -1;
+
+    struct stat st;
+    size_t size = sizeof(IndexHeader) + capacity * sizeof(IndexSlot);
+    if (capacity && ftruncate(fd, size) < 0)
+        goto fail;
+    if (!capacity)
+    {
+        if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(IndexHeader))
+            goto fail;
+        size = st.st_size;
+    }
+
+    IndexHeader *h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED)
+        goto fail;
+    close(fd);
+
+    if (capacity)
+    {
+        h->magic = INDEX_MAGIC;
+        h->capacity = capacity;
+    }
+    else if (h->magic != INDEX_MAGIC || h->capacity == 0 || (h->capacity & (h->capacity - 1)) ||
+             size != sizeof(IndexHeader) + h->capacity * sizeof(IndexSlot))
+    {
+        munmap(h, size);
+        return -1;
+    }
+    *hdr = h;
+    *len = size;
+    return 0;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+// 슬롯이 가리키는 레코드의 키가 key와 같은지 (팩 파일에서 읽어서 확인)
+static int slot_matches(const IndexSlot *s, const char *key, size_t klen)
+{
+    if (s->key_len != klen || (int)s->pack >= pack_cnt || pack_fds[s->pack] < 0)
+        return 0;
+
+    char buf[KEY_MAX];
+    return pread_all(pack_fds[s->pack], buf, klen, s->offset + sizeof(PackRecord)) == 0 &&
+           memcmp(buf, key, klen) == 0;
+}
+
+// key의 슬롯 찾기 (없으면 NULL), free_slot에는 새로 넣을 수 있는 첫 슬롯
+static IndexSlot *slot_find(const char *key, size_t klen, uint64_t h, IndexSlot **free_slot)
+{
+    uint64_t mask = index_hdr->capacity - 1;
+    if (free_slot)
+        *free_slot = NULL;
+
+    for (uint64_t i = h & mask, n = 0; n < index_hdr->capacity; i = (i + 1) & mask, n++)
+    {
+        IndexSlot *s = &slots[i];
+        if (s->state != SLOT_LIVE)
+        {
+            if (free_slot && !*free_slot)
+                *free_slot = s;
+            if (s->state == SLOT_EMPTY)
+                return NULL;
+            continue;
+        }
+        if (s->hash == h && slot_matches(s, key, klen))
+            return s;
+    }
+    return NULL;
+}
+
+// 살아 있는 슬롯만으로 인덱스를 새로 만들어 교체 (삭제 표시 정리, 크기는 살아 있는 수의 2배 이상)
+static int index_resize(void)
+{
+    uint64_t cap = PACK_INDEX_MIN;
+    while (cap * PACK_INDEX_LOAD / 100 <= index_hdr->live * 2)
+        cap *= 2;
+
+    const char *tmp = PACK_DIR "/index.tmp";
+    IndexHeader *nh;
+    size_t nlen;
+    if (index_map(tmp, cap, &nh, &nlen) < 0)
+        return -1;
+
+    IndexSlot *ns = (IndexSlot *)(nh + 1);
+    for (uint64_t i = 0; i < index_hdr->capacity; i++)
+    {
+        if (slots[i].state != SLOT_LIVE)
+            continue;
+        uint64_t j = slots[i].hash & (cap - 1);
+        while (ns[j].state != SLOT_EMPTY)
+            j = (j + 1) & (cap - 1);
+        ns[j] = slots[i];
+        nh->used++;
+        nh->live++;
+    }
+    nh->cur_pack = index_hdr->cur_pack;
+    nh->cur_size = index_hdr->cur_size;
+
+    if (rename(tmp, PACK_DIR "/index") < 0)
+    {
+        munmap(nh, nlen);
+        unlink(tmp);
+        return -1;
+    }
+    munmap(index_hdr, index_len);
+    index_hdr = nh;
+    slots = ns;
+    index_len = nlen;
+    index_gen++;
+    return 0;
+}
+
+// 키를 새 레코드 위치로 갱신하거나 추가
+static int index_put(const char *key, size_t klen, int pack, long long offset, uint32_t len)
+{
+    if ((index_hdr->used + 1) * 100 > index_hdr->capacity * PACK_INDEX_LOAD && index_resize() < 0)
+        return -1;
+
+    uint64_t h = key_hash(key, klen);
+    IndexSlot *free_slot;
+    IndexSlot *s = slot_find(key, klen, h, &free_slot);
+    if (!s)
+    {
+        s = free_slot;
+        if (!s)
+            return -1;
+        if (s->state == SLOT_EMPTY)
+            index_hdr->used++;
+        index_hdr->live++;
+    }
+
+    // 상태는 마지막에 기록 (중간에 죽어도 반쯤 쓴 슬롯이 살아 있는 것으로 보이지 않게)
+    s->hash = h;
+    s->pack = pack;
+    s->offset = offset;
+    s->len = len;
+    s->key_len = klen;
+    s->state = SLOT_LIVE;
+    return 0;
+}
+
+// 키 삭제 (삭제 표시 슬롯으로 바꿈), 있었으면 1
+static int index_del(const char *key, size_t klen)
+{
+    IndexSlot *s = slot_find(key, klen, key_hash(key, klen), NULL);
+    if (!s)
+        return 0;
+    s->state = SLOT_DELETED;
+    index_hdr->live--;
+    return 1;
+}
+
+// 현재 팩 파일 끝에 레코드(헤더 포함) 그대로 추가, 추가한 위치 반환 (실패 시 -1)
+static long long append_raw(const char *rec, size_t total)
+{
+    // 현재 팩이 가득 차면 다음 번호로 넘어감
+    if (index_hdr->cur_size > 0 && index_hdr->cur_size + total > (uint64_t)PACK_MAX_BYTES)
+    {
+        index_hdr->cur_pack++;
+        index_hdr->cur_size = 0;
+    }
+
+    int fd = pack_fd(index_hdr->cur_pack, 1);
+    if (fd < 0 || pwrite_all(fd, rec, total, index_hdr->cur_size) < 0)
+        return -1;
+
+    long long at = index_hdr->cur_size;
+    index_hdr->cur_size += total;
+    return at;
+}
+
+// 키와 데이터로 레코드를 만들어 추가
+static long long append_record(const char *key, size_t klen, const char *data, uint32_t len, uint32_t flags)
+{
+    size_t total = sizeof(PackRecord) + klen + len;
+    char *rec = malloc(total);
+    if (!rec)
+        return -1;
+
+    PackRecord *r = (PackRecord *)rec;
+    memcpy(rec + sizeof(PackRecord), key, klen);
+    memcpy(rec + sizeof(PackRecord) + klen, data, len);
+    r->magic = PACK_MAGIC;
+    r->key_len = klen;
+    r->data_len = len;
+    r->flags = flags;
+    r->crc = crc32_update(0, rec + sizeof(PackRecord), klen + len);
+    r->hdr_crc = record_hdr_crc(r);
+
+    long long at = append_raw(rec, total);
+    free(rec);
+    return at;
+}
+
+// 팩 파일 하나를 처음부터 읽으며 인덱스에 반영 (인덱스를 다시 만들 때)
+// 검증에 실패한 레코드(찢어진 꼬리)에서 멈추고 그 위치 반환
+static long long scan_pack(int n, char *buf)
+{
+    int fd = pack_fds[n];
+    long long off = 0;
+
+    while (1)
+    {
+        PackRecord r;
+        if (pread_all(fd, &r, sizeof(r), off) < 0 || r.magic != PACK_MAGIC || r.hdr_crc != record_hdr_crc(&r) ||
+            r.key_len == 0 || r.key_len >= KEY_MAX || r.data_len > PACK_MAX_THRESHOLD)
+            break;
+        if (pread_all(fd, buf, r.key_len + r.data_len, off + sizeof(r)) < 0 ||
+            crc32_update(0, buf, r.key_len + r.data_len) != r.crc)
+            break;
+
+        // 같은 키는 뒤에 나온 레코드가 최신 (덮어쓰기와 압축은 항상 가장 큰 번호의 팩에 추가)
+        if (r.flags & REC_TOMBSTONE)
+            index_del(buf, r.key_len);
+        else if (index_put(buf, r.key_len, n, off, r.data_len) < 0)
+            break;
+        off += sizeof(r) + r.key_len + r.data_len;
+    }
+    return off;
+}
+
+// 팩 저장 시작
+int pack_open(long long limit)
+{
+    if (limit <= 0)
+        return 0;
+    if (limit > PACK_MAX_THRESHOLD)
+        return -1;
+    mkdir(PACK_DIR, 0755);
+
+    // 있는 팩 파일을 모두 열어 둠 (조회는 읽기 잠금만 잡으므로 디스크립터 배열을 바꾸지 않음)
+    DIR *d = opendir(PACK_DIR);
+    if (!d)
+        return -1;
+    int max = -1;
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        int n;
+        if (sscanf(e->d_name, "pack-%d.dat", &n) == 1 && n >= 0 && pack_fd(n, 0) >= 0 && n > max)
+            max = n;
+    }
+    closedir(d);
+
+    // 인덱스가 멀쩡하면 그대로 매핑, 아니면 팩 파일을 읽어 다시 만듦
+    if (index_map(PACK_DIR "/index", 0, &index_hdr, &index_len) == 0)
+    {
+        slots = (IndexSlot *)(index_hdr + 1);
+    }
+    else
+    {
+        if (index_map(PACK_DIR "/index", PACK_INDEX_MIN, &index_hdr, &index_len) < 0)
+            return -1;
+        slots = (IndexSlot *)(index_hdr + 1);
+
+        char *buf = malloc(KEY_MAX + PACK_MAX_THRESHOLD);
+        if (!buf)
+            return -1;
+        for (int n = 0; n <= max; n++)
+        {
+            if (pack_fds[n] < 0)
+                continue;
+            long long end = scan_pack(n, buf);
+            index_hdr->cur_pack = n;
+            index_hdr->cur_size = end;
+        }
+        free(buf);
+        if (max >= 0)
+            printf("[PACK ] rebuilt index: %llu entries from %d pack files\n",
+                   (unsigned long long)index_hdr->live, max + 1);
+    }
+
+    threshold = limit;
+    return 0;
+}
+
+// 완료된 업로드 처리
+int pack_finish(const char *client_id, const char *filename, const char *path)
+{
+    if (threshold <= 0)
+        return 0;
+
+    char key[KEY_MAX];
+    int klen = make_key(key, client_id, filename);
+    struct stat st;
+    if (klen < 0 || stat(path, &st) < 0)
+        return 0;
+
+    // 큰 파일로 다시 올라왔으면 팩에 남은 이전 버전 삭제 (다시 만들 때도 지워지도록 삭제 레코드 추가)
+    if (st.st_size > threshold)
+    {
+        pthread_rwlock_wrlock(&pack_lock);
+        if (slot_find(key, klen, key_hash(key, klen), NULL) && append_record(key, klen, "", 0, REC_TOMBSTONE) >= 0)
+            index_del(key, klen);
+        pthread_rwlock_unlock(&pack_lock);
+        return 0;
+    }
+
+    // 파일 전체를 읽어서 (작은 파일이므로 한 번에) 팩에 추가
+    char *data = malloc(st.st_size > 0 ? st.st_size : 1);
+    int fd = open(path, O_RDONLY);
+    int ok = data && fd >= 0 && pread_all(fd, data, st.st_size, 0) == 0;
+    if (fd >= 0)
+        close(fd);
+
+    int pack = -1;
+    long long at = -1;
+    if (ok)
+    {
+        pthread_rwlock_wrlock(&pack_lock);
+        at = append_record(key, klen, data, st.st_size, 0);
+        pack = index_hdr->cur_pack;
+        ok = at >= 0 && index_put(key, klen, pack, at, st.st_size) == 0;
+        pthread_rwlock_unlock(&pack_lock);
+    }
+    free(data);
+    if (!ok)
+        return 0;
+
+    // 인덱스에 기록한 뒤에 원본 삭제 (그 사이에 죽으면 원본이 남을 뿐)
+    unlink(path);
+    printf("[PACK ] %s (%lld bytes) -> pack-%04d @%lld\n", key, (long long)st.st_size, pack, at);
+    return 1;
+}
+
+// 팩에 저장된 업로드 찾기
+int pack_lookup(const char *client_id, const char *filename, int *fd, long long *offset, long long *len)
+{
+    if (threshold <= 0)
+        return -1;
+
+    char key[KEY_MAX];
+    int klen = make_key(key, client_id, filename);
+    if (klen < 0)
+        return -1;
+
+    int ret = -1;
+    pthread_rwlock_rdlock(&pack_lock);
+    IndexSlot *s = slot_find(key, klen, key_hash(key, klen), NULL);
+    if (s && (*fd = dup(pack_fds[s->pack])) >= 0)
+    {
+        *offset = s->offset + sizeof(PackRecord) + s->key_len;
+        *len = s->len;
+        ret = 0;
+    }
+    pthread_rwlock_unlock(&pack_lock);
+    return ret;
+}
+
+// 살아 있는 슬롯마다 팩 파일에서 키를 읽어 "<client_id>/<filename>" 으로 나눠 전달
+void pack_foreach(void (*cb)(const char *client_id, const char *filename, long long len, long long mtime_ns, void *arg),
+                  void *arg)
+{
+    if (threshold <= 0)
+        return;
+
+    pthread_rwlock_rdlock(&pack_lock);
+    for (uint64_t i = 0; i < index_hdr->capacity; i++)
+    {
+        IndexSlot *s = &slots[i];
+        char key[KEY_MAX];
+        if (s->state != SLOT_LIVE || s->key_len >= KEY_MAX || (int)s->pack >= pack_cnt || pack_fds[s->pack] < 0 ||
+            pread_all(pack_fds[s->pack], key, s->key_len, s->offset + sizeof(PackRecord)) < 0)
+            continue;
+        key[s->key_len] = '\0';
+        char *slash = strchr(key, '/');
+        if (!slash)
+            continue;
+        *slash = '\0';
+        struct stat st;
+        long long mtime_ns = fstat(pack_fds[s->pack], &st) == 0 ? st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec : 0;
+        cb(key, slash + 1, s->len, mtime_ns, arg);
+    }
+    pthread_rwlock_unlock(&pack_lock);
+}
+
+// 레코드 헤더를 검증하고 키를 읽음 (NUL로 끝냄), 다음 레코드 위치 반환 (끝이거나 깨졌으면 -1)
+static long long read_key(int fd, long long off, PackRecord *r, char *key)
+{
+    if (pread_all(fd, r, sizeof(*r), off) < 0 || r->magic != PACK_MAGIC || r->hdr_crc != record_hdr_crc(r) ||
+        r->key_len == 0 || r->key_len >= KEY_MAX || r->data_len > PACK_MAX_THRESHOLD ||
+        pread_all(fd, key, r->key_len, off + sizeof(*r)) < 0)
+        return -1;
+    key[r->key_len] = '\0';
+    return off + sizeof(*r) + r->key_len + r->data_len;
+}
+
+static int key_cmp(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// 압축할 팩 p의 삭제 레코드 중 아직 필요한 것을 현재 팩 끝에 다시 추가
+// p보다 작은 번호의 팩에 그 키의 레코드가 남아 있으면, 삭제 레코드 없이 인덱스를 다시 만들 때 되살아남
+// (fds: pack_compact가 복사한 디스크립터, 성공 0, 실패 -1 - 실패하면 이 팩은 압축하지 않음)
+static int carry_tombstones(int p, const int *fds, long long *carried)
+{
+    char key[KEY_MAX];
+    PackRecord r;
+    char **keys = NULL;
+    int n = 0, cap = 0, ret = 0;
+
+    // 팩 p의 삭제 레코드 키 모음 (압축 중이 아닌 팩은 더 추가되지 않으므로 잠금 없이 읽음)
+    for (long long off = 0, next; (next = read_key(fds[p], off, &r, key)) >= 0; off = next)
+    {
+        if (!(r.flags & REC_TOMBSTONE))
+            continue;
+        if (n == cap)
+        {
+            cap = cap ? cap * 2 : 64;
+            char **k = realloc(keys, sizeof(char *) * cap);
+            if (!k)
+            {
+                ret = -1;
+                break;
+            }
+            keys = k;
+        }
+        if (!(keys[n++] = strdup(key)))
+        {
+            n--;
+            ret = -1;
+            break;
+        }
+    }
+
+    // 정렬 후 중복 제거
+    int uniq = 0;
+    if (n > 0)
+        qsort(keys, n, sizeof(char *), key_cmp);
+    for (int i = 0; i < n; i++)
+    {
+        if (uniq > 0 && strcmp(keys[uniq - 1], keys[i]) == 0)
+            free(keys[i]);
+        else
+            keys[uniq++] = keys[i];
+    }
+
+    // 작은 번호의 팩부터 순서대로 읽으며 키마다 다시 만들 때의 마지막 상태 계산 (레코드: 살아남, 삭제 레코드: 지워짐)
+    char *need = ret == 0 && uniq > 0 ? calloc(uniq, 1) : NULL;
+    if (uniq > 0 && !need)
+        ret = -1;
+    for (int q = 0; need && q < p; q++)
+    {
+        if (fds[q] < 0)
+            continue;
+        for (long long off = 0, next; (next = read_key(fds[q], off, &r, key)) >= 0; off = next)
+        {
+            char *kp = key;
+            char **hit = bsearch(&kp, keys, uniq, sizeof(char *), key_cmp);
+            if (hit)
+                need[hit - keys] = !(r.flags & REC_TOMBSTONE);
+        }
+    }
+
+    // 그 사이 새로 저장된 키는 새 레코드가 최신이므로 필요 없음
+    for (int i = 0; need && i < uniq && ret == 0; i++)
+    {
+        if (!need[i])
+            continue;
+        size_t klen = strlen(keys[i]);
+        pthread_rwlock_wrlock(&pack_lock);
+        if (!slot_find(keys[i], klen, key_hash(keys[i], klen), NULL))
+        {
+            if (append_record(keys[i], klen, "", 0, REC_TOMBSTONE) < 0)
+                ret = -1;
+            else
+                (*carried)++;
+        }
+        pthread_rwlock_unlock(&pack_lock);
+    }
+
+    for (int i = 0; i < uniq; i++)
+        free(keys[i]);
+    free(keys);
+    free(need);
+    return ret;
+}
+
+// 팩 파일 하나의 살아 있는 레코드(와 아직 필요한 삭제 레코드)를 현재 팩으로 옮기고 삭제 (삭제했으면 1)
+static int compact_pack(int p, const int *fds, char *buf)
+{
+    uint64_t i = 0;
+    unsigned long gen = 0;
+    long long moved = 0, carried = 0;
+
+    if (carry_tombstones(p, fds, &carried) < 0)
+        return 0;
+
+    while (1)
+    {
+        pthread_rwlock_wrlock(&pack_lock);
+
+        // 인덱스가 새로 만들어졌으면 처음부터 다시 훑음
+        if (gen != index_gen)
+        {
+            gen = index_gen;
+            i = 0;
+        }
+
+        int batch = 0;
+        for (; i < index_hdr->capacity && batch < COMPACT_BATCH; i++)
+        {
+            IndexSlot *s = &slots[i];
+            if (s->state != SLOT_LIVE || s->pack != (uint32_t)p)
+                continue;
+
+            size_t total = sizeof(PackRecord) + s->key_len + s->len;
+            long long at = -1;
+            if (pread_all(pack_fds[p], buf, total, s->offset) == 0)
+                at = append_raw(buf, total);
+            if (at < 0)
+            {
+                // 옮기지 못하면 이 팩은 그대로 둠
+                pthread_rwlock_unlock(&pack_lock);
+                return 0;
+            }
+            s->pack = index_hdr->cur_pack;
+            s->offset = at;
+            batch++;
+            moved++;
+        }
+
+        // 끝까지 훑었으면 팩 파일 삭제 (새 레코드는 현재 팩에만 추가되므로 더 생기지 않음)
+        if (i >= index_hdr->capacity)
+        {
+            char path[64];
+            snprintf(path, sizeof(path), "%s/pack-%04d.dat", PACK_DIR, p);
+            close(pack_fds[p]);
+            pack_fds[p] = -1;
+            unlink(path);
+            pthread_rwlock_unlock(&pack_lock);
+            printf("[PACK ] compacted pack-%04d (%lld live records moved, %lld tombstones kept)\n", p, moved, carried);
+            return 1;
+        }
+        pthread_rwlock_unlock(&pack_lock);
+    }
+}
+
+// 죽은 데이터가 많은 팩 파일 압축
+void pack_compact(void)
+{
+    if (threshold <= 0)
+        return;
+
+    // 팩별로 살아 있는 레코드 크기 합산
+    pthread_rwlock_rdlock(&pack_lock);
+    int cnt = pack_cnt;
+    int cur = index_hdr->cur_pack;
+    long long *live = calloc(cnt, sizeof(long long));
+    int *fds = malloc(sizeof(int) * cnt);
+    if (live && fds)
+    {
+        memcpy(fds, pack_fds, sizeof(int) * cnt);
+        for (uint64_t i = 0; i < index_hdr->capacity; i++)
+            if (slots[i].state == SLOT_LIVE)
+                live[slots[i].pack] += sizeof(PackRecord) + slots[i].key_len + slots[i].len;
+    }
+    pthread_rwlock_unlock(&pack_lock);
+
+    char *buf = malloc(sizeof(PackRecord) + KEY_MAX + PACK_MAX_THRESHOLD);
+    for (int p = 0; live && fds && buf && p < cnt; p++)
+    {
+        // 지금 추가 중인 팩은 제외
+        struct stat st;
+        if (p == cur || fds[p] < 0 || fstat(fds[p], &st) < 0 || st.st_size == 0)
+            continue;
+        if (live[p] * 100 > (long long)st.st_size * (100 - PACK_COMPACT_DEAD))
+            continue;
+        // 삭제한 팩의 디스크립터는 닫혔으므로 뒤 팩의 삭제 레코드를 확인할 때 건너뜀
+        if (compact_pack(p, fds, buf))
+            fds[p] = -1;
+    }
+    free(buf);
+    free(fds);
+    free(live);
+}
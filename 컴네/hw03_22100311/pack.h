@@ -0,0 +1,40 @@
+#ifndef PACK_H
+#define PACK_H
+
+// 작은 파일 묶음 저장: 완료된 작은 업로드를 개별 파일 대신 추가 전용 팩 파일에 이어 붙임
+//   ./.packs/pack-NNNN.dat  레코드 (헤더 + "<client_id>/<filename>" + 데이터) 를 계속 추가
+//   ./.packs/index          (client_id, filename) 해시 -> (팩 번호, 위치, 길이) 오픈 어드레싱 표, mmap으로 조회
+// 인덱스가 없거나 깨졌으면 팩 파일을 처음부터 읽어 다시 만듦
+#define PACK_DIR "./.packs"
+
+// 팩 파일 하나의 최대 크기 (넘으면 다음 번호의 팩 파일로 넘어감)
+#define PACK_MAX_BYTES (256LL * 1024 * 1024)
+
+// 묶음 저장할 수 있는 업로드 크기 상한 (-k 옵션 최대값)
+#define PACK_MAX_THRESHOLD (1024 * 1024)
+
+// 인덱스 처음 슬롯 수, 사용 중인 슬롯이 이 비율(%)을 넘으면 다시 만듦
+#define PACK_INDEX_MIN 4096
+#define PACK_INDEX_LOAD 70
+
+// 덮어쓰기/삭제로 죽은 데이터가 이 비율(%) 이상인 팩 파일은 압축 (살아 있는 레코드만 옮기고 삭제)
+#define PACK_COMPACT_DEAD 50
+
+// 팩 저장 시작 - threshold 바이트 이하로 완료된 업로드를 묶음 저장 (성공 0, 실패 -1)
+int pack_open(long long threshold);
+
+// 완료된 업로드 처리: 작으면 팩에 추가한 뒤 원본 파일 삭제, 크면 같은 이름의 이전 팩 레코드 삭제
+// (사용하지 않거나 실패하면 개별 파일 그대로 둠, 팩에 저장했으면 1, 아니면 0)
+int pack_finish(const char *client_id, const char *filename, const char *path);
+
+// 팩에 저장된 업로드 찾기 - 팩 파일 디스크립터(호출자가 close), 데이터 시작 위치, 길이 (없으면 -1)
+int pack_lookup(const char *client_id, const char *filename, int *fd, long long *offset, long long *len);
+
+// 팩에 저장된 업로드마다 cb(client_id, filename, 길이, 팩 파일 수정 시각(ns), arg) 호출 (카탈로그 다시 만들기)
+void pack_foreach(void (*cb)(const char *client_id, const char *filename, long long len, long long mtime_ns, void *arg),
+                  void *arg);
+
+// 죽은 데이터가 많은 팩 파일 압축 (정리 스레드에서 호출)
+void pack_compact(void);
+
+#endif
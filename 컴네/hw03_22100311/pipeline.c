@@ -0,0 +1,393 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "netio.h"
+#include "journal.h"
+#include "pipeline.h"
+#include "affinity.h"
+
+// pipeline_feed_fd / 다시 읽기에 쓰는 버퍼 크기
+#define PIPE_READ_BUF (256 * 1024)
+
+// 한 업로드를 연속으로 처리하는 최대 버퍼 수 (넘으면 다른 업로드에 양보)
+#define PIPE_BATCH 8
+
+// 처리할 버퍼 하나
+typedef struct PipeJob
+{
+    struct PipeJob *next;
+    long long offset;
+    size_t len;
+    char data[];
+} PipeJob;
+
+struct Pipeline
+{
+    void *state[PIPE_MAX_STAGES];
+
+    // 이 업로드의 대기 버퍼 (도착 순서)
+    PipeJob *head, *tail;
+    int pending;   // 아직 처리하지 않은 버퍼 수
+    int scheduled; // 실행 대기열에 있거나 작업 스레드가 처리 중
+    pthread_cond_t idle;
+    struct Pipeline *run_next;
+};
+
+static const PipelineStage *stages[PIPE_MAX_STAGES];
+static int stage_cnt = 0;
+
+static pthread_mutex_t pipe_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;  // 실행 대기열에 업로드가 생김
+static pthread_cond_t space_cond = PTHREAD_COND_INITIALIZER; // 대기 버퍼 수가 줄어듦
+static Pipeline *run_head = NULL, *run_tail = NULL;
+static int queued = 0;
+
+// 실행 대기열 끝에 추가 (pipe_lock 상태)
+static void run_push(Pipeline *p)
+{
+    p->run_next = NULL;
+    if (run_tail)
+        run_tail->run_next = p;
+    else
+        run_head = p;
+    run_tail = p;
+    pthread_cond_signal(&work_cond);
+}
+
+// 작업 스레드 - 실행 대기열에서 업로드를 꺼내 그 업로드의 버퍼를 순서대로 처리
+static void *pipe_worker(void *arg)
+{
+    (void)arg;
+    affinity_pin_worker();
+    pthread_mutex_lock(&pipe_lock);
+
+    while (1)
+    {
+        while (!run_head)
+            pthread_cond_wait(&work_cond, &pipe_lock);
+        Pipeline *p = run_head;
+        run_head = p->run_next;
+        if (!run_head)
+            run_tail = NULL;
+
+        for (int n = 0; n < PIPE_BATCH && p->head; n++)
+        {
+            PipeJob *job = p->head;
+            p->head = job->next;
+            if (!p->head)
+                p->tail = NULL;
+            pthread_mutex_unlock(&pipe_lock);
+
+            for (int i = 0; i < stage_cnt; i++)
+                stages[i]->data(p->state[i], job->offset, job->data, job->len);
+            free(job);
+
+            pthread_mutex_lock(&pipe_lock);
+            p->pending--;
+            queued--;
+            pthread_cond_broadcast(&space_cond);
+        }
+
+        // 남은 버퍼가 있으면 뒤로 보내고, 없으면 끝났음을 알림
+        if (p->head)
+            run_push(p);
+        else
+        {
+            p->scheduled = 0;
+            pthread_cond_broadcast(&p->idle);
+        }
+    }
+    return NULL;
+}
+
+// 버퍼 하나를 업로드의 대기 목록에 추가 (큐가 가득 차면 처리될 때까지 대기)
+static void pipe_enqueue(Pipeline *p, PipeJob *job)
+{
+    job->next = NULL;
+
+    pthread_mutex_lock(&pipe_lock);
+    while (queued >= PIPE_QUEUE_MAX)
+        pthread_cond_wait(&space_cond, &pipe_lock);
+    if (p->tail)
+        p->tail->next = job;
+    else
+        p->head = job;
+    p->tail = job;
+    p->pending++;
+    queued++;
+    if (!p->scheduled)
+    {
+        p->scheduled = 1;
+        run_push(p);
+    }
+    pthread_mutex_unlock(&pipe_lock);
+}
+
+// 단계 등록
+int pipeline_register(const PipelineStage *stage)
+{
+    if (stage_cnt >= PIPE_MAX_STAGES)
+        return -1;
+    stages[stage_cnt++] = stage;
+    return 0;
+}
+
+// 업로드 하나의 파이프라인 시작
+Pipeline *pipeline_begin(long long offset)
+{
+    if (stage_cnt == 0)
+        return NULL;
+
+    Pipeline *p = calloc(1, sizeof(Pipeline));
+    if (!p)
+        return NULL;
+    pthread_cond_init(&p->idle, NULL);
+    for (int i = 0; i < stage_cnt; i++)
+        p->state[i] = stages[i]->open(offset);
+    return p;
+}
+
+// 파일에 쓴 버퍼를 복사해서 작업 큐에 추가
+void pipeline_feed(Pipeline *p, long long offset, const void *buf, size_t len)
+{
+    if (!p || len == 0)
+        return;
+
+    PipeJob *job = malloc(sizeof(PipeJob) + len);
+    if (!job)
+        return;
+    job->offset = offset;
+    job->len = len;
+    memcpy(job->data, buf, len);
+    pipe_enqueue(p, job);
+}
+
+// 파일에서 읽어서 작업 큐에 추가 (방금 쓴 구간이라 페이지 캐시에서 읽힘)
+void pipeline_feed_fd(Pipeline *p, int fd, long long offset, long long len)
+{
+    if (!p)
+        return;
+
+    for (long long done = 0; done < len;)
+    {
+        size_t want = len - done < PIPE_READ_BUF ? (size_t)(len - done) : PIPE_READ_BUF;
+        PipeJob *job = malloc(sizeof(PipeJob) + want);
+        if (!job)
+            return;
+        if (pread_all(fd, job->data, want, offset + done) < 0)
+        {
+            free(job);
+            return;
+        }
+        job->offset = offset + done;
+        job->len = want;
+        pipe_enqueue(p, job);
+        done += want;
+    }
+}
+
+// 남은 작업을 기다린 뒤 단계별 결과를 모아 종료
+void pipeline_end(Pipeline *p, const char *path, char *result, size_t size)
+{
+    if (result && size > 0)
+        result[0] = '\0';
+    if (!p)
+        return;
+
+    pthread_mutex_lock(&pipe_lock);
+    while (p->scheduled)
+        pthread_cond_wait(&p->idle, &pipe_lock);
+    pthread_mutex_unlock(&pipe_lock);
+
+    size_t pos = 0;
+    for (int i = 0; i < stage_cnt; i++)
+    {
+        char one[PIPE_RESULT] = "";
+        stages[i]->close(p->state[i], path, one, sizeof(one));
+        if (path && result && pos < size)
+            pos += snprintf(result + pos, size - pos, "%s%s=%s", pos ? " " : "", stages[i]->name, one);
+    }
+    pthread_cond_destroy(&p->idle);
+    free(p);
+}
+
+// ---- 내장 단계: crc32 ----
+// 0부터 순서대로 받은 경우 전송 중에 계산, 이어받기/위치 지정 수신으로 빠진 부분이 있으면 완료 후 파일에서 다시 계산
+
+typedef struct
+{
+    uint32_t crc;
+    long long next; // 다음에 이어서 계산할 위치
+    int gap;        // 순서가 어긋나서 전송 중 계산을 포기함
+} CrcState;
+
+static void *crc_open(long long offset)
+{
+    CrcState *c = calloc(1, sizeof(CrcState));
+    if (c)
+        c->gap = offset != 0;
+    return c;
+}
+
+static void crc_data(void *state, long long offset, const void *buf, size_t len)
+{
+    CrcState *c = state;
+    if (!c || c->gap)
+        return;
+    if (offset != c->next)
+    {
+        c->gap = 1;
+        return;
+    }
+    c->crc = crc32_update(c->crc, buf, len);
+    c->next += len;
+}
+
+static void crc_close(void *state, const char *path, char *result, size_t size)
+{
+    CrcState *c = state;
+    if (!c)
+        return;
+
+    if (path)
+    {
+        // 파일 크기가 계산한 길이와 다르면 (다른 연결이 채운 부분 포함) 처음부터 다시 계산
+        int fd = open(path, O_RDONLY);
+        long long end = fd >= 0 ? lseek(fd, 0, SEEK_END) : -1;
+        int reread = c->gap || end != c->next;
+        if (reread && fd >= 0)
+        {
+            char *buf = malloc(PIPE_READ_BUF);
+            c->crc = 0;
+            for (long long off = 0; buf && off < end;)
+            {
+                size_t want = end - off < PIPE_READ_BUF ? (size_t)(end - off) : PIPE_READ_BUF;
+                if (pread_all(fd, buf, want, off) < 0)
+                    break;
+                c->crc = crc32_update(c->crc, buf, want);
+                off += want;
+            }
+            free(buf);
+        }
+        if (fd >= 0)
+            close(fd);
+        snprintf(result, size, "%08x%s", c->crc, reread ? "(reread)" : "");
+    }
+    free(c);
+}
+
+static const PipelineStage crc_stage = {"crc32", crc_open, crc_data, crc_close};
+
+// ---- 내장 단계: sniff ----
+// 파일 앞부분의 매직 넘버로 형식 판별
+
+#define SNIFF_LEN 512
+
+typedef struct
+{
+    unsigned char head[SNIFF_LEN];
+    size_t have; // 0부터 연속으로 채운 길이
+} SniffState;
+
+static void *sniff_open(long long offset)
+{
+    (void)offset;
+    return calloc(1, sizeof(SniffState));
+}
+
+static void sniff_data(void *state, long long offset, const void *buf, size_t len)
+{
+    SniffState *s = state;
+    if (!s || s->have >= SNIFF_LEN || offset > (long long)s->have)
+        return;
+
+    size_t off = offset;
+    size_t n = SNIFF_LEN - off < len ? SNIFF_LEN - off : len;
+    memcpy(s->head + off, buf, n);
+    if (off + n > s->have)
+        s->have = off + n;
+}
+
+// 앞부분 바이트로 형식 이름 결정
+static const char *sniff_type(const unsigned char *h, size_t n)
+{
+    if (n == 0)
+        return "empty";
+    if (n >= 8 && memcmp(h, "\x89PNG\r\n\x1a\n", 8) == 0)
+        return "png";
+    if (n >= 3 && memcmp(h, "\xff\xd8\xff", 3) == 0)
+        return "jpeg";
+    if (n >= 4 && memcmp(h, "GIF8", 4) == 0)
+        return "gif";
+    if (n >= 4 && memcmp(h, "%PDF", 4) == 0)
+        return "pdf";
+    if (n >= 4 && memcmp(h, "PK\x03\x04", 4) == 0)
+        return "zip";
+    if (n >= 2 && h[0] == 0x1f && h[1] == 0x8b)
+        return "gzip";
+    if (n >= 4 && memcmp(h, "\x7f" "ELF", 4) == 0)
+        return "elf";
+
+    // 제어 문자가 없으면 텍스트 (UTF-8 등 0x80 이상은 허용)
+    for (size_t i = 0; i < n; i++)
+        if (h[i] < 0x20 && h[i] != '\n' && h[i] != '\r' && h[i] != '\t')
+            return "binary";
+    return "text";
+}
+
+static void sniff_close(void *state, const char *path, char *result, size_t size)
+{
+    SniffState *s = state;
+    if (!s)
+        return;
+
+    if (path)
+    {
+        // 앞부분을 받지 못했으면 (이어받기) 파일에서 읽음
+        if (s->have < SNIFF_LEN)
+        {
+            int fd = open(path, O_RDONLY);
+            if (fd >= 0)
+            {
+                ssize_t n = pread(fd, s->head, SNIFF_LEN, 0);
+                s->have = n > 0 ? (size_t)n : 0;
+                close(fd);
+            }
+        }
+        snprintf(result, size, "%s", sniff_type(s->head, s->have));
+    }
+    free(s);
+}
+
+static const PipelineStage sniff_stage = {"sniff", sniff_open, sniff_data, sniff_close};
+
+// 내장 단계 등록 후 작업 스레드 시작
+int pipeline_start(const char *names)
+{
+    static const PipelineStage *builtin[] = {&crc_stage, &sniff_stage};
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", names);
+    for (char *save, *name = strtok_r(buf, ",", &save); name; name = strtok_r(NULL, ",", &save))
+    {
+        const PipelineStage *found = NULL;
+        for (size_t i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++)
+            if (strcmp(name, builtin[i]->name) == 0)
+                found = builtin[i];
+        if (!found || pipeline_register(found) < 0)
+            return -1;
+    }
+
+    for (int i = 0; i < PIPE_THREADS; i++)
+    {
+        pthread_t t;
+        pthread_create(&t, NULL, pipe_worker, NULL);
+        pthread_detach(t);
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stddef.h>
+
+// 수신 데이터 후처리 파이프라인: DATA 버퍼를 파일에 쓴 직후 복사해서 작업 스레드 풀로 넘김
+// (해시, 형식 판별, 색인 등을 전송과 겹쳐 실행하고 FIN 때 결과를 받음)
+// 업로드 하나의 버퍼는 도착한 순서대로 한 스레드에서만 처리되므로 단계 구현에 잠금이 필요 없음
+
+// 작업 스레드 수, 처리 대기 중인 버퍼 최대 개수 (가득 차면 수신 스레드가 기다림)
+#define PIPE_THREADS 4
+#define PIPE_QUEUE_MAX 256
+
+// 등록할 수 있는 최대 단계 수, 단계 하나의 결과 문자열 최대 길이
+#define PIPE_MAX_STAGES 8
+#define PIPE_RESULT 128
+
+// 파이프라인 단계
+typedef struct
+{
+    const char *name;
+
+    // 업로드마다 상태 생성 (offset: 이 연결에서 받기 시작하는 위치, 이어받기면 0보다 큼)
+    void *(*open)(long long offset);
+
+    // 수신한 데이터 (offset 위치에 쓴 len 바이트, 도착한 순서대로 호출)
+    void (*data)(void *state, long long offset, const void *buf, size_t len);
+
+    // 상태 해제, path가 있으면 완료된 업로드라 결과를 result에 기록 (못 받은 부분은 path에서 읽어도 됨)
+    void (*close)(void *state, const char *path, char *result, size_t size);
+} PipelineStage;
+
+typedef struct Pipeline Pipeline;
+
+// 단계 등록 (pipeline_start 전에 호출, 성공 0)
+int pipeline_register(const PipelineStage *stage);
+
+// 쉼표로 구분한 내장 단계 이름(crc32, sniff)을 등록하고 작업 스레드 시작 (모르는 이름이면 -1)
+int pipeline_start(const char *names);
+
+// 업로드 하나의 파이프라인 시작 (등록된 단계가 없으면 NULL)
+Pipeline *pipeline_begin(long long offset);
+
+// 파일에 쓴 버퍼를 복사해서 작업 큐에 추가 (p == NULL 이면 무시)
+void pipeline_feed(Pipeline *p, long long offset, const void *buf, size_t len);
+
+// 파일의 [offset, offset+len) 을 읽어서 작업 큐에 추가 (mmap 수신 경로)
+void pipeline_feed_fd(Pipeline *p, int fd, long long offset, long long len);
+
+// 남은 작업이 끝날 때까지 기다린 뒤 종료
+// path가 있으면 완료된 업로드로 보고 단계별 결과를 "name=value ..." 형식으로 result에 기록
+void pipeline_end(Pipeline *p, const char *path, char *result, size_t size);
+
+#endif
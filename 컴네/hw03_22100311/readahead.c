@@ -0,0 +1,170 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "netio.h"
+#include "readahead.h"
+
+// 링 슬롯 상태
+#define SLOT_EMPTY 0
+#define SLOT_FULL 1
+#define SLOT_ERROR 2
+
+struct ReadAhead
+{
+    int fd;
+    size_t buf_size;
+    int depth;
+    char **bufs;
+    size_t *lens;
+    int *state;
+
+    long long next_read; // 읽기 스레드가 다음에 읽을 위치
+    long long end;
+
+    // 전송 쪽 위치: head 슬롯에서 used 바이트까지 보냄
+    long long pos;
+    int head;
+    size_t used;
+
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+};
+
+// 읽기 스레드 - 빈 슬롯을 순서대로 채움
+static void *reader(void *arg)
+{
+    ReadAhead *ra = arg;
+    int slot = 0;
+
+    pthread_mutex_lock(&ra->lock);
+    while (!ra->stop && ra->next_read < ra->end)
+    {
+        while (!ra->stop && ra->state[slot] != SLOT_EMPTY)
+            pthread_cond_wait(&ra->cond, &ra->lock);
+        if (ra->stop)
+            break;
+
+        long long off = ra->next_read;
+        size_t len = ra->end - off < (long long)ra->buf_size ? (size_t)(ra->end - off) : ra->buf_size;
+
+        // 읽는 동안에는 잠금을 풀어 전송 쪽이 이미 찬 버퍼를 계속 보낼 수 있게 함
+        pthread_mutex_unlock(&ra->lock);
+        int r = pread_all(ra->fd, ra->bufs[slot], len, off);
+        pthread_mutex_lock(&ra->lock);
+
+        ra->lens[slot] = len;
+        ra->state[slot] = r < 0 ? SLOT_ERROR : SLOT_FULL;
+        ra->next_read += len;
+        slot = (slot + 1) % ra->depth;
+        pthread_cond_broadcast(&ra->cond);
+        if (r < 0)
+            break;
+    }
+    pthread_mutex_unlock(&ra->lock);
+    return NULL;
+}
+
+// 미리 읽기 시작
+ReadAhead *readahead_start(int fd, long long offset, long long end, size_t buf_size, int depth)
+{
+    ReadAhead *ra = calloc(1, sizeof(ReadAhead));
+    if (!ra)
+        return NULL;
+    ra->fd = fd;
+    ra->buf_size = buf_size;
+    ra->depth = depth;
+    ra->next_read = offset;
+    ra->pos = offset;
+    ra->end = end;
+    ra->bufs = calloc(depth, sizeof(char *));
+    ra->lens = calloc(depth, sizeof(size_t));
+    ra->state = calloc(depth, sizeof(int));
+    int ok = ra->bufs && ra->lens && ra->state;
+    for (int i = 0; ok && i < depth; i++)
+        ok = (ra->bufs[i] = malloc(buf_size)) != NULL;
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->cond, NULL);
+    if (!ok || pthread_create(&ra->thread, NULL, reader, ra) != 0)
+    {
+        for (int i = 0; ra->bufs && i < depth; i++)
+            free(ra->bufs[i]);
+        free(ra->bufs);
+        free(ra->lens);
+        free(ra->state);
+        pthread_mutex_destroy(&ra->lock);
+        pthread_cond_destroy(&ra->cond);
+        free(ra);
+        return NULL;
+    }
+    return ra;
+}
+
+// 현재 위치의 데이터 가리키기
+ssize_t readahead_get(ReadAhead *ra, size_t want, const char **ptr)
+{
+    pthread_mutex_lock(&ra->lock);
+    if (ra->pos >= ra->end)
+    {
+        pthread_mutex_unlock(&ra->lock);
+        return 0;
+    }
+    while (ra->state[ra->head] == SLOT_EMPTY)
+        pthread_cond_wait(&ra->cond, &ra->lock);
+    if (ra->state[ra->head] == SLOT_ERROR)
+    {
+        pthread_mutex_unlock(&ra->lock);
+        return -1;
+    }
+
+    size_t avail = ra->lens[ra->head] - ra->used;
+    size_t n = want < avail ? want : avail;
+    *ptr = ra->bufs[ra->head] + ra->used;
+    pthread_mutex_unlock(&ra->lock);
+    return n;
+}
+
+// 위치 이동
+void readahead_advance(ReadAhead *ra, size_t n)
+{
+    pthread_mutex_lock(&ra->lock);
+    ra->used += n;
+    ra->pos += n;
+    if (ra->used >= ra->lens[ra->head])
+    {
+        ra->state[ra->head] = SLOT_EMPTY;
+        ra->used = 0;
+        ra->head = (ra->head + 1) % ra->depth;
+        pthread_cond_broadcast(&ra->cond);
+    }
+    pthread_mutex_unlock(&ra->lock);
+}
+
+// 다음 전송 위치
+long long readahead_pos(const ReadAhead *ra)
+{
+    return ra->pos;
+}
+
+// 읽기 스레드 종료 후 해제
+void readahead_stop(ReadAhead *ra)
+{
+    if (!ra)
+        return;
+
+    pthread_mutex_lock(&ra->lock);
+    ra->stop = 1;
+    pthread_cond_broadcast(&ra->cond);
+    pthread_mutex_unlock(&ra->lock);
+    pthread_join(ra->thread, NULL);
+
+    for (int i = 0; i < ra->depth; i++)
+        free(ra->bufs[i]);
+    free(ra->bufs);
+    free(ra->lens);
+    free(ra->state);
+    pthread_mutex_destroy(&ra->lock);
+    pthread_cond_destroy(&ra->cond);
+    free(ra);
+}
@@ -0,0 +1,27 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// 클라이언트 미리 읽기: 별도 스레드가 파일을 순서대로 읽어 버퍼 링을 채우고,
+// 전송 쪽은 채워진 버퍼를 바로 소켓으로 보냄 (디스크 읽기와 전송이 겹침)
+typedef struct ReadAhead ReadAhead;
+
+// [offset, end) 를 buf_size 크기 버퍼 depth개로 미리 읽기 시작 (실패 시 NULL)
+ReadAhead *readahead_start(int fd, long long offset, long long end, size_t buf_size, int depth);
+
+// 현재 위치의 데이터를 최대 want 바이트 가리킴 (버퍼가 찰 때까지 대기)
+// 가리킨 길이 반환, 끝이면 0, 읽기 오류 -1
+ssize_t readahead_get(ReadAhead *ra, size_t want, const char **ptr);
+
+// 전송한 n 바이트만큼 위치를 옮김 (다 쓴 버퍼는 읽기 스레드에 돌려줌)
+void readahead_advance(ReadAhead *ra, size_t n);
+
+// 다음에 readahead_get 이 돌려줄 파일 위치
+long long readahead_pos(const ReadAhead *ra);
+
+// 읽기 스레드 종료 후 해제 (NULL 이면 무시)
+void readahead_stop(ReadAhead *ra);
+
+#endif
@@ -0,0 +1,443 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+#include "netio.h"
+#include "replicate.h"
+#include "pack.h"
+#include "ecstore.h"
+#include "tier.h"
+#include "tcptune.h"
+#include "delta.h"
+#include "sha256.h"
+
+#define REPL_CHUNK 65536
+#define REPL_REPORT_SEC 10
+
+// replicate_file 반환값 중 재시도하지 않고 작업을 버리는 경우 (-1은 재시도할 실패)
+#define REPL_NO_SOURCE -2 // 원본이 파일, 팩, 샤드, 저온 계층 어디에도 없음 (그 사이 삭제됨)
+
+// 복제 작업 하나 (완료된 업로드 파일)
+typedef struct
+{
+    char client_id[64];
+    char filename[256];
+    struct timespec queued_at;
+} ReplJob;
+
+// 복제 대상 피어와 전용 큐
+typedef struct
+{
+    char host[64];
+    int port;
+    int sd;
+
+    ReplJob queue[REPL_QUEUE_LEN];
+    int head;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    // 지연 및 처리량 지표
+    long completed;
+    long dropped;
+    long failed;
+    long long bytes;
+    double last_lag;
+    double max_lag;
+} ReplPeer;
+
+static ReplPeer peers[REPL_MAX_PEERS];
+static int peer_cnt = 0;
+
+// 두 시각의 차이(초)
+static double elapsed(const struct timespec *from, const struct timespec *to)
+{
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+// 피어 주소 추가 ("host:port")
+int replicate_add_peer(const char *spec)
+{
+    if (peer_cnt >= REPL_MAX_PEERS)
+        return -1;
+
+    ReplPeer *p = &peers[peer_cnt];
+    const char *colon = strrchr(spec, ':');
+    if (!colon || colon == spec || colon - spec >= (int)sizeof(p->host))
+        return -1;
+
+    memset(p, 0, sizeof(*p));
+    memcpy(p->host, spec, colon - spec);
+    p->port = atoi(colon + 1);
+    p->sd = -1;
+    if (p->port <= 0)
+        return -1;
+
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    peer_cnt++;
+    return 0;
+}
+
+// 피어에 접속하고 복제 연결임을 알림 (피어는 이 업로드를 다시 복제하지 않음)
+static int peer_connect(ReplPeer *p)
+{
+    int sd = socket(PF_INET, SOCK_STREAM, 0);
+    if (sd < 0)
+        return -1;
+
+    struct sockaddr_in serv;
+    memset(&serv, 0, sizeof(serv));
+    serv.sin_family = AF_INET;
+    serv.sin_addr.s_addr = inet_addr(p->host);
+    serv.sin_port = htons(p->port);
+
+    if (connect(sd, (struct sockaddr *)&serv, sizeof(serv)) < 0 ||
+        write_all(sd, "REPL\n", 5) < 0)
+    {
+        close(sd);
+        return -1;
+    }
+    tune_socket(sd, "repl");
+    p->sd = sd;
+    return 0;
+}
+
+// 응답 한 줄에서 ACK 오프셋 추출
+static int read_ACK(int sd, long long *offset)
+{
+    char line[128];
+    if (read_line(sd, line, sizeof(line)) < 0)
+        return -1;
+    if (sscanf(line, "ACK %lld", offset) != 1)
+        return -1;
+    return 0;
+}
+
+// 원본 전체의 sha256 계산 (피어가 재구성한 파일을 교체 전에 확인하는 값, 끝까지 읽지 못하면 -1)
+static int source_hash(int fd, long long base, long long size, char *buf, char hex[SHA256_HEX + 1])
+{
+    Sha256 h;
+    sha256_init(&h);
+    for (long long off = 0; off < size;)
+    {
+        size_t want = size - off < REPL_CHUNK ? (size_t)(size - off) : REPL_CHUNK;
+        if (pread_all(fd, buf, want, base + off) < 0)
+            return -1;
+        sha256_update(&h, buf, want);
+        off += want;
+    }
+    sha256_final_hex(&h, hex);
+    return 0;
+}
+
+// 모아 둔 연속 블록 참조를 COPY 하나로 전송
+static int flush_COPY(int sd, long long *start, long long *count)
+{
+    if (*count == 0)
+        return 0;
+    char msg[64];
+    long long offset;
+    int len = sprintf(msg, "COPY %lld %lld\n", *start, *count);
+    if (write_all(sd, msg, len) < 0 || read_ACK(sd, &offset) < 0)
+        return -1;
+    *count = 0;
+    return 0;
+}
+
+// 모아 둔 리터럴을 DATA 하나로 전송
+static int flush_DATA(int sd, const char *buf, int *len, long long *sent_bytes)
+{
+    if (*len == 0)
+        return 0;
+    char msg[64];
+    long long offset;
+    int mlen = sprintf(msg, "DATA %d\n", *len);
+    tune_bulk_begin(sd);
+    int ok = write_all(sd, msg, mlen) == 0 && write_all(sd, buf, *len) == 0;
+    tune_bulk_end(sd);
+    if (!ok || read_ACK(sd, &offset) < 0)
+        return -1;
+    *sent_bytes += *len;
+    *len = 0;
+    return 0;
+}
+
+// 파일 하나를 델타 프로토콜(DELTA -> COPY/DATA -> FIN)로 피어에 전송
+// 피어가 가진 파일의 블록 서명과 같은 자리의 원본 블록을 비교해서 같은 블록만 COPY로 재사용하고
+// 나머지는 DATA로 보냄. 피어는 새 임시 파일에 재구성한 뒤 원본 sha256이 맞을 때만 교체하므로
+// 중간이 바뀐 파일, 줄어든 파일, 끊겼던 복제 모두 같은 경로로 처리됨
+// (성공 0, 재시도할 실패 -1, 버릴 작업은 REPL_NO_SOURCE)
+static int replicate_file(ReplPeer *p, const ReplJob *job, long long *sent_bytes)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "./%s/%s", job->client_id, job->filename);
+
+    // 개별 파일이 없으면 팩 파일에 묶여 있는 구간, 또는 소거 부호 샤드/저온 계층에서 풀어낸 임시 파일을 전송
+    // (base: 팩 안의 데이터 시작 위치)
+    struct stat st;
+    long long base = 0, size;
+    int fd = open(path, O_RDONLY);
+    if (fd >= 0 && fstat(fd, &st) == 0)
+        size = st.st_size;
+    else
+    {
+        if (fd >= 0)
+            close(fd);
+        if (pack_lookup(job->client_id, job->filename, &fd, &base, &size) < 0 &&
+            ec_lookup(job->client_id, job->filename, &fd, &base, &size) < 0 &&
+            tier_lookup(job->client_id, job->filename, &fd, &base, &size) < 0)
+            return REPL_NO_SOURCE;
+    }
+
+    // 리터럴 버퍼: 한 번에 보내는 크기 + 블록 하나 (블록은 버퍼 끝에 읽어서 비교)
+    char *buf = malloc(REPL_CHUNK + DELTA_MAX_BLOCK);
+    DeltaSig *sigs = NULL;
+    char hex[SHA256_HEX + 1];
+    if (!buf || source_hash(fd, base, size, buf, hex) < 0)
+    {
+        free(buf);
+        close(fd);
+        return -1;
+    }
+    if (p->sd < 0 && peer_connect(p) < 0)
+    {
+        free(buf);
+        close(fd);
+        return -1;
+    }
+
+    // DELTA 전송 후 피어 파일의 블록 서명 수신 (피어는 서명을 모두 보낸 뒤에 명령을 읽음)
+    char msg[400], line[128];
+    unsigned int bs;
+    long long count;
+    int len = snprintf(msg, sizeof(msg), "DELTA %s %s %lld %s%s\n",
+                       job->client_id, job->filename, size, SHA256_TOKEN, hex);
+    if (write_all(p->sd, msg, len) < 0 || read_line(p->sd, line, sizeof(line)) < 0 ||
+        sscanf(line, "SIG %u %lld", &bs, &count) != 2 || bs == 0 || bs > DELTA_MAX_BLOCK || count < 0)
+        goto fail;
+    sigs = malloc(sizeof(DeltaSig) * (count > 0 ? count : 1));
+    if (!sigs)
+        goto fail;
+    for (long long i = 0; i < count; i++)
+    {
+        unsigned char rec[DELTA_SIG_LEN];
+        if (read_all(p->sd, rec, sizeof(rec)) < 0)
+            goto fail;
+        delta_sig_unpack(rec, &sigs[i]);
+    }
+
+    // 블록 단위로 비교 (짧게 읽히면 원본이 바뀐 것이므로 FIN 없이 실패 처리해서 재시도)
+    long long copy_start = 0, copy_count = 0;
+    int lit = 0;
+    for (long long off = 0; off < size;)
+    {
+        long long i = off / bs;
+        int n = size - off < bs ? (int)(size - off) : (int)bs;
+        if (pread_all(fd, buf + lit, n, base + off) < 0)
+            goto fail;
+
+        int same = 0;
+        if (i < count && n == (int)bs)
+        {
+            DeltaRoll r;
+            delta_roll_init(&r, (unsigned char *)buf + lit, bs);
+            same = delta_roll_value(&r) == sigs[i].weak &&
+                   delta_strong((unsigned char *)buf + lit, bs) == sigs[i].strong;
+        }
+
+        if (same)
+        {
+            if (flush_DATA(p->sd, buf, &lit, sent_bytes) < 0)
+                goto fail;
+            if (copy_count == 0)
+                copy_start = i;
+            copy_count++;
+        }
+        else
+        {
+            if (flush_COPY(p->sd, &copy_start, &copy_count) < 0)
+                goto fail;
+            lit += n;
+            if (lit >= REPL_CHUNK && flush_DATA(p->sd, buf, &lit, sent_bytes) < 0)
+                goto fail;
+        }
+        off += n;
+    }
+    if (flush_COPY(p->sd, &copy_start, &copy_count) < 0 || flush_DATA(p->sd, buf, &lit, sent_bytes) < 0)
+        goto fail;
+
+    // FIN -> COMPLETE 확인 후 연결 종료 (서버는 FIN 후 연결을 닫고, 해시가 다르면 COMPLETE 없이 닫음)
+    if (write_all(p->sd, "FIN\n", 4) < 0 || read_line(p->sd, line, sizeof(line)) < 0 ||
+        strncmp(line, "COMPLETE", 8) != 0)
+        goto fail;
+
+    close(p->sd);
+    p->sd = -1;
+    free(sigs);
+    free(buf);
+    close(fd);
+    return 0;
+
+fail:
+    close(p->sd);
+    p->sd = -1;
+    free(sigs);
+    free(buf);
+    close(fd);
+    return -1;
+}
+
+// 피어 전용 복제 스레드 - 큐에서 작업을 꺼내 순서대로 전송
+static void *replicate_worker(void *arg)
+{
+    ReplPeer *p = arg;
+
+    while (1)
+    {
+        pthread_mutex_lock(&p->lock);
+        while (p->count == 0)
+            pthread_cond_wait(&p->cond, &p->lock);
+        ReplJob job = p->queue[p->head];
+        pthread_mutex_unlock(&p->lock);
+
+        // 실패 시 지수 백오프로 재시도 (작업은 성공할 때까지 큐 앞에 유지)
+        int backoff = 1;
+        long long sent = 0;
+        int ret;
+        while ((ret = replicate_file(p, &job, &sent)) == -1)
+        {
+            pthread_mutex_lock(&p->lock);
+            p->failed++;
+            pthread_mutex_unlock(&p->lock);
+
+            fprintf(stderr, "[REPL ] peer=%s:%d file=%s/%s 실패, %d초 후 재시도\n",
+                    p->host, p->port, job.client_id, job.filename, backoff);
+            sleep(backoff);
+            if (backoff < 30)
+                backoff *= 2;
+        }
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double lag = elapsed(&job.queued_at, &now);
+
+        pthread_mutex_lock(&p->lock);
+        p->head = (p->head + 1) % REPL_QUEUE_LEN;
+        p->count--;
+        if (ret < 0)
+        {
+            p->failed++;
+            pthread_mutex_unlock(&p->lock);
+            fprintf(stderr, "[REPL ] peer=%s:%d file=%s/%s 원본 없음, 건너뜀\n", p->host, p->port,
+                    job.client_id, job.filename);
+            continue;
+        }
+        p->completed++;
+        p->bytes += sent;
+        p->last_lag = lag;
+        if (lag > p->max_lag)
+            p->max_lag = lag;
+        int pending = p->count;
+        pthread_mutex_unlock(&p->lock);
+
+        printf("[REPL ] peer=%s:%d file=%s/%s bytes=%lld lag=%.3fs pending=%d\n",
+               p->host, p->port, job.client_id, job.filename, sent, lag, pending);
+    }
+    return NULL;
+}
+
+// 복제가 밀려 있는 동안 주기적으로 지연 지표 출력
+static void *replicate_reporter(void *arg)
+{
+    (void)arg;
+
+    while (1)
+    {
+        sleep(REPL_REPORT_SEC);
+
+        int pending = 0;
+        for (int i = 0; i < peer_cnt; i++)
+        {
+            pthread_mutex_lock(&peers[i].lock);
+            pending += peers[i].count;
+            pthread_mutex_unlock(&peers[i].lock);
+        }
+        if (pending > 0)
+            replicate_report();
+    }
+    return NULL;
+}
+
+// 피어별 복제 스레드 시작
+void replicate_start(void)
+{
+    if (peer_cnt == 0)
+        return;
+
+    pthread_t t;
+    for (int i = 0; i < peer_cnt; i++)
+    {
+        pthread_create(&t, NULL, replicate_worker, &peers[i]);
+        pthread_detach(t);
+    }
+    pthread_create(&t, NULL, replicate_reporter, NULL);
+    pthread_detach(t);
+}
+
+// 완료된 업로드를 모든 피어의 복제 큐에 넣음
+// ACK 경로를 막지 않도록 큐가 가득 차면 기다리지 않고 버림
+void replicate_enqueue(const char *client_id, const char *filename)
+{
+    ReplJob job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.client_id, sizeof(job.client_id), "%s", client_id);
+    snprintf(job.filename, sizeof(job.filename), "%s", filename);
+    clock_gettime(CLOCK_MONOTONIC, &job.queued_at);
+
+    for (int i = 0; i < peer_cnt; i++)
+    {
+        ReplPeer *p = &peers[i];
+
+        pthread_mutex_lock(&p->lock);
+        if (p->count < REPL_QUEUE_LEN)
+        {
+            p->queue[(p->head + p->count) % REPL_QUEUE_LEN] = job;
+            p->count++;
+            pthread_cond_signal(&p->cond);
+        }
+        else
+        {
+            p->dropped++;
+        }
+        pthread_mutex_unlock(&p->lock);
+    }
+}
+
+// 피어별 복제 지연/처리량 통계 출력
+// (last_lag/max_lag: 큐에 들어간 시점부터 피어 COMPLETE까지 걸린 시간)
+void replicate_report(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for (int i = 0; i < peer_cnt; i++)
+    {
+        ReplPeer *p = &peers[i];
+
+        pthread_mutex_lock(&p->lock);
+        double oldest = p->count > 0 ? elapsed(&p->queue[p->head].queued_at, &now) : 0;
+        printf("[REPL ] peer=%s:%d pending=%d oldest=%.3fs completed=%ld bytes=%lld "
+               "failed=%ld dropped=%ld last_lag=%.3fs max_lag=%.3fs\n",
+               p->host, p->port, p->count, oldest, p->completed, p->bytes,
+               p->failed, p->dropped, p->last_lag, p->max_lag);
+        pthread_mutex_unlock(&p->lock);
+    }
+}
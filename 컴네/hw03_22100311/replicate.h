@@ -0,0 +1,20 @@
+#ifndef REPLICATE_H
+#define REPLICATE_H
+
+// 피어당 최대 대기 작업 수 (가득 차면 새 작업은 버려지고 dropped 증가)
+#define REPL_QUEUE_LEN 256
+#define REPL_MAX_PEERS 8
+
+// 피어 주소 추가 ("host:port"), 성공 0
+int replicate_add_peer(const char *spec);
+
+// 피어별 복제 스레드 시작
+void replicate_start(void);
+
+// 완료된 업로드를 모든 피어의 복제 큐에 넣음 (블로킹하지 않음)
+void replicate_enqueue(const char *client_id, const char *filename);
+
+// 피어별 복제 지연/처리량 통계 출력
+void replicate_report(void);
+
+#endif
@@ -0,0 +1,221 @@
+#include <string.h>
+#include <pthread.h>
+
+#include "rs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RS_X86 1
+#endif
+
+static uint8_t gf_exp[512];
+static uint8_t gf_log[256];
+
+// 곱셈 결과 니블 테이블: lo[c][x] = c * x, hi[c][x] = c * (x << 4)  (x < 16)
+static uint8_t mul_lo[256][16];
+static uint8_t mul_hi[256][16];
+
+typedef void (*MulAddFn)(uint8_t *dst, const uint8_t *src, const uint8_t *lo, const uint8_t *hi, size_t len);
+static MulAddFn mul_add_fn;
+static const char *kernel_name = "scalar";
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+// 바이트 단위 커널 (SIMD가 없을 때와 남은 꼬리 처리)
+static void mul_add_scalar(uint8_t *dst, const uint8_t *src, const uint8_t *lo, const uint8_t *hi, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        dst[i] ^= lo[src[i] & 0x0f] ^ hi[src[i] >> 4];
+}
+
+#ifdef RS_X86
+// SSSE3: pshufb로 16바이트의 하위/상위 니블을 한 번에 테이블 조회
+__attribute__((target("ssse3"))) static void mul_add_ssse3(uint8_t *dst, const uint8_t *src, const uint8_t *lo,
+                                                           const uint8_t *hi, size_t len)
+{
+    __m128i tlo = _mm_loadu_si128((const __m128i *)lo);
+    __m128i thi = _mm_loadu_si128((const __m128i *)hi);
+    __m128i mask = _mm_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i l = _mm_shuffle_epi8(tlo, _mm_and_si128(s, mask));
+        __m128i h = _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(s, 4), mask));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(d, _mm_xor_si128(l, h)));
+    }
+    mul_add_scalar(dst + i, src + i, lo, hi, len - i);
+}
+
+// AVX2: 같은 테이블을 두 레인에 복사해서 32바이트씩 처리
+__attribute__((target("avx2"))) static void mul_add_avx2(uint8_t *dst, const uint8_t *src, const uint8_t *lo,
+                                                         const uint8_t *hi, size_t len)
+{
+    __m256i tlo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)lo));
+    __m256i thi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)hi));
+    __m256i mask = _mm256_set1_epi8(0x0f);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i l = _mm256_shuffle_epi8(tlo, _mm256_and_si256(s, mask));
+        __m256i h = _mm256_shuffle_epi8(thi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask));
+        __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(d, _mm256_xor_si256(l, h)));
+    }
+    mul_add_scalar(dst + i, src + i, lo, hi, len - i);
+}
+#endif
+
+// 테이블 생성과 커널 선택
+static void rs_setup(void)
+{
+    int x = 1;
+    for (int i = 0; i < 255; i++)
+    {
+        gf_exp[i] = (uint8_t)x;
+        gf_log[x] = (uint8_t)i;
+        x <<= 1;
+        if (x & 0x100)
+            x ^= 0x11d;
+    }
+    for (int i = 255; i < 512; i++)
+        gf_exp[i] = gf_exp[i - 255];
+
+    for (int c = 0; c < 256; c++)
+    {
+        for (int v = 0; v < 16; v++)
+        {
+            mul_lo[c][v] = rs_mul((uint8_t)c, (uint8_t)v);
+            mul_hi[c][v] = rs_mul((uint8_t)c, (uint8_t)(v << 4));
+        }
+    }
+
+    mul_add_fn = mul_add_scalar;
+#ifdef RS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        mul_add_fn = mul_add_avx2;
+        kernel_name = "avx2";
+    }
+    else if (__builtin_cpu_supports("ssse3"))
+    {
+        mul_add_fn = mul_add_ssse3;
+        kernel_name = "ssse3";
+    }
+#endif
+}
+
+void rs_init(void)
+{
+    pthread_once(&init_once, rs_setup);
+}
+
+const char *rs_kernel(void)
+{
+    rs_init();
+    return kernel_name;
+}
+
+// GF(2^8) 곱셈 (로그 테이블)
+uint8_t rs_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0)
+        return 0;
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+// 역원
+static uint8_t gf_inv(uint8_t a)
+{
+    return gf_exp[255 - gf_log[a]];
+}
+
+// 부호화 행렬의 한 행 (패리티 행 p: x_p = k + p, y_j = j 인 코시 원소)
+void rs_matrix_row(int k, int row, uint8_t *out)
+{
+    rs_init();
+    for (int j = 0; j < k; j++)
+    {
+        if (row < k)
+            out[j] = row == j;
+        else
+            out[j] = gf_inv((uint8_t)(row ^ j));
+    }
+}
+
+// dst ^= c * src
+void rs_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+    if (c == 0)
+        return;
+    rs_init();
+    mul_add_fn(dst, src, mul_lo[c], mul_hi[c], len);
+}
+
+// 패리티 계산
+void rs_encode(int k, int m, uint8_t *const *data, uint8_t *const *parity, size_t len)
+{
+    uint8_t row[RS_MAX_SHARDS];
+    for (int p = 0; p < m; p++)
+    {
+        rs_matrix_row(k, k + p, row);
+        memset(parity[p], 0, len);
+        for (int j = 0; j < k; j++)
+            rs_mul_add(parity[p], data[j], row[j], len);
+    }
+}
+
+// 가우스-조르단 소거로 역행렬 계산
+int rs_invert(uint8_t *mat, int n)
+{
+    rs_init();
+    uint8_t inv[RS_MAX_SHARDS * RS_MAX_SHARDS];
+    memset(inv, 0, sizeof(uint8_t) * n * n);
+    for (int i = 0; i < n; i++)
+        inv[i * n + i] = 1;
+
+    for (int col = 0; col < n; col++)
+    {
+        // 0이 아닌 피벗 행을 찾아 올림
+        int pivot = col;
+        while (pivot < n && mat[pivot * n + col] == 0)
+            pivot++;
+        if (pivot == n)
+            return -1;
+        if (pivot != col)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                uint8_t t = mat[col * n + j];
+                mat[col * n + j] = mat[pivot * n + j];
+                mat[pivot * n + j] = t;
+                t = inv[col * n + j];
+                inv[col * n + j] = inv[pivot * n + j];
+                inv[pivot * n + j] = t;
+            }
+        }
+
+        // 피벗을 1로 맞춘 뒤 다른 행의 같은 열을 0으로
+        uint8_t f = gf_inv(mat[col * n + col]);
+        for (int j = 0; j < n; j++)
+        {
+            mat[col * n + j] = rs_mul(mat[col * n + j], f);
+            inv[col * n + j] = rs_mul(inv[col * n + j], f);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            uint8_t g = mat[i * n + col];
+            if (i == col || g == 0)
+                continue;
+            for (int j = 0; j < n; j++)
+            {
+                mat[i * n + j] ^= rs_mul(g, mat[col * n + j]);
+                inv[i * n + j] ^= rs_mul(g, inv[col * n + j]);
+            }
+        }
+    }
+    memcpy(mat, inv, n * n);
+    return 0;
+}
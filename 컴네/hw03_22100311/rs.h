@@ -0,0 +1,33 @@
+#ifndef RS_H
+#define RS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// GF(2^8) 리드-솔로몬 부호 (원시 다항식 0x11d)
+// 부호화 행렬은 체계적 형태: 데이터 샤드 k개는 단위 행, 패리티 m개는 코시 행렬 1 / (x_i ^ y_j)
+// 코시 행렬의 모든 정사각 부분 행렬은 가역이므로 k+m개 중 아무 k개로 원본 복원 가능
+#define RS_MAX_SHARDS 32
+
+// 곱셈 테이블 준비와 CPU에 맞는 커널 선택 (여러 번 호출해도 한 번만 실행)
+void rs_init(void);
+
+// 선택된 커널 이름 ("avx2", "ssse3", "scalar")
+const char *rs_kernel(void);
+
+// GF(2^8) 곱셈
+uint8_t rs_mul(uint8_t a, uint8_t b);
+
+// 부호화 행렬의 row번째 행 k개 (row < k: 단위 행, 나머지: 패리티 행)
+void rs_matrix_row(int k, int row, uint8_t *out);
+
+// dst ^= c * src (len 바이트, 니블 테이블 셔플로 16/32바이트씩 처리)
+void rs_mul_add(uint8_t *dst, const uint8_t *src, uint8_t c, size_t len);
+
+// 패리티 계산: parity[p] = sum_j row(k+p)[j] * data[j] (각 len 바이트)
+void rs_encode(int k, int m, uint8_t *const *data, uint8_t *const *parity, size_t len);
+
+// n x n 행렬 역행렬 (제자리, 특이 행렬이면 -1)
+int rs_invert(uint8_t *mat, int n);
+
+#endif
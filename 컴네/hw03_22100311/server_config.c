@@ -2,273 +2,1797 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <signal.h>
+#include <time.h>
 #include <arpa/inet.h>
 #include <pthread.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+#include "netio.h"
+#include "delta.h"
+#include "replicate.h"
+#include "journal.h"
+#include "mmap_writer.h"
+#include "filetable.h"
+#include "timerwheel.h"
+#include "gc.h"
+#include "stats.h"
+#include "trace.h"
+#include "localfd.h"
+#include "http.h"
+#include "pack.h"
+#include "pipeline.h"
+#include "lz.h"
+#include "ecstore.h"
+#include "tier.h"
+#include "sha256.h"
+#include "dedup.h"
+#include "affinity.h"
+#include "tcptune.h"
+#include "catalog.h"
 
 #define BUF_SIZE 4096
 
+// DATA 수신 버퍼 크기 (큰 청크도 이 크기로 나눠서 받아 바로 파일에 씀)
+#define RECV_BUF (256 * 1024)
+
+// HTTP GET 본문을 읽어서 보내는 단위
+#define HTTP_BODY_CHUNK (256 * 1024)
+
+// 수신 데이터 저장 방식 (-w 옵션)
+#define WRITE_PWRITE 0
+#define WRITE_MMAP 1
+#define WRITE_FSYNC 2 // pwrite 후 ACK 전에 fdatasync (ACK한 데이터는 디스크에 있음)
+
+static int write_mode = WRITE_PWRITE;
+
+// 명령/데이터 없이 이 시간(초)이 지나면 연결을 끊고 자원 해제 (-i, 0이면 사용 안 함)
+static int idle_timeout = 300;
+
+// 이 시간(초) 동안 갱신되지 않은 부분 업로드는 정리 스레드가 삭제 (-t, 0이면 삭제 안 함)
+static int partial_ttl = 24 * 60 * 60;
+
+// DATA 구간별 지연 통계 조회 포트 (-S, 127.0.0.1에서만 접속 가능)
+static int stats_port = 0;
+
+// 이 크기(바이트) 이하로 완료된 업로드는 팩 파일에 묶음 저장 (-k, 0이면 개별 파일)
+static long long pack_threshold = 0;
+
+// 수신 데이터 후처리 단계 이름 목록 (-P, 예: "crc32,sniff")
+static const char *pipe_stages = NULL;
+
+// 소거 부호 저장 설정 (-E, 예: "4+2:d0,d1,d2,d3,d4,d5", 없으면 개별 파일)
+static const char *ec_spec = NULL;
+
+// 저온 계층 설정 (-C, 예: "/slow/cold,age=86400,min=65536,rate=16777216", 없으면 옮기지 않음)
+static const char *tier_spec = NULL;
+
+// FIRST/RESUME 에 sha256을 붙인 같은 내용의 업로드를 하나로 합침 (-H)
+static int dedup_enabled = 0;
+
+// 시작할 때 업로드 목록을 디스크에서 다시 만듦 (-L)
+static int catalog_rebuild = 0;
+
+// 세션 스레드를 고정할 CPU 집합 (-A, 예: "irq:eth0", "node:0", "0-3", 없으면 고정하지 않음)
+static const char *affinity_spec = NULL;
+
+// 같은 호스트 클라이언트용 유닉스 도메인 소켓 경로 (-u, 없으면 TCP만)
+static const char *unix_path = NULL;
+
+// FILEFD 복사 중 유휴 타이머를 갱신하는 간격 (바이트)
+#define LOCAL_COPY_STEP (64LL * 1024 * 1024)
+
+// 세션 스레드에 넘기는 연결 정보
+typedef struct
+{
+    int sd;
+    int local; // 유닉스 도메인 소켓 연결 (디스크립터 전달 가능)
+} ClientConn;
+
 typedef struct
 {
     // Socket descriptor
     int sd;
+    // 유닉스 도메인 소켓 연결이면 명령과 함께 전달된 원본 파일 디스크립터 (없으면 -1)
+    int local;
+    int passed_fd;
     // 클라이언트 ID와 파일 정보
     char client_id[64];
     char filename[256];
     char filepath[512];
 
-    FILE *fp;
-    long stored_offset;
-    long expected_size;
-} UploadSession;
+    // 업로드 파일 (64비트 오프셋으로 pwrite)
+    int fd;
+    long long stored_offset;
+    long long expected_size;
+
+    // 청크 저널: ./<id>/.<file>.journal 에 (offset, len, crc) 기록
+    int journal_fd;
+    char journalpath[520];
+
+    // mmap 수신 모드: 크기를 아는 업로드는 미리 할당한 파일 매핑에 직접 수신
+    int use_mmap;
+    MmapWriter mw;
+
+    // 델타 업로드: 기존 파일(base_fd)의 블록을 참조해 임시 파일(fd)에 재구성
+    int delta;
+    int base_fd;
+    long long base_off; // base_fd 안에서 기존 파일이 시작하는 위치 (팩 파일이면 레코드 데이터 위치)
+    char tmppath[520];
+    uint32_t block_size;
+    long long block_count;
+
+    // 다른 서버가 보낸 복제 연결이면 다시 복제하지 않음
+    int from_peer;
+
+    // 같은 파일을 쓰는 연결들이 공유하는 수신 구간 (delta 모드에서는 NULL)
+    UploadFile *file;
+
+    // 수신 데이터 후처리 파이프라인 (-P 없으면 NULL)
+    Pipeline *pipe;
+
+    // FIRST/RESUME에서 청크 압축(ZDATA)을 협상함
+    int compress;
+
+    // 클라이언트가 알려준 파일 해시 (없으면 빈 문자열)와 0부터 순서대로 받은 데이터의 해시 (완료 때 확인해서 목록에 기록),
+    // 같은 내용 합치기(-H)의 대표로 받는 중이면 그 등록 정보,
+    // 완료된 같은 내용에 연결했으면 linked (읽기 전용으로 열고 쓰지 않음)
+    char sha256[SHA256_HEX + 1];
+    DedupFlight *flight;
+    Sha256 hash;
+    long long hashed;
+    int linked;
+
+    // 유휴 타이머: 명령/데이터를 받을 때마다 다시 설정, 만료되면 소켓을 닫아 스레드를 깨움
+    TimerEntry idle;
+    int timed_out;
+} UploadSession;
+
+// 유휴 타이머 만료 - 블로킹된 read를 깨워서 세션 스레드가 스스로 정리하도록 함
+static void session_idle(void *arg)
+{
+    UploadSession *s = arg;
+    s->timed_out = 1;
+    shutdown(s->sd, SHUT_RDWR);
+}
+
+// 세션 활동 알림 (유휴 타이머 재설정)
+static void session_touch(UploadSession *s)
+{
+    if (idle_timeout > 0)
+        timer_arm(&s->idle, idle_timeout);
+}
+
+// 클라이언트에게 ACK 메시지를 전송하는 함수
+void send_ACK(int sd, long long offset)
+{
+    char msg[64];
+    int len = sprintf(msg, "ACK %lld\n", offset);
+
+    int sent = 0;
+    int write_cnt;
+
+    // 전체 메시지가 전송될 때까지 반복
+    while (sent < len)
+    {
+        // 부분적으로 메시지 전송 (부분 = write_cnt = 실제로 전송된 바이트 수)
+        write_cnt = write(sd, msg + sent, len - sent);
+
+        // 조건: 전송 실패 시 함수 종료
+        if (write_cnt <= 0)
+            return;
+
+        // 전송된 바이트 수 누적
+        sent += write_cnt;
+    }
+}
+
+// FIRST/RESUME 응답 - 압축을 요청받았으면 코덱 이름을 붙여 지원함을 알림
+// (모르는 서버는 ACK만 보내므로 클라이언트는 원본 그대로 전송)
+static void send_ACK_codec(UploadSession *s)
+{
+    if (!s->compress)
+    {
+        send_ACK(s->sd, s->stored_offset);
+        return;
+    }
+    char msg[64];
+    int len = sprintf(msg, "ACK %lld %s\n", s->stored_offset, LZ_CODEC);
+    write_all(s->sd, msg, len);
+}
+
+// 클라이언트에게 COMPLETE 메시지를 전송하는 함수
+void send_COMPLETE(int sd)
+{
+    const char *msg = "COMPLETE\n";
+    int len = strlen(msg);
+
+    int sent = 0;
+    int write_cnt;
+
+    // 전체 메시지가 전송될 때까지 반복
+    while (sent < len)
+    {
+        write_cnt = write(sd, msg + sent, len - sent);
+        if (write_cnt <= 0)
+            return;
+        sent += write_cnt;
+    }
+}
+
+// 팩이나 소거 부호 샤드로 옮겨진 완료 업로드를 원래 자리로 되돌림 (이어받기 오프셋을 파일 크기로 알려주기 위해)
+// 파일이나 저널이 이미 있으면 아무것도 안 함, 파일 lock을 잡은 상태에서 호출 (되돌렸으면 1)
+// 팩 레코드는 남겨 둠 (다음 FIN의 pack_finish가 새 레코드로 바꾸거나 삭제)
+static int restore_sealed(UploadSession *s)
+{
+    struct stat st;
+    int in;
+    long long base, len;
+    if (stat(s->filepath, &st) == 0 || stat(s->journalpath, &st) == 0)
+        return 0;
+    int packed = pack_lookup(s->client_id, s->filename, &in, &base, &len) == 0;
+    if (!packed && ec_lookup(s->client_id, s->filename, &in, &base, &len) < 0)
+        return 0;
+    const char *from = packed ? "pack" : "ec";
+
+    char tmp[600];
+    snprintf(tmp, sizeof(tmp), "./%s/.%s.restore.tmp", s->client_id, s->filename);
+    int out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    char *buf = malloc(RECV_BUF);
+    int ok = out >= 0 && buf;
+    for (long long done = 0; ok && done < len; done += RECV_BUF)
+    {
+        size_t want = len - done < RECV_BUF ? (size_t)(len - done) : RECV_BUF;
+        ok = pread_all(in, buf, want, base + done) == 0 && pwrite_all(out, buf, want, done) == 0;
+    }
+    free(buf);
+    close(in);
+    ok = ok && fsync(out) == 0;
+    if (out >= 0)
+        close(out);
+    if (!ok || rename(tmp, s->filepath) < 0)
+    {
+        unlink(tmp);
+        printf("[FIRST] id=%s file=%s %s에서 되돌리기 실패\n", s->client_id, s->filename, from);
+        return 0;
+    }
+
+    if (!packed)
+        ec_remove(s->client_id, s->filename);
+    catalog_set_state(s->client_id, s->filename, CATALOG_FILE);
+    printf("[FIRST] id=%s file=%s restored from %s (%lld bytes)\n", s->client_id, s->filename, from, len);
+    return 1;
+}
+
+// 이어받기 오프셋을 복구하고 파일과 저널을 여는 함수
+void open_upload(UploadSession *s)
+{
+    sprintf(s->journalpath, "./%s/.%s.journal", s->client_id, s->filename);
+
+    // 같은 파일을 쓰는 다른 연결과 수신 구간을 공유
+    filetable_release(s->file);
+    int created;
+    s->file = filetable_acquire(s->filepath, &created);
+    if (!s->file)
+    {
+        s->stored_offset = 0;
+        return;
+    }
+
+    // 처음 여는 파일만 복구 (다른 연결이 쓰는 중에는 자르지 않음)
+    long long recovered = -1;
+    int restored = 0;
+    if (created)
+    {
+        // 저온 계층으로 옮겨진 완료 업로드면 원래 자리로 되돌린 뒤 이어받기
+        tier_thaw(s->client_id, s->filename, s->filepath);
+
+        // 팩이나 샤드로 옮겨진 완료 업로드도 원래 자리로 되돌림 (아니면 오프셋 0으로 처음부터 다시 받음)
+        restore_sealed(s);
+
+        // 저널이 있으면 마지막 레코드들을 검증해서 찢어진 꼬리를 잘라냄
+        recovered = journal_recover(s->journalpath, s->filepath, &s->file->extents);
+
+        // 저널이 없으면 파일 끝을 오프셋으로 사용
+        // 파일이 존재하면 끝으로 이동하여 크기 측정
+        struct stat st;
+        if (recovered < 0 && stat(s->filepath, &st) == 0)
+            extent_add(&s->file->extents, 0, st.st_size);
+    }
+    else
+    {
+        pthread_mutex_lock(&s->file->lock);
+
+        // 백그라운드 봉인(ec_enqueue)이 잡고 있던 파일이면 그 사이 샤드로 옮겨졌을 수 있음
+        struct stat st;
+        restored = extent_max_end(&s->file->extents) == 0 && restore_sealed(s) && stat(s->filepath, &st) == 0;
+        if (restored)
+            extent_add(&s->file->extents, 0, st.st_size);
+    }
+
+    // 같은 내용의 다른 업로드와 하드 링크로 공유하는 파일이면 이 연결이 쓰기 전에 분리
+    if (!s->linked)
+        dedup_unshare(s->filepath);
+    s->stored_offset = extent_prefix(&s->file->extents);
+    long long max_end = extent_max_end(&s->file->extents);
+    pthread_mutex_unlock(&s->file->lock);
+
+    // 이전에 열려 있던 파일 정리
+    if (s->fd >= 0)
+        close(s->fd);
+    s->fd = -1;
+    if (s->use_mmap)
+        mmap_writer_close(&s->mw, -1);
+    s->use_mmap = 0;
+
+    // 크기를 아는 업로드는 미리 할당 후 매핑 (실패하면 pwrite로 대체)
+    if (write_mode == WRITE_MMAP && s->expected_size > 0 && !s->linked)
+    {
+        long long prealloc = s->expected_size > max_end ? s->expected_size : max_end;
+        if (mmap_writer_open(&s->mw, s->filepath, prealloc) == 0)
+            s->use_mmap = 1;
+    }
+
+    // 위치 지정 쓰기(pwrite)를 위해 이어쓰기(O_APPEND)가 아닌 쓰기 모드로 열기
+    // (같은 내용에 연결한 파일은 다른 업로드와 공유하므로 읽기 전용)
+    if (!s->use_mmap)
+        s->fd = open(s->filepath, s->linked ? O_RDONLY : O_WRONLY | O_CREAT, 0644);
+
+    // 저널 열기 (저널 없이 있던 데이터는 기준 레코드로 기록, 연결한 파일은 이미 완료라 저널 없음)
+    if (s->journal_fd >= 0)
+        close(s->journal_fd);
+    s->journal_fd = s->linked ? -1 : journal_open(s->journalpath);
+    if (s->journal_fd >= 0 && ((created && recovered < 0) || restored) && s->stored_offset > 0)
+        journal_append_base(s->journal_fd, s->stored_offset);
+
+    // 이전 업로드의 파이프라인은 결과 없이 정리하고 새로 시작
+    pipeline_end(s->pipe, NULL, NULL, 0);
+    s->pipe = pipeline_begin(s->stored_offset);
+}
+
+// 같은 내용 합치기에서 기다리는 동안 유휴로 보지 않음
+static void session_alive(void *arg)
+{
+    session_touch(arg);
+}
+
+// FIRST/RESUME 끝의 선택 토큰 처리 - 압축 코덱 이름, 파일 해시 (sha256=<16진수 64자>)
+static void parse_upload_options(UploadSession *s, const char *opt1, const char *opt2)
+{
+    const char *opts[2] = {opt1, opt2};
+    s->compress = 0;
+    s->sha256[0] = '\0';
+    for (int i = 0; i < 2; i++)
+    {
+        if (strcmp(opts[i], LZ_CODEC) == 0)
+            s->compress = 1;
+        else if (strncmp(opts[i], SHA256_TOKEN, strlen(SHA256_TOKEN)) == 0 &&
+                 sha256_valid_hex(opts[i] + strlen(SHA256_TOKEN)))
+            strcpy(s->sha256, opts[i] + strlen(SHA256_TOKEN));
+    }
+}
+
+// 아직 없는 파일을 같은 해시의 업로드에 합류시킴 (-H, open_upload 전에 호출)
+// 완료된 같은 내용이 있거나 받는 중인 대표가 끝나면 하드 링크로 연결, 아니면 직접 받음 (기다리다 끊기면 -1)
+// 팩/소거 부호 샤드로 옮겨지는 업로드는 하드 링크로 공유할 수 없으므로 합치지 않음
+static int coalesce_upload(UploadSession *s)
+{
+    // 같은 연결에서 이전에 대표로 받던 업로드는 끝나지 않은 것으로 처리
+    dedup_done(s->flight, s->filepath, 0);
+    s->flight = NULL;
+    s->linked = 0;
+    sha256_init(&s->hash);
+    s->hashed = 0;
+
+    struct stat st;
+    if (!dedup_enabled || s->sha256[0] == '\0' || s->expected_size <= pack_threshold ||
+        s->expected_size <= 0 || ec_spec || stat(s->filepath, &st) == 0)
+        return 0;
+
+    int r = dedup_join(s->sha256, s->expected_size, s->filepath, s->sd, session_alive, s, &s->flight);
+    if (r < 0)
+        return -1;
+    s->linked = r;
+    if (s->linked)
+        printf("[DEDUP] id=%s file=%s 같은 내용의 완료 업로드에 연결 (%lld bytes)\n",
+               s->client_id, s->filename, s->expected_size);
+    else if (s->flight)
+        printf("[DEDUP] id=%s file=%s sha256=%.16s 대표로 받음\n", s->client_id, s->filename, s->sha256);
+    return 0;
+}
+
+// FIRST 명령 처리 함수 - 클라이언트 ID, 파일 이름, 파일 크기를 받아 세션 초기화
+int handle_FIRST(UploadSession *s, char *id, char *file, long long filesize)
+{
+    // 세션 정보 설정
+    strcpy(s->client_id, id);
+    strcpy(s->filename, file);
+
+    // 예상 파일 크기 설정
+    s->expected_size = filesize;
+
+    // 클라이언트 ID에 해당하는 디렉토리 생성
+    mkdir(id, 0777);
+    sprintf(s->filepath, "./%s/%s", id, file);
+
+    // 같은 내용을 이미 받았거나 받는 중이면 합류
+    if (coalesce_upload(s) < 0)
+        return -1;
+
+    open_upload(s);
+
+    // 현재 오프셋을 클라이언트에게 전송
+    send_ACK_codec(s);
+
+    return 0;
+}
+
+// RESUME 명령 처리 함수 - 클라이언트 ID와 파일 이름을 받아 세션 복원
+// (filesize: 클라이언트가 알려준 전체 크기, 모르면 0)
+int handle_RESUME(UploadSession *s, char *id, char *file, long long filesize)
+{
+    // 세션 정보 설정
+    strcpy(s->client_id, id);
+    strcpy(s->filename, file);
+    s->expected_size = filesize;
+
+    sprintf(s->filepath, "./%s/%s", id, file);
+
+    // 같은 내용을 기다리다 끊긴 연결이면 다시 합류
+    if (coalesce_upload(s) < 0)
+        return -1;
+
+    open_upload(s);
+
+    // 현재 오프셋을 클라이언트에게 전송
+    send_ACK_codec(s);
+
+    return 0;
+}
+
+// 받은 구간 기록 후 stored_offset 갱신 (공유 구간 목록에서 0부터 연속된 끝)
+static void mark_received(UploadSession *s, long long offset, long long len)
+{
+    if (s->file)
+    {
+        pthread_mutex_lock(&s->file->lock);
+        extent_add(&s->file->extents, offset, offset + len);
+        s->stored_offset = extent_prefix(&s->file->extents);
+        pthread_mutex_unlock(&s->file->lock);
+    }
+    else
+    {
+        s->stored_offset += len;
+    }
+
+    // 같은 내용을 기다리는 연결에 보낼 진행 상황
+    if (s->flight)
+        dedup_progress(s->flight, s->stored_offset);
+}
+
+// 해시를 알려준 업로드의 데이터가 0부터 순서대로 이어지면 해시에 추가
+// (순서가 바뀌거나 다른 경로로 받은 부분은 완료 때 파일에서 읽어서 계산)
+static void hash_feed(UploadSession *s, long long offset, const void *buf, long long len)
+{
+    if (s->sha256[0] && !s->linked && offset == s->hashed)
+    {
+        sha256_update(&s->hash, buf, len);
+        s->hashed += len;
+    }
+}
+
+// 정해진 크기만큼만 데이터를 수신해서 파일에 저장하고 stored_offset 갱신 (DATA, HTTP PATCH 공용)
+// offset < 0 이면 기존 방식(stored_offset 위치에 이어쓰기), 아니면 지정한 위치에 저장
+static int recv_chunk(UploadSession *s, long long offset, long long chunkSize)
+{
+    // 청크 크기 검증 (최대 MAX_CHUNK_SIZE)
+    if (chunkSize < 0 || chunkSize > MAX_CHUNK_SIZE)
+        return -1;
+    if (offset >= 0 && (s->delta || !s->file))
+        return -1;
+    if (s->fd < 0 && !s->use_mmap)
+        return -1;
+    if (offset < 0)
+        offset = s->stored_offset;
+
+    // 청크 본문을 받는 동안 ACK를 미루지 않아 보내는 쪽 창이 빨리 열림
+    tune_quickack(s->sd);
+
+    // 구간별 소요 시간 (계측을 끄고 빌드하면 모두 0이고 기록 코드도 사라짐)
+    long long t_start = stats_now();
+    long long t_journal;
+
+    // mmap 모드: 소켓에서 파일 매핑으로 바로 수신 (중간 버퍼 없음)
+    if (s->use_mmap)
+    {
+        uint32_t crc;
+        if (mmap_writer_recv(&s->mw, s->sd, offset, chunkSize, &crc) < 0)
+            return -1;
+        if (offset >= s->mw.map_base &&
+            offset + chunkSize <= s->mw.map_base + (long long)s->mw.map_len)
+            hash_feed(s, offset, s->mw.map + (offset - s->mw.map_base), chunkSize);
+        t_journal = stats_now();
+        stats_record(STATS_MMAP, t_journal - t_start);
+        if (s->journal_fd >= 0)
+            journal_append_crc(s->journal_fd, offset, chunkSize, crc);
+
+        // 후처리 단계로 넘김 (매핑에 받은 구간을 페이지 캐시에서 다시 읽어 복사)
+        pipeline_feed_fd(s->pipe, s->mw.fd, offset, chunkSize);
+    }
+    else
+    {
+        // 1. 고정 크기 버퍼로 소켓에서 읽는 대로 파일의 offset 위치에 저장
+        //    (청크 전체를 메모리에 올리지 않으므로 1GB 청크도 처리 가능)
+        size_t bufsize = chunkSize < RECV_BUF ? (size_t)chunkSize : RECV_BUF;
+        char *buf = malloc(bufsize > 0 ? bufsize : 1);
+        if (!buf)
+            return -1;
+
+        uint32_t crc = 0;
+        long long received = 0;
+        long long t_recv = 0, t_write = 0;
+        while (received < chunkSize)
+        {
+            long long want = chunkSize - received;
+            long long t0 = stats_now();
+            ssize_t n = read(s->sd, buf, want < (long long)bufsize ? (size_t)want : bufsize);
+            long long t1 = stats_now();
+            if (n <= 0 || pwrite_all(s->fd, buf, n, offset + received) < 0)
+            {
+                free(buf);
+                return -1;
+            }
+            t_recv += t1 - t0;
+            t_write += stats_now() - t1;
+            crc = crc32_update(crc, buf, n);
+            hash_feed(s, offset + received, buf, n);
+
+            // 파일에 쓴 버퍼를 후처리 단계로 넘김 (작업 스레드에서 전송과 겹쳐 실행)
+            pipeline_feed(s->pipe, offset + received, buf, n);
+            received += n;
+
+            // 큰 청크를 천천히 받는 중에도 유휴로 보지 않음
+            session_touch(s);
+        }
+        free(buf);
+
+        // -w fsync: 저널에 기록하기 전에 데이터를 디스크로 내림 (ACK한 구간은 전원이 나가도 남음)
+        if (write_mode == WRITE_FSYNC)
+        {
+            long long t_sync = stats_now();
+            if (fdatasync(s->fd) < 0)
+                return -1;
+            t_write += stats_now() - t_sync;
+        }
+        stats_record(STATS_RECV, t_recv);
+        stats_record(STATS_WRITE, t_write);
+
+        // 2. 파일에 쓴 직후 저널에 (offset, len, crc) 기록 - 재시작 시 검증 지점
+        t_journal = stats_now();
+        if (s->journal_fd >= 0)
+            journal_append_crc(s->journal_fd, offset, chunkSize, crc);
+    }
+    stats_record(STATS_JOURNAL, stats_now() - t_journal);
+
+    gc_note_io();
+
+    // 3. stored_offset 업데이트 (공유 구간 목록에서 0부터 연속된 끝)
+    mark_received(s, offset, chunkSize);
+
+    stats_record(STATS_CHUNK, stats_now() - t_start);
+    return 0;
+}
+
+// 메모리에 있는 청크를 offset 위치에 저장 (ZDATA: 압축을 푼 데이터를 파일, 저널, 후처리에 반영)
+static int store_chunk(UploadSession *s, long long offset, const char *buf, long long len)
+{
+    int fd = s->use_mmap ? s->mw.fd : s->fd;
+    if (fd < 0)
+        return -1;
+
+    long long t_start = stats_now();
+    if (pwrite_all(fd, buf, len, offset) < 0 || (write_mode == WRITE_FSYNC && fdatasync(fd) < 0))
+        return -1;
+    long long t_journal = stats_now();
+    stats_record(STATS_WRITE, t_journal - t_start);
+    if (s->journal_fd >= 0)
+        journal_append_crc(s->journal_fd, offset, len, crc32_update(0, buf, len));
+    stats_record(STATS_JOURNAL, stats_now() - t_journal);
+
+    pipeline_feed(s->pipe, offset, buf, len);
+    hash_feed(s, offset, buf, len);
+    gc_note_io();
+    mark_received(s, offset, len);
+    stats_record(STATS_CHUNK, stats_now() - t_start);
+    return 0;
+}
+
+// DATA 명령 처리 함수 - 청크를 수신해서 저장한 뒤 업데이트된 stored_offset을 ACK로 전송
+int handle_DATA(UploadSession *s, long long offset, long long chunkSize)
+{
+    if (recv_chunk(s, offset, chunkSize) < 0)
+        return -1;
+
+    long long t_ack = stats_now();
+    send_ACK(s->sd, s->stored_offset);
+    stats_record(STATS_ACK, stats_now() - t_ack);
+    return 0;
+}
+
+// ZDATA 명령 처리 함수 - 압축된 청크를 받아 풀어서 stored_offset 위치에 저장한 뒤 ACK (오프셋은 원본 기준)
+int handle_ZDATA(UploadSession *s, long long len, long long zlen)
+{
+    if (len <= 0 || len > LZ_CHUNK_MAX || zlen <= 0 || zlen >= len)
+        return -1;
+
+    char *z = malloc(zlen);
+    char *buf = malloc(len);
+    int ret = -1;
+    tune_quickack(s->sd);
+    if (z && buf && read_all(s->sd, z, zlen) == 0)
+    {
+        session_touch(s);
+        if (lz_decompress(z, zlen, buf, len) == len)
+            ret = store_chunk(s, s->stored_offset, buf, len);
+    }
+    free(z);
+    free(buf);
+    if (ret < 0)
+        return -1;
+
+    long long t_ack = stats_now();
+    send_ACK(s->sd, s->stored_offset);
+    stats_record(STATS_ACK, stats_now() - t_ack);
+    return 0;
+}
+
+// HOLES 명령 처리 함수 - 아직 받지 못한 구간 목록 전송
+// 응답: "HOLES <n>\n" 다음에 "<start> <end>\n" n줄
+int handle_HOLES(UploadSession *s)
+{
+    if (!s->file)
+        return -1;
+
+    pthread_mutex_lock(&s->file->lock);
+    long long size = s->expected_size;
+    if (size <= 0)
+        size = extent_max_end(&s->file->extents);
+    int cnt = extent_holes(&s->file->extents, size, NULL, 0);
+    Extent *holes = malloc(sizeof(Extent) * (cnt > 0 ? cnt : 1));
+    if (holes)
+        extent_holes(&s->file->extents, size, holes, cnt);
+    pthread_mutex_unlock(&s->file->lock);
+    if (!holes)
+        return -1;
+
+    char msg[64];
+    int len = sprintf(msg, "HOLES %d\n", cnt);
+    int ret = write_all(s->sd, msg, len);
+    for (int i = 0; i < cnt && ret == 0; i++)
+    {
+        len = sprintf(msg, "%lld %lld\n", holes[i].start, holes[i].end);
+        ret = write_all(s->sd, msg, len);
+    }
+    free(holes);
+    return ret;
+}
+
+// LIST 명령 처리 함수 - 완료된 업로드 목록 (이름 순, prefix로 시작하고 after 다음부터 최대 limit개)
+// 응답: "LIST <보낸 개수> <조건에 맞는 전체 개수>" 뒤에 한 줄씩 "<filename> <size> <mtime> <state> <sha256|->"
+int handle_LIST(UploadSession *s, const char *id, int limit, const char *prefix, const char *after)
+{
+    if (limit <= 0)
+        limit = CATALOG_LIST_DEFAULT;
+    if (limit > CATALOG_LIST_MAX)
+        limit = CATALOG_LIST_MAX;
+    CatalogItem *items = malloc(sizeof(CatalogItem) * limit);
+    if (!items)
+        return -1;
+    long long matched;
+    int cnt = catalog_list(id, prefix, after, items, limit, &matched);
+
+    // 응답 전체를 버퍼 하나에 만들어서 보냄
+    char *msg = malloc(64 + (size_t)cnt * (sizeof(items[0].name) + 128));
+    if (!msg)
+    {
+        free(items);
+        return -1;
+    }
+    int len = sprintf(msg, "LIST %d %lld\n", cnt, matched);
+    for (int i = 0; i < cnt; i++)
+        len += sprintf(msg + len, "%s %lld %lld %s %s\n", items[i].name, items[i].size, items[i].mtime,
+                       catalog_state_name(items[i].state), items[i].sha256[0] ? items[i].sha256 : "-");
+    free(items);
+
+    tune_bulk_begin(s->sd);
+    int ret = write_all(s->sd, msg, len);
+    tune_bulk_end(s->sd);
+    free(msg);
+    return ret;
+}
+
+// 세션이 붙잡고 있는 업로드 자원 정리 (같은 연결에서 새 업로드를 시작하거나 연결이 끝날 때)
+// 끝나지 않은 델타 재구성의 임시 파일은 이어받지 않으므로 바로 삭제
+static void session_release(UploadSession *s)
+{
+    if (s->fd >= 0)
+        close(s->fd);
+    s->fd = -1;
+    if (s->base_fd >= 0)
+        close(s->base_fd);
+    s->base_fd = -1;
+    if (s->journal_fd >= 0)
+        close(s->journal_fd);
+    s->journal_fd = -1;
+    pipeline_end(s->pipe, NULL, NULL, 0);
+    s->pipe = NULL;
+    if (s->use_mmap)
+        mmap_writer_close(&s->mw, -1);
+    s->use_mmap = 0;
+    filetable_release(s->file);
+    s->file = NULL;
+    // 대표로 받던 업로드가 끝나지 않았으면 기다리던 연결이 이어받음
+    dedup_done(s->flight, s->filepath, 0);
+    s->flight = NULL;
+    if (s->delta)
+        unlink(s->tmppath);
+    s->delta = 0;
+}
+
+// DELTA 명령 처리 함수 - 기존 파일의 블록 서명을 전송하고 임시 파일에 재구성 시작
+// 재구성한 파일은 FIN에서 클라이언트가 알려준 sha256과 비교한 뒤에만 원본과 교체
+int handle_DELTA(UploadSession *s, char *id, char *file, long long filesize)
+{
+    // 앞선 업로드나 델타가 열어 둔 파일 정리
+    session_release(s);
+
+    if (!s->sha256[0])
+    {
+        printf("[DELTA] id=%s file=%s sha256 없음 - 거부\n", id, file);
+        return -1;
+    }
+
+    // 세션 정보 설정
+    strcpy(s->client_id, id);
+    strcpy(s->filename, file);
+    s->expected_size = filesize;
+    s->linked = 0;
+    sha256_init(&s->hash);
+    s->hashed = 0;
+
+    // 같은 이름을 동시에 재구성하는 연결끼리 임시 파일이 겹치지 않도록 프로세스와 소켓 번호를 붙임
+    mkdir(id, 0777);
+    sprintf(s->filepath, "./%s/%s", id, file);
+    sprintf(s->tmppath, "./%s/.%s.%d-%d.delta", id, file, (int)getpid(), s->sd);
+
+    // 기존 파일 크기 측정 (없으면 서명 0개)
+    long long base_size = 0;
+    struct stat st;
+    s->base_fd = open(s->filepath, O_RDONLY);
+    if (s->base_fd >= 0 && fstat(s->base_fd, &st) == 0)
+        base_size = st.st_size;
+
+    // 팩에 묶인 파일은 팩 파일의 레코드 위치에서, 소거 부호 샤드나 저온 계층에 있는 파일은 임시 파일로 풀어서 기준으로 사용
+    s->base_off = 0;
+    if (s->base_fd < 0 && pack_lookup(id, file, &s->base_fd, &s->base_off, &base_size) < 0 &&
+        ec_lookup(id, file, &s->base_fd, &s->base_off, &base_size) < 0 &&
+        tier_lookup(id, file, &s->base_fd, &s->base_off, &base_size) < 0)
+        base_size = 0;
+
+    // 마지막 부분 블록은 서명하지 않음 (클라이언트가 리터럴로 전송)
+    s->block_size = delta_block_size(base_size);
+    s->block_count = base_size / s->block_size;
+
+    char header[64];
+    int len = sprintf(header, "SIG %u %lld\n", s->block_size, s->block_count);
+    if (write_all(s->sd, header, len) < 0)
+        return -1;
+
+    // 블록마다 weak/strong 서명을 계산해서 묶음 단위로 전송
+    unsigned char *block = malloc(s->block_size);
+    unsigned char out[DELTA_SIG_LEN * 256];
+    int out_len = 0;
+    if (!block)
+        return -1;
+
+    for (long long i = 0; i < s->block_count; i++)
+    {
+        if (pread_all(s->base_fd, block, s->block_size, s->base_off + i * s->block_size) < 0)
+        {
+            free(block);
+            return -1;
+        }
+
+        DeltaRoll r;
+        DeltaSig sig;
+        delta_roll_init(&r, block, s->block_size);
+        sig.weak = delta_roll_value(&r);
+        sig.strong = delta_strong(block, s->block_size);
+        delta_sig_pack(&sig, out + out_len);
+        out_len += DELTA_SIG_LEN;
+
+        if (out_len == (int)sizeof(out))
+        {
+            if (write_all(s->sd, out, out_len) < 0)
+            {
+                free(block);
+                return -1;
+            }
+            out_len = 0;
+        }
+    }
+    free(block);
+    if (out_len > 0 && write_all(s->sd, out, out_len) < 0)
+        return -1;
+
+    // 새 버전은 임시 파일에 처음부터 재구성 (이후 DATA는 리터럴로 취급)
+    s->fd = open(s->tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (s->fd < 0)
+        return -1;
+    s->stored_offset = 0;
+    s->delta = 1;
+    return 0;
+}
+
+// COPY 명령 처리 함수 - 기존 파일의 블록을 임시 파일로 복사
+int handle_COPY(UploadSession *s, long long block, long long count)
+{
+    // 델타 모드가 아니거나 범위를 벗어난 블록 참조는 거부
+    if (!s->delta || block < 0 || count <= 0 || block + count > s->block_count)
+        return -1;
+
+    char buf[BUF_SIZE];
+    long long src = block * s->block_size;
+    long long total = count * s->block_size;
+
+    for (long long done = 0; done < total;)
+    {
+        size_t want = total - done < (long long)sizeof(buf) ? (size_t)(total - done) : sizeof(buf);
+        if (pread_all(s->base_fd, buf, want, s->base_off + src + done) < 0 ||
+            pwrite_all(s->fd, buf, want, s->stored_offset + done) < 0)
+            return -1;
+        hash_feed(s, s->stored_offset + done, buf, want);
+        done += want;
+    }
+
+    // 재구성된 파일 기준 오프셋을 ACK로 전송
+    s->stored_offset += total;
+    send_ACK(s->sd, s->stored_offset);
+    return 0;
+}
+
+// FILEFD 명령 처리 함수 - 명령과 함께 전달받은 원본 파일에서 [stored_offset, size) 를 직접 복사
+// 소켓으로 데이터를 받지 않고 커널 안에서 파일 대 파일로 복사한 뒤 DATA와 같은 ACK로 응답
+int handle_FILEFD(UploadSession *s, long long size)
+{
+    if (!s->local || s->passed_fd < 0 || s->delta || !s->file || size < s->stored_offset)
+        return -1;
+
+    int out_fd = s->use_mmap ? s->mw.fd : s->fd;
+    if (out_fd < 0)
+        return -1;
+
+    // 큰 파일도 유휴로 끊기지 않도록 나눠서 복사
+    for (long long off = s->stored_offset; off < size;)
+    {
+        long long len = size - off < LOCAL_COPY_STEP ? size - off : LOCAL_COPY_STEP;
+        if (copy_range(s->passed_fd, out_fd, off, len) < 0)
+            return -1;
+        off += len;
+        session_touch(s);
+    }
+    close(s->passed_fd);
+    s->passed_fd = -1;
+
+    // [0, size) 가 모두 채워졌으므로 저널에는 기준 레코드 하나만 기록 (데이터를 다시 읽어 CRC를 계산하지 않음)
+    if (s->journal_fd >= 0)
+        journal_append_base(s->journal_fd, size);
+
+    gc_note_io();
+
+    pthread_mutex_lock(&s->file->lock);
+    extent_add(&s->file->extents, 0, size);
+    s->stored_offset = extent_prefix(&s->file->extents);
+    pthread_mutex_unlock(&s->file->lock);
+
+    send_ACK(s->sd, s->stored_offset);
+    return 0;
+}
+
+// 받은 파일(path)의 해시가 클라이언트가 알려준 값과 같은지 확인 (같으면 1)
+// 순서대로 받으며 계산하지 못한 나머지는 파일에서 읽어서 이어서 계산
+static int verify_hash(UploadSession *s, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return 0;
+    char *buf = malloc(RECV_BUF);
+    while (buf)
+    {
+        ssize_t n = pread(fd, buf, RECV_BUF, s->hashed);
+        if (n <= 0)
+            break;
+        sha256_update(&s->hash, buf, n);
+        s->hashed += n;
+    }
+    free(buf);
+    close(fd);
+
+    char hex[SHA256_HEX + 1];
+    sha256_final_hex(&s->hash, hex);
+    if (s->hashed == s->expected_size && strcmp(hex, s->sha256) == 0)
+        return 1;
+    printf("[HASH ] id=%s file=%s sha256 불일치 (받은 내용 %.16s, 알려준 값 %.16s) - 기록하지 않음\n",
+           s->client_id, s->filename, hex, s->sha256);
+    return 0;
+}
+
+// 업로드 완료 처리 - 파일을 닫고 저널 삭제, 델타면 원본 교체 후 복제 큐에 등록 (FIN, HTTP 공용)
+static int finish_upload(UploadSession *s)
+{
+    // 미리 할당한 파일은 실제 받은 크기로 잘라서 닫기
+    // (같은 파일을 매핑한 다른 연결이 남아 있으면 마지막 연결이 놓을 때 자름)
+    long long trim_later = -1;
+    if (s->use_mmap)
+    {
+        long long end = s->stored_offset;
+        pthread_mutex_lock(&s->file->lock);
+        if (extent_max_end(&s->file->extents) > end)
+            end = extent_max_end(&s->file->extents);
+        pthread_mutex_unlock(&s->file->lock);
+
+        mmap_writer_close(&s->mw, -1);
+        s->use_mmap = 0;
+        if (!filetable_trim(s->file, end))
+        {
+            trim_later = end;
+            printf("[MMAP ] id=%s file=%s 다른 연결이 쓰는 중 - 자르기를 마지막 연결로 미룸\n",
+                   s->client_id, s->filename);
+        }
+    }
+    else if (s->fd >= 0)
+    {
+        close(s->fd);
+        s->fd = -1;
+    }
+
+    // 완료된 파일은 저널이 더 이상 필요 없음
+    if (s->journal_fd >= 0)
+    {
+        close(s->journal_fd);
+        s->journal_fd = -1;
+        unlink(s->journalpath);
+    }
+
+    // HTTP(tus) 업로드의 전체 크기 기록도 삭제 (없으면 무시)
+    char lengthpath[520];
+    sprintf(lengthpath, "./%s/.%s.length", s->client_id, s->filename);
+    unlink(lengthpath);
+
+    // 델타 업로드는 재구성이 끝난 임시 파일의 해시를 확인한 뒤 원본을 교체
+    // (다르면 원본을 그대로 두고 임시 파일만 삭제)
+    int verified = s->linked;
+    if (s->delta)
+    {
+        if (s->base_fd >= 0)
+            close(s->base_fd);
+        s->base_fd = -1;
+        if (!verify_hash(s, s->tmppath))
+        {
+            unlink(s->tmppath);
+            s->delta = 0;
+            return -1;
+        }
+        if (rename(s->tmppath, s->filepath) < 0)
+            return -1;
+        s->delta = 0;
+        verified = 1;
+    }
+
+    // 후처리 결과 (남은 버퍼 처리를 기다림, 팩으로 옮기기 전에 파일 경로로 마무리)
+    if (s->pipe)
+    {
+        char result[PIPE_MAX_STAGES * PIPE_RESULT];
+        pipeline_end(s->pipe, s->filepath, result, sizeof(result));
+        s->pipe = NULL;
+        printf("[PIPE ] id=%s file=%s %s\n", s->client_id, s->filename, result);
+    }
+
+    // 같은 이름의 예전 버전이 저온 계층에 있으면 삭제
+    tier_remove(s->client_id, s->filename);
+
+    // 목록에 남길 크기, 수정 시각, 해시 (팩/샤드로 옮기기 전에)
+    // 해시는 받은 내용으로 확인한 것만 (연결한 파일은 대표가 확인한 내용)
+    struct stat st;
+    int have_st = stat(s->filepath, &st) == 0;
+    if (have_st && trim_later >= 0)
+        st.st_size = trim_later;
+    if (!verified && s->sha256[0])
+        verified = verify_hash(s, s->filepath);
+
+    // 작은 파일은 팩 파일에 묶어서 저장하고 개별 파일 삭제, 나머지는 소거 부호 샤드로 나눠 저장 (-E, 백그라운드)
+    int state = CATALOG_FILE;
+    if (pack_finish(s->client_id, s->filename, s->filepath) == 1)
+    {
+        ec_remove(s->client_id, s->filename);
+        state = CATALOG_PACK;
+    }
+
+    filetable_release(s->file);
+    s->file = NULL;
+
+    // 같은 내용의 대표였으면 확인한 해시를 기록하고 기다리던 연결을 깨움
+    // (공유 상태를 놓은 뒤에 해야 기다리던 연결이 하드 링크를 만들 수 있음)
+    if (s->flight)
+    {
+        dedup_done(s->flight, s->filepath, verified);
+        s->flight = NULL;
+    }
+    s->linked = 0;
+
+    if (have_st)
+        catalog_put(s->client_id, s->filename, st.st_size, st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec,
+                    state, verified ? s->sha256 : NULL);
+
+    // 샤드 저장은 COMPLETE를 늦추지 않도록 봉인 스레드에 맡김 (목록 기록 뒤에 해야 상태가 ec로 남음)
+    if (state == CATALOG_FILE)
+        ec_enqueue(s->client_id, s->filename);
+
+    // 피어 복제 큐에 등록 (블로킹하지 않음)
+    if (!s->from_peer)
+        replicate_enqueue(s->client_id, s->filename);
+    return 0;
+}
+
+// FIN 명령 처리 함수 - 업로드 완료 처리 후 COMPLETE 응답
+int handle_FIN(UploadSession *s)
+{
+    if (finish_upload(s) < 0)
+        return -1;
+    send_COMPLETE(s->sd);
+    return 0;
+}
+
+// 명령 한 줄 읽기 (읽은 길이 반환, 아무것도 읽지 못하고 끊기면 -1)
+// 유닉스 소켓은 명령 줄에 붙어 오는 디스크립터를 받기 위해 recvmsg로 읽음
+static int session_read_line(UploadSession *s, char *line, int size)
+{
+    int pos = 0;
+    int read_len;
+    char c;
+
+    while ((read_len = s->local ? recv_with_fd(s->sd, &c, 1, &s->passed_fd) : read(s->sd, &c, 1)) > 0)
+    {
+        // 개행 문자 또는 버퍼 크기 초과 시 중단
+        line[pos++] = c;
+        if (c == '\n' || pos >= size - 1)
+            break;
+    }
+
+    // 연결 종료 또는 오류
+    if (read_len <= 0 && pos == 0)
+        return -1;
 
-// 클라이언트에게 ACK 메시지를 전송하는 함수
-void send_ACK(int sd, long offset)
-{
-    char msg[64];
-    int len = sprintf(msg, "ACK %ld\n", offset);
+    // 문자열 종료 문자 추가
+    line[pos] = '\0';
+    return pos;
+}
 
-    int sent = 0;
-    int write_cnt;
+// HTTP 업로드 이름 검사 (빈 이름, 숨김 파일, 경로 구분자 거부)
+static int http_valid_name(const char *name)
+{
+    return name[0] != '\0' && name[0] != '.' && strchr(name, '/') == NULL;
+}
 
-    // 전체 메시지가 전송될 때까지 반복
-    while (sent < len)
-    {
-        // 부분적으로 메시지 전송 (부분 = write_cnt = 실제로 전송된 바이트 수)
-        write_cnt = write(sd, msg + sent, len - sent);
+// 업로드 URL에서 클라이언트 ID와 파일 이름 추출: /files/<client_id>/<file> (성공 0, 실패 -1)
+static int http_target(const char *path, char *id, char *file)
+{
+    size_t n = strlen(HTTP_PREFIX);
+    if (strncmp(path, HTTP_PREFIX "/", n + 1) != 0)
+        return -1;
+    if (sscanf(path + n + 1, "%63[^/]/%255s", id, file) != 2)
+        return -1;
+    return http_valid_name(id) && http_valid_name(file) ? 0 : -1;
+}
 
-        // 조건: 전송 실패 시 함수 종료
-        if (write_cnt <= 0)
-            return;
+// HTTP 업로드의 전체 크기 (POST에서 ./<id>/.<file>.length 에 기록, 완료되면 삭제)
+// 진행 중인 업로드가 아니면 -1
+static long long http_load_length(const char *id, const char *file)
+{
+    char path[520];
+    sprintf(path, "./%s/.%s.length", id, file);
 
-        // 전송된 바이트 수 누적
-        sent += write_cnt;
-    }
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    long long length = -1;
+    if (fscanf(fp, "%lld", &length) != 1)
+        length = -1;
+    fclose(fp);
+    return length;
 }
 
-// 클라이언트에게 COMPLETE 메시지를 전송하는 함수
-void send_COMPLETE(int sd)
+static int http_save_length(const char *id, const char *file, long long length)
 {
-    const char *msg = "COMPLETE\n";
-    int len = strlen(msg);
-
-    int sent = 0;
-    int write_cnt;
+    char path[520];
+    sprintf(path, "./%s/.%s.length", id, file);
 
-    // 전체 메시지가 전송될 때까지 반복
-    while (sent < len)
-    {
-        write_cnt = write(sd, msg + sent, len - sent);
-        if (write_cnt <= 0)
-            return;
-        sent += write_cnt;
-    }
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+        return -1;
+    fprintf(fp, "%lld\n", length);
+    return fclose(fp) == 0 ? 0 : -1;
 }
 
-// FIRST 명령 처리 함수 - 클라이언트 ID, 파일 이름, 파일 크기를 받아 세션 초기화
-int handle_FIRST(UploadSession *s, char *id, char *file, long filesize)
+// HTTP 요청 대상 업로드를 세션에 연결 (FIRST/RESUME과 같은 공유 수신 구간과 저장 방식 사용)
+static void http_open(UploadSession *s, const char *id, const char *file, long long length)
 {
-    // 세션 정보 설정
+    if (s->file && strcmp(s->client_id, id) == 0 && strcmp(s->filename, file) == 0)
+        return;
+
     strcpy(s->client_id, id);
     strcpy(s->filename, file);
-
-    // 예상 파일 크기 설정
-    s->expected_size = filesize;
-
-    // 클라이언트 ID에 해당하는 디렉토리 생성
+    s->expected_size = length;
     mkdir(id, 0777);
     sprintf(s->filepath, "./%s/%s", id, file);
+    open_upload(s);
+}
 
-    FILE *f = fopen(s->filepath, "rb");
+// GET 으로 읽을 완료된 업로드 (개별 파일/팩/샤드 복원 파일은 fd, 저온 계층은 블록 단위로 풀어서 읽음)
+typedef struct
+{
+    int fd;
+    long long base; // fd 안에서 데이터 시작 위치 (팩)
+    TierFile *cold;
+} HttpBody;
+
+// 완료된 업로드 찾기: 개별 파일, 팩, 소거 부호 샤드, 저온 계층 순서 (없거나 업로드 중이면 -1)
+static int http_body_open(HttpBody *b, const char *id, const char *file, long long *len)
+{
+    char path[520];
+    struct stat st;
+    sprintf(path, "./%s/.%s.journal", id, file);
+    if (access(path, F_OK) == 0)
+        return -1;
 
-    // 기존 파일이 있을 경우 오프셋 계산
-    // 파일이 존재하면 끝으로 이동하여 크기 측정
-    if (f)
+    sprintf(path, "./%s/%s", id, file);
+    b->fd = open(path, O_RDONLY);
+    if (b->fd >= 0 && fstat(b->fd, &st) == 0)
     {
-        fseek(f, 0, SEEK_END);
-        s->stored_offset = ftell(f);
-        fclose(f);
+        *len = st.st_size;
+        return 0;
     }
+    if (b->fd >= 0)
+        close(b->fd);
+    if (pack_lookup(id, file, &b->fd, &b->base, len) == 0 || ec_lookup(id, file, &b->fd, &b->base, len) == 0)
+        return 0;
+    b->fd = -1;
+    b->cold = tier_fopen(id, file);
+    if (!b->cold)
+        return -1;
+    *len = tier_size(b->cold);
+    return 0;
+}
 
-    // 파일이 없으면 오프셋 0으로 설정
-    else
+// [start, start+len) 구간을 소켓으로 전송
+static int http_body_send(HttpBody *b, int sd, long long start, long long len)
+{
+    if (len <= 0)
+        return 0;
+    char *buf = malloc(HTTP_BODY_CHUNK);
+    int ret = buf ? 0 : -1;
+    while (ret == 0 && len > 0)
     {
-        s->stored_offset = 0;
+        size_t n = len < HTTP_BODY_CHUNK ? (size_t)len : HTTP_BODY_CHUNK;
+        if (b->cold)
+            ret = tier_pread(b->cold, buf, n, start);
+        else
+            ret = pread_all(b->fd, buf, n, b->base + start);
+        if (ret == 0)
+            ret = write_all(sd, buf, n);
+        start += n;
+        len -= n;
     }
+    free(buf);
+    return ret;
+}
 
-    // 파일을 이어쓰기 모드로 열기
-    s->fp = fopen(s->filepath, "ab");
-    // 현재 오프셋을 클라이언트에게 전송
-    send_ACK(s->sd, s->stored_offset);
-
-    return 0;
+// 닫기
+static void http_body_close(HttpBody *b)
+{
+    if (b->fd >= 0)
+        close(b->fd);
+    tier_fclose(b->cold);
 }
 
-// RESUME 명령 처리 함수 - 클라이언트 ID와 파일 이름을 받아 세션 복원
-int handle_RESUME(UploadSession *s, char *id, char *file)
+// HTTP 요청 처리 (tus 방식 이어받기 업로드) - 연결을 유지하면 0, 끊어야 하면 -1
+// 요청 줄은 명령 루프에서 이미 읽었고, 나머지 헤더와 PATCH 본문을 여기서 읽음
+static int handle_HTTP(UploadSession *s, const char *request_line)
 {
-    // 세션 정보 설정
-    strcpy(s->client_id, id);
-    strcpy(s->filename, file);
+    long long t0 = trace_now();
+    HttpRequest req;
+    int bad = http_parse_request_line(&req, request_line) < 0;
 
-    sprintf(s->filepath, "./%s/%s", id, file);
+    // 헤더 끝(빈 줄)까지 읽기
+    char line[HTTP_LINE];
+    do
+    {
+        if (session_read_line(s, line, sizeof(line)) < 0)
+            return -1;
+    } while (http_parse_header(&req, line) == 0);
+
+    char id[64] = "", file[256] = "";
+    char headers[1024] = "";
+    int status;
+    long long length = -1;
+    HttpBody body = {-1, 0, NULL};
+    long long body_start = 0, body_len = 0;
 
-    // 기존 파일이 있을 경우 오프셋 계산
-    // 파일이 존재하면 끝으로 이동하여 크기 측정
-    FILE *f = fopen(s->filepath, "rb");
-    if (f)
+    if (bad)
     {
-        fseek(f, 0, SEEK_END);
-        s->stored_offset = ftell(f);
-        fclose(f);
+        status = 400;
+        req.close = 1;
     }
 
-    // 파일이 없으면 오프셋 0으로 설정
-    else
+    // 지원 버전/확장 조회 (브라우저 CORS preflight 응답 겸용)
+    else if (strcmp(req.method, "OPTIONS") == 0)
     {
-        s->stored_offset = 0;
+        status = 204;
+        snprintf(headers, sizeof(headers),
+                 "Tus-Version: " TUS_VERSION "\r\n"
+                 "Tus-Extension: creation\r\n"
+                 "Access-Control-Allow-Methods: POST, HEAD, PATCH, GET, OPTIONS\r\n"
+                 "Access-Control-Allow-Headers: Tus-Resumable, Upload-Length, Upload-Metadata, Upload-Offset, Content-Type\r\n");
     }
 
-    // 파일을 이어쓰기 모드로 열기
-    s->fp = fopen(s->filepath, "ab");
-    // 현재 오프셋을 클라이언트에게 전송
-    send_ACK(s->sd, s->stored_offset);
+    // 업로드 생성: 메타데이터의 clientid(없으면 "web")/filename 으로 FIRST와 같은 경로에 저장
+    else if (strcmp(req.method, "POST") == 0)
+    {
+        if (strcmp(req.path, HTTP_PREFIX) != 0 && strcmp(req.path, HTTP_PREFIX "/") != 0)
+            status = 404;
+        else if (req.upload_length < 0 || http_metadata(&req, "filename", file, sizeof(file)) < 0 ||
+                 !http_valid_name(file))
+            status = 400;
+        else
+        {
+            if (http_metadata(&req, "clientid", id, sizeof(id)) < 0 || !http_valid_name(id))
+                strcpy(id, "web");
+            length = req.upload_length;
 
-    return 0;
-}
+            // 같은 크기로 진행 중인 업로드가 없으면 새 업로드이므로 이전 파일은 지우고 처음부터 받음
+            if (http_load_length(id, file) != length)
+            {
+                char path[520];
+                sprintf(path, "./%s/%s", id, file);
+                unlink(path);
+                sprintf(path, "./%s/.%s.journal", id, file);
+                unlink(path);
+                tier_remove(id, file);
+            }
+            s->client_id[0] = '\0';
+            http_open(s, id, file, length);
+            if (!s->file || http_save_length(id, file, length) < 0)
+                status = 500;
+            else
+            {
+                status = 201;
+                snprintf(headers, sizeof(headers), "Location: " HTTP_PREFIX "/%s/%s\r\nUpload-Offset: %lld\r\n",
+                         id, file, s->stored_offset);
 
-// DATA 명령 처리 함수 - 정해진 크기만큼만 데이터를 수신해서 파일에 저장
-int handle_DATA(UploadSession *s, int chunkSize)
-{
-    // 1. chunkSize 크기만큼 데이터를 소켓에서 읽음
-    char *buf = malloc(chunkSize);
-    if (!buf)
-        return -1;
+                // 빈 파일은 바로 완료
+                if (length == 0 && finish_upload(s) < 0)
+                    status = 500;
+            }
+        }
+    }
 
-    int received = 0;
-    while (received < chunkSize)
+    // 오프셋 조회: 진행 중이면 수신 구간 기준, 완료된 파일이면 파일 크기
+    else if (strcmp(req.method, "HEAD") == 0)
     {
-        int n = read(s->sd, buf + received, chunkSize - received);
-        if (n <= 0)
+        struct stat st;
+        if (http_target(req.path, id, file) < 0)
+            status = 404;
+        else if ((length = http_load_length(id, file)) >= 0)
         {
-            free(buf);
-            return -1;
+            http_open(s, id, file, length);
+            status = s->file ? 200 : 500;
+            snprintf(headers, sizeof(headers), "Upload-Offset: %lld\r\nUpload-Length: %lld\r\nCache-Control: no-store\r\n",
+                     s->stored_offset, length);
+        }
+        else
+        {
+            char path[520];
+            sprintf(path, "./%s/%s", id, file);
+            int pack_fd;
+            long long pack_off;
+            status = 200;
+            if (stat(path, &st) == 0)
+                length = st.st_size;
+            else if (pack_lookup(id, file, &pack_fd, &pack_off, &length) == 0)
+                close(pack_fd);
+            else if (ec_stat(id, file, &length) < 0 && tier_stat(id, file, &length) < 0)
+                status = 404;
+            if (status == 200)
+                snprintf(headers, sizeof(headers), "Upload-Offset: %lld\r\nUpload-Length: %lld\r\nCache-Control: no-store\r\n",
+                         length, length);
+        }
+    }
+
+    // 이어서 저장: Upload-Offset 이 현재 오프셋과 같을 때만 본문을 DATA와 같은 경로로 수신
+    else if (strcmp(req.method, "PATCH") == 0)
+    {
+        if (http_target(req.path, id, file) < 0 || (length = http_load_length(id, file)) < 0)
+            status = 404;
+        else if (!req.octet_stream)
+            status = 415;
+        else if (req.upload_offset < 0 || req.content_length < 0)
+            status = 400;
+        else
+        {
+            http_open(s, id, file, length);
+            if (!s->file)
+                status = 500;
+            else if (req.upload_offset != s->stored_offset)
+                status = 409;
+            else if (req.upload_offset + req.content_length > length)
+                status = 413;
+            else
+            {
+                // 본문은 MAX_CHUNK_SIZE 단위로 나눠서 수신 (중간에 끊기면 받은 만큼은 저장된 상태)
+                for (long long left = req.content_length; left > 0;)
+                {
+                    long long n = left < MAX_CHUNK_SIZE ? left : MAX_CHUNK_SIZE;
+                    if (recv_chunk(s, -1, n) < 0)
+                        return -1;
+                    left -= n;
+                }
+                status = 204;
+                snprintf(headers, sizeof(headers), "Upload-Offset: %lld\r\n", s->stored_offset);
+
+                // 마지막 조각이면 FIN과 같은 완료 처리
+                if (s->stored_offset >= length && finish_upload(s) < 0)
+                    status = 500;
+            }
         }
-        received += n;
+
+        // 읽지 않은 본문이 남아 있으면 연결을 끊음
+        if (status != 204 && req.content_length > 0)
+            req.close = 1;
     }
 
-    // 2. 읽은 데이터를 파일에 저장
-    fwrite(buf, 1, chunkSize, s->fp);
-    fflush(s->fp);
+    // 완료된 업로드 내용 (구간 요청이면 그 구간만)
+    else if (strcmp(req.method, "GET") == 0)
+    {
+        if (http_target(req.path, id, file) < 0 || http_load_length(id, file) >= 0 ||
+            http_body_open(&body, id, file, &length) < 0)
+            status = 404;
+        else if (req.range_start < 0)
+        {
+            status = 200;
+            body_len = length;
+        }
+        else
+        {
+            long long end = req.range_end < 0 || req.range_end >= length ? length - 1 : req.range_end;
+            if (req.range_start > end)
+            {
+                status = 416;
+                snprintf(headers, sizeof(headers), "Content-Range: bytes */%lld\r\n", length);
+            }
+            else
+            {
+                status = 206;
+                body_start = req.range_start;
+                body_len = end - req.range_start + 1;
+                snprintf(headers, sizeof(headers), "Content-Range: bytes %lld-%lld/%lld\r\n", body_start, end, length);
+            }
+        }
+        if (status == 200 || status == 206)
+            strcat(headers, "Content-Type: application/octet-stream\r\nAccept-Ranges: bytes\r\n");
+    }
 
-    // 3. stored_offset 업데이트
-    s->stored_offset += chunkSize;
-    // 4. 업데이트된 stored_offset을 클라이언트에게 ACK로 전송
-    send_ACK(s->sd, s->stored_offset);
+    else
+    {
+        status = 405;
+    }
 
-    // 5. 메모리 free
-    free(buf);
-    return 0;
-}
+    if (req.close)
+        strcat(headers, "Connection: close\r\n");
 
-// FIN 명령 처리 함수 - 업로드 완료 처리
-int handle_FIN(UploadSession *s)
-{
-    fclose(s->fp);
-    send_COMPLETE(s->sd);
-    return 0;
+    // 응답 헤더와 본문을 꽉 찬 세그먼트로 묶어서 전송
+    tune_bulk_begin(s->sd);
+    int sent = http_respond_length(s->sd, status, headers, body_len) == 0 &&
+               http_body_send(&body, s->sd, body_start, body_len) == 0;
+    tune_bulk_end(s->sd);
+    http_body_close(&body);
+    if (!sent)
+        return -1;
+
+    printf("[HTTP ] %s %s -> %d offset=%lld\n", req.method, req.path, status, s->stored_offset);
+    trace_complete("HTTP", t0, "\"method\":\"%s\",\"path\":\"%s\",\"status\":%d,\"offset\":%lld",
+                   trace_str(req.method), trace_str(req.path), status, s->stored_offset);
+    return req.close ? -1 : 0;
 }
 
 // 클라이언트 연결 처리 스레드 함수
 void *handle_client(void *arg)
 {
     // 소켓 디스크립터
-    int sd = *(int *)arg;
+    ClientConn conn = *(ClientConn *)arg;
+    int sd = conn.sd;
     free(arg);
 
+    // 이 연결의 수신 CPU에 고정 (세션 버퍼와 스택을 처음 쓰기 전에 해야 그 노드 메모리에 할당됨)
+    affinity_pin_session(sd);
+
+    // RTT로 소켓 버퍼를 정하고 Nagle 끄기 (ACK 한 줄을 바로 보냄)
+    if (!conn.local)
+        tune_socket(sd, "server");
+
     // 업로드 세션 구조체 초기화
     UploadSession S;
     memset(&S, 0, sizeof(S));
     S.sd = sd;
+    S.local = conn.local;
+    S.passed_fd = -1;
+    S.journal_fd = -1;
+    S.fd = -1;
+    S.base_fd = -1;
+    timer_init(&S.idle, session_idle, &S);
+    session_touch(&S);
 
     // 명령어 수신 버퍼
     char line[512];
-    int read_len;
-    char c;
 
     // 명령어 처리 루프
     while (1)
     {
-        // 한 줄씩 명령어 읽기
-        int pos = 0;
-        while ((read_len = read(sd, &c, 1)) > 0)
-        {
-            // 개행 문자 또는 버퍼 크기 초과 시 중단
-            line[pos++] = c;
-            if (c == '\n' || pos >= (int)sizeof(line) - 1)
-                break;
-        }
-
-        // 연결 종료 또는 오류 시 루프 탈출
-        if (read_len <= 0 && pos == 0)
+        // 한 줄씩 명령어 읽기 (연결 종료 또는 오류 시 루프 탈출)
+        if (session_read_line(&S, line, sizeof(line)) < 0)
             break;
+        session_touch(&S);
 
-        // 문자열 종료 문자 추가
-        line[pos] = '\0';
+        // 트레이스 구간 시작 (꺼져 있으면 0)
+        long long t0 = trace_now();
 
         // 명령어 파싱 및 처리
-        if (strncmp(line, "FIRST", 5) == 0)
+        // 같은 포트로 들어온 HTTP 요청 (브라우저 tus 업로드)
+        if (http_is_request(line))
         {
-            char id[64], file[256];
-            long size;
-            sscanf(line, "FIRST %s %s %ld", id, file, &size);
-            handle_FIRST(&S, id, file, size);
-            printf("[FIRST] id=%s file=%s size=%ld offset=%ld\n",
+            if (handle_HTTP(&S, line) < 0)
+                break;
+        }
+
+        // FIRST 명령 처리
+        else if (strncmp(line, "FIRST", 5) == 0)
+        {
+            char id[64], file[256], opt1[80] = "", opt2[80] = "";
+            long long size = 0;
+            if (sscanf(line, "FIRST %63s %255s %lld %79s %79s", id, file, &size, opt1, opt2) < 2)
+                break;
+            parse_upload_options(&S, opt1, opt2);
+            if (handle_FIRST(&S, id, file, size) < 0)
+                break;
+            printf("[FIRST] id=%s file=%s size=%lld offset=%lld\n",
                    id, file, size, S.stored_offset);
+            trace_complete("FIRST", t0, "\"id\":\"%s\",\"file\":\"%s\",\"size\":%lld,\"offset\":%lld",
+                           trace_str(id), trace_str(file), size, S.stored_offset);
         }
 
         // RESUME 명령 처리
         else if (strncmp(line, "RESUME", 6) == 0)
         {
-            char id[64], file[256];
-            sscanf(line, "RESUME %s %s", id, file);
-            handle_RESUME(&S, id, file);
-            printf("[RESUME] id=%s file=%s offset=%ld\n",
+            char id[64], file[256], opt1[80] = "", opt2[80] = "";
+            long long size = 0;
+            if (sscanf(line, "RESUME %63s %255s %lld %79s %79s", id, file, &size, opt1, opt2) < 2)
+                break;
+            parse_upload_options(&S, opt1, opt2);
+            if (handle_RESUME(&S, id, file, size) < 0)
+                break;
+            printf("[RESUME] id=%s file=%s offset=%lld\n",
                    id, file, S.stored_offset);
+            trace_complete("RESUME", t0, "\"id\":\"%s\",\"file\":\"%s\",\"offset\":%lld",
+                           trace_str(id), trace_str(file), S.stored_offset);
         }
 
         // DATA 명령 처리
         else if (strncmp(line, "DATA", 4) == 0)
         {
-            int chunk;
-            sscanf(line, "DATA %d", &chunk);
-            if (handle_DATA(&S, chunk) < 0)
+            // DATA <len> 또는 DATA <offset> <len>
+            long long a = -1, chunk = -1;
+            int cnt = sscanf(line, "DATA %lld %lld", &a, &chunk);
+            int traced = trace_sample();
+            if (cnt == 2)
+            {
+                if (handle_DATA(&S, a, chunk) < 0)
+                    break;
+                printf("[DATA ] at=%lld chunk=%lld -> offset=%lld\n", a, chunk, S.stored_offset);
+            }
+            else
+            {
+                chunk = a;
+                a = -1;
+                if (handle_DATA(&S, -1, chunk) < 0)
+                    break;
+                printf("[DATA ] chunk=%lld -> offset=%lld\n", chunk, S.stored_offset);
+            }
+            if (traced)
+                trace_complete("DATA", t0, "\"at\":%lld,\"len\":%lld,\"offset\":%lld",
+                               a, chunk, S.stored_offset);
+        }
+
+        // ZDATA 명령 처리 - 압축된 청크
+        else if (strncmp(line, "ZDATA", 5) == 0)
+        {
+            long long chunk = -1, zlen = -1;
+            sscanf(line, "ZDATA %lld %lld", &chunk, &zlen);
+            int traced = trace_sample();
+            if (handle_ZDATA(&S, chunk, zlen) < 0)
+                break;
+            printf("[ZDATA] chunk=%lld z=%lld -> offset=%lld\n", chunk, zlen, S.stored_offset);
+            if (traced)
+                trace_complete("ZDATA", t0, "\"len\":%lld,\"zlen\":%lld,\"offset\":%lld",
+                               chunk, zlen, S.stored_offset);
+        }
+
+        // HOLES 명령 처리
+        else if (strncmp(line, "HOLES", 5) == 0)
+        {
+            if (handle_HOLES(&S) < 0)
+                break;
+        }
+
+        // LIST 명령 처리 - LIST <id> [limit] [prefix=<p>] [after=<name>]
+        else if (strncmp(line, "LIST", 4) == 0)
+        {
+            // 인자는 순서와 상관없이 받음 (숫자면 limit, 없으면 기본값)
+            char *save = NULL, *tok = strtok_r(line + 4, " \r\n", &save);
+            const char *id = tok, *prefix = "", *after = "";
+            int limit = 0;
+            if (!id || strlen(id) >= sizeof(S.client_id))
+                break;
+            while ((tok = strtok_r(NULL, " \r\n", &save)) != NULL)
+            {
+                if (strncmp(tok, "prefix=", 7) == 0)
+                    prefix = tok + 7;
+                else if (strncmp(tok, "after=", 6) == 0)
+                    after = tok + 6;
+                else
+                {
+                    char *end;
+                    long n = strtol(tok, &end, 10);
+                    if (*end == '\0')
+                        limit = n > CATALOG_LIST_MAX ? CATALOG_LIST_MAX : n < 0 ? 0 : (int)n;
+                }
+            }
+            struct timespec a, b;
+            clock_gettime(CLOCK_MONOTONIC, &a);
+            if (handle_LIST(&S, id, limit, prefix, after) < 0)
+                break;
+            clock_gettime(CLOCK_MONOTONIC, &b);
+            printf("[LIST ] id=%s prefix=%s after=%s (%.3f ms)\n", id, prefix, after,
+                   (b.tv_sec - a.tv_sec) * 1e3 + (b.tv_nsec - a.tv_nsec) / 1e6);
+            trace_complete("LIST", t0, "\"id\":\"%s\",\"prefix\":\"%s\"", trace_str(id), trace_str(prefix));
+        }
+
+        // DELTA 명령 처리
+        else if (strncmp(line, "DELTA", 5) == 0)
+        {
+            char id[64], file[256], opt[80] = "";
+            long long size = 0;
+            if (sscanf(line, "DELTA %63s %255s %lld %79s", id, file, &size, opt) < 3)
+                break;
+            parse_upload_options(&S, opt, "");
+            if (handle_DELTA(&S, id, file, size) < 0)
+                break;
+            printf("[DELTA] id=%s file=%s size=%lld blocks=%lld x %u\n",
+                   id, file, size, S.block_count, S.block_size);
+            trace_complete("DELTA", t0, "\"id\":\"%s\",\"file\":\"%s\",\"blocks\":%lld",
+                           trace_str(id), trace_str(file), S.block_count);
+        }
+
+        // COPY 명령 처리
+        else if (strncmp(line, "COPY", 4) == 0)
+        {
+            long long block = -1, count = 0;
+            sscanf(line, "COPY %lld %lld", &block, &count);
+            if (handle_COPY(&S, block, count) < 0)
+                break;
+            printf("[COPY ] blocks=%lld+%lld -> offset=%lld\n", block, count, S.stored_offset);
+        }
+
+        // FILEFD 명령 처리 - 같은 호스트 클라이언트가 넘긴 원본 파일에서 직접 복사
+        else if (strncmp(line, "FILEFD", 6) == 0)
+        {
+            long long size = -1;
+            sscanf(line, "FILEFD %lld", &size);
+            long long from = S.stored_offset;
+            if (handle_FILEFD(&S, size) < 0)
                 break;
-            printf("[DATA ] chunk=%d -> offset=%ld\n", chunk, S.stored_offset);
+            printf("[LOCAL] copied=%lld -> offset=%lld\n", size - from, S.stored_offset);
+            trace_complete("FILEFD", t0, "\"from\":%lld,\"offset\":%lld", from, S.stored_offset);
+        }
+
+        // REPL 명령 처리 - 피어 서버의 복제 연결 표시
+        else if (strncmp(line, "REPL", 4) == 0)
+        {
+            S.from_peer = 1;
         }
 
         // FIN 명령 처리
         else if (strncmp(line, "FIN", 3) == 0)
         {
-            handle_FIN(&S);
-            printf("[FIN  ] completed id=%s file=%s size=%ld\n",
+            if (handle_FIN(&S) < 0)
+                break;
+            printf("[FIN  ] completed id=%s file=%s size=%lld\n",
                    S.client_id, S.filename, S.stored_offset);
+            trace_complete("FIN", t0, "\"id\":\"%s\",\"file\":\"%s\",\"size\":%lld",
+                           trace_str(S.client_id), trace_str(S.filename), S.stored_offset);
             break;
         }
     }
+
+    // 타이머가 소켓을 건드리지 않도록 먼저 해제
+    timer_cancel(&S.idle);
+    if (S.timed_out)
+    {
+        printf("[IDLE ] id=%s file=%s no activity for %ds, released offset=%lld\n",
+               S.client_id, S.filename, idle_timeout, S.stored_offset);
+        trace_instant("IDLE", "\"id\":\"%s\",\"file\":\"%s\",\"offset\":%lld",
+                      trace_str(S.client_id), trace_str(S.filename), S.stored_offset);
+    }
+
+    // 비정상 종료 시 열린 파일 정리
+    if (S.passed_fd >= 0)
+        close(S.passed_fd);
+    session_release(&S);
     close(sd);
     return NULL;
 }
 
+// 연결마다 세션 스레드 생성 (local: 유닉스 도메인 소켓 연결)
+static void spawn_client(int clnt_sd, int local)
+{
+    ClientConn *conn = malloc(sizeof(ClientConn));
+    if (!conn)
+    {
+        close(clnt_sd);
+        return;
+    }
+    conn->sd = clnt_sd;
+    conn->local = local;
+
+    // 스레드 생성 및 분리
+    pthread_t t;
+    pthread_create(&t, NULL, handle_client, conn);
+    pthread_detach(t);
+}
+
+// 유닉스 도메인 소켓 연결 수락 스레드 (TCP와 같은 세션 처리 사용)
+static void *unix_accept_loop(void *arg)
+{
+    int unix_sd = *(int *)arg;
+    free(arg);
+
+    while (1)
+    {
+        int clnt_sd = accept(unix_sd, NULL, NULL);
+        if (clnt_sd < 0)
+        {
+            perror("accept");
+            continue;
+        }
+        spawn_client(clnt_sd, 1);
+        printf("Connected: %s (local)\n", unix_path);
+    }
+    return NULL;
+}
+
 // 메인 함수 - 서버 소켓 설정 및 클라이언트 연결 대기
 int main(int argc, char *argv[])
 {
+    // 옵션 처리
+    int opt;
+    while ((opt = getopt(argc, argv, "r:w:i:t:S:T:u:k:P:E:C:HA:B:L")) != -1)
+    {
+        switch (opt)
+        {
+        case 'w':
+            if (strcmp(optarg, "mmap") == 0)
+                write_mode = WRITE_MMAP;
+            else if (strcmp(optarg, "pwrite") == 0)
+                write_mode = WRITE_PWRITE;
+            else if (strcmp(optarg, "fsync") == 0)
+                write_mode = WRITE_FSYNC;
+            else
+                argc = 0;
+            break;
+        case 'i':
+            idle_timeout = atoi(optarg);
+            break;
+        case 't':
+            partial_ttl = atoi(optarg);
+            break;
+        case 'S':
+            stats_port = atoi(optarg);
+            break;
+        case 'T':
+            if (trace_open(optarg, "server") < 0)
+            {
+                perror(optarg);
+                exit(1);
+            }
+            break;
+        case 'u':
+            unix_path = optarg;
+            break;
+        case 'P':
+            pipe_stages = optarg;
+            break;
+        case 'E':
+            ec_spec = optarg;
+            break;
+        case 'C':
+            tier_spec = optarg;
+            break;
+        case 'H':
+            dedup_enabled = 1;
+            break;
+        case 'L':
+            catalog_rebuild = 1;
+            break;
+        case 'A':
+            affinity_spec = optarg;
+            break;
+        case 'B':
+            tune_set_rate(atoll(optarg));
+            break;
+        case 'k':
+            pack_threshold = atoll(optarg);
+            if (pack_threshold < 0 || pack_threshold > PACK_MAX_THRESHOLD)
+                argc = 0;
+            break;
+        case 'r':
+            if (replicate_add_peer(optarg) < 0)
+            {
+                printf("잘못된 피어 주소: %s\n", optarg);
+                exit(1);
+            }
+            break;
+        default:
+            argc = 0;
+            break;
+        }
+    }
+
     // 포트 번호
-    if (argc != 2)
+    if (argc - optind != 1)
     {
-        printf("Usage: %s <port>\n", argv[0]);
+        printf("Usage: %s [-r peer_ip:port]... [-w pwrite|mmap|fsync] [-i idle_sec] [-t ttl_sec] [-S stats_port] [-T trace.json] [-u socket_path] [-k pack_bytes] [-P stage,...] [-E k+m:dir,...] [-C cold_dir[,age=sec][,min=bytes][,rate=bytes]] [-H] [-A irq:iface|node:n|cpus] [-B bytes_per_sec] [-L] <port>\n", argv[0]);
+        printf("  -r  완료된 업로드를 비동기로 복제할 피어 서버 (여러 번 지정 가능)\n");
+        printf("  -w  수신 데이터 저장 방식 (기본 pwrite, mmap: 미리 할당한 파일 매핑에 직접 수신, fsync: pwrite 후 청크마다 fdatasync)\n");
+        printf("  -i  유휴 연결을 끊는 시간 (초, 기본 300, 0: 사용 안 함)\n");
+        printf("  -t  미완료 업로드를 삭제하는 시간 (초, 기본 86400, 0: 삭제 안 함)\n");
+        printf("  -S  DATA 구간별 지연(p50/p99/p999)을 조회하는 로컬 포트 (make STATS=1 빌드)\n");
+        printf("  -T  명령별 타임라인을 Chrome/Perfetto 트레이스(JSON)로 기록\n");
+        printf("  -u  같은 호스트 클라이언트용 유닉스 도메인 소켓 (파일 디스크립터를 받아 직접 복사)\n");
+        printf("  -k  이 크기 이하로 완료된 업로드는 %s 의 팩 파일에 묶음 저장 (bytes, 최대 %d)\n", PACK_DIR, PACK_MAX_THRESHOLD);
+        printf("  -P  수신 중에 실행할 후처리 단계 (crc32, sniff), 결과는 FIN 때 출력\n");
+        printf("  -E  완료된 업로드를 디렉토리 k+m개에 리드-솔로몬 샤드로 나눠 저장 (디렉토리 m개까지 없어도 복원)\n");
+        printf("  -C  age초 동안 바뀌지 않은 min바이트 이상의 완료 업로드를 cold_dir 로 압축해서 옮김 (초당 rate바이트씩)\n");
+        printf("  -H  sha256이 같은 업로드를 합침 (완료된 것은 하드 링크, 받는 중이면 끝날 때까지 진행 상황을 보내며 기다림)\n");
+        printf("  -A  연결 스레드를 소켓의 수신 CPU에 고정하고 그 NUMA 노드 메모리를 사용 (irq:NIC 수신 큐 인터럽트 CPU, node:노드, CPU 목록)\n");
+        printf("  -B  소켓 버퍼를 정할 목표 대역폭 (bytes/s, 기본 %lld: 버퍼 = 대역폭 x 접속 때 잰 RTT)\n", TUNE_DEFAULT_RATE);
+        printf("  -L  시작할 때 업로드 목록(%s)을 디스크에서 다시 만듦 (없거나 깨졌으면 항상)\n", CATALOG_DIR);
         exit(1);
     }
+    char *port = argv[optind];
+
+    // 클라이언트가 끊긴 뒤 ACK를 쓰다가 서버 전체가 SIGPIPE로 종료되지 않도록 무시
+    signal(SIGPIPE, SIG_IGN);
 
     // 서버 소켓 생성
     int serv_sd = socket(PF_INET, SOCK_STREAM, 0);
@@ -281,13 +1805,20 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
+#ifdef TCP_FASTOPEN
+    // TCP Fast Open 허용: 다시 접속하는 클라이언트의 첫 명령(RESUME)을 SYN과 함께 받음
+    // (커널 설정 net.ipv4.tcp_fastopen 에 서버 비트(2)가 있어야 동작, 지원하지 않으면 일반 접속)
+    int tfo_queue = 64;
+    setsockopt(serv_sd, IPPROTO_TCP, TCP_FASTOPEN, &tfo_queue, sizeof(tfo_queue));
+#endif
+
     // 서버 주소 구조체 설정
     struct sockaddr_in serv, clnt;
     memset(&serv, 0, sizeof(serv));
 
     serv.sin_family = AF_INET;
     serv.sin_addr.s_addr = htonl(INADDR_ANY);
-    serv.sin_port = htons(atoi(argv[1]));
+    serv.sin_port = htons(atoi(port));
 
     // 바인드 / 리슨
     if (bind(serv_sd, (struct sockaddr *)&serv, sizeof(serv)) < 0)
@@ -295,13 +1826,88 @@ int main(int argc, char *argv[])
         perror("bind");
         exit(1);
     }
-    if (listen(serv_sd, 10) < 0)
+    if (listen(serv_sd, SOMAXCONN) < 0)
     {
         perror("listen");
         exit(1);
     }
 
-    printf("Server start port: %s\n", argv[1]);
+    printf("Server start port: %s\n", port);
+
+    // 같은 호스트 클라이언트용 유닉스 도메인 소켓 (별도 스레드에서 수락)
+    if (unix_path)
+    {
+        int *unix_sd = malloc(sizeof(int));
+        if (!unix_sd || (*unix_sd = unix_listen(unix_path)) < 0)
+        {
+            perror(unix_path);
+            exit(1);
+        }
+        pthread_t t;
+        pthread_create(&t, NULL, unix_accept_loop, unix_sd);
+        pthread_detach(t);
+        printf("Server local socket: %s\n", unix_path);
+    }
+
+    // 작은 파일 묶음 저장 (인덱스가 없으면 팩 파일에서 다시 만듦)
+    if (pack_open(pack_threshold) < 0)
+    {
+        perror(PACK_DIR);
+        exit(1);
+    }
+
+    // 세션/후처리 스레드를 고정할 CPU (후처리 작업 스레드를 시작하기 전에)
+    if (affinity_spec && affinity_open(affinity_spec) < 0)
+    {
+        printf("잘못된 CPU 고정 설정: %s (예: irq:eth0, node:0, 0-3)\n", affinity_spec);
+        exit(1);
+    }
+
+    // 소거 부호 저장 디렉토리
+    if (ec_spec && ec_open(ec_spec) < 0)
+    {
+        printf("잘못된 소거 부호 설정: %s (예: 4+2:d0,d1,d2,d3,d4,d5)\n", ec_spec);
+        exit(1);
+    }
+
+    // 저온 계층 디렉토리
+    if (tier_spec && tier_open(tier_spec) < 0)
+    {
+        printf("잘못된 저온 계층 설정: %s\n", tier_spec);
+        exit(1);
+    }
+    if (dedup_enabled && dedup_open() < 0)
+    {
+        perror(DEDUP_DIR);
+        exit(1);
+    }
+
+    // 완료된 업로드 목록 (LIST, 팩/샤드/저온 계층을 연 뒤에 - 다시 만들 때 모두 훑음)
+    if (catalog_open(catalog_rebuild) < 0)
+    {
+        perror(CATALOG_DIR);
+        exit(1);
+    }
+
+    // 후처리 파이프라인 작업 스레드 시작
+    if (pipe_stages && pipeline_start(pipe_stages) < 0)
+    {
+        printf("잘못된 후처리 단계: %s\n", pipe_stages);
+        exit(1);
+    }
+
+    // 피어 복제 스레드 시작
+    replicate_start();
+
+    // 유휴 세션 타이머와 미완료 업로드 정리 스레드 시작
+    timer_start();
+    gc_start(partial_ttl);
+
+    // 오래된 완료 업로드를 저온 계층으로 옮기는 스레드 시작 (-C)
+    tier_start();
+
+    // 구간별 지연 통계 출력 (계측을 끄고 빌드하면 아무것도 하지 않음)
+    stats_start(stats_port);
 
     // 클라이언트 연결 대기 및 처리
     while (1)
@@ -319,18 +1925,7 @@ int main(int argc, char *argv[])
         }
 
         // 클라이언트 처리 스레드 생성
-        int *pclient = malloc(sizeof(int));
-        if (!pclient)
-        {
-            close(clnt_sd);
-            continue;
-        }
-        *pclient = clnt_sd;
-
-        // 스레드 생성 및 분리
-        pthread_t t;
-        pthread_create(&t, NULL, handle_client, pclient);
-        pthread_detach(t);
+        spawn_client(clnt_sd, 0);
 
         // 연결된 클라이언트 정보 출력
         printf("Connected: %s\n", inet_ntoa(clnt.sin_addr));
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "sha256.h"
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+// 64바이트 블록 하나 처리
+static void sha256_block(Sha256 *c, const unsigned char *p)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 |
+               (uint32_t)p[i * 4 + 2] << 8 | (uint32_t)p[i * 4 + 3];
+    for (int i = 16; i < 64; i++)
+    {
+        uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = c->h[0], b = c->h[1], cc = c->h[2], d = c->h[3];
+    uint32_t e = c->h[4], f = c->h[5], g = c->h[6], h = c->h[7];
+    for (int i = 0; i < 64; i++)
+    {
+        uint32_t t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + ((a & b) ^ (a & cc) ^ (b & cc));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = cc;
+        cc = b;
+        b = a;
+        a = t1 + t2;
+    }
+    c->h[0] += a;
+    c->h[1] += b;
+    c->h[2] += cc;
+    c->h[3] += d;
+    c->h[4] += e;
+    c->h[5] += f;
+    c->h[6] += g;
+    c->h[7] += h;
+}
+
+// 초기값 설정
+void sha256_init(Sha256 *c)
+{
+    static const uint32_t H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                   0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(c->h, H0, sizeof(H0));
+    c->len = 0;
+    c->fill = 0;
+}
+
+// 데이터 추가 (남은 조각은 block에 모아 두었다가 64바이트가 차면 처리)
+void sha256_update(Sha256 *c, const void *buf, size_t len)
+{
+    const unsigned char *p = buf;
+    c->len += len;
+
+    if (c->fill > 0)
+    {
+        size_t n = 64 - c->fill < len ? 64 - c->fill : len;
+        memcpy(c->block + c->fill, p, n);
+        c->fill += n;
+        p += n;
+        len -= n;
+        if (c->fill < 64)
+            return;
+        sha256_block(c, c->block);
+        c->fill = 0;
+    }
+    for (; len >= 64; p += 64, len -= 64)
+        sha256_block(c, p);
+    memcpy(c->block, p, len);
+    c->fill = len;
+}
+
+// 0x80, 0 채움, 비트 길이(빅 엔디언 64비트)로 마지막 블록을 만든 뒤 hex로 출력
+void sha256_final_hex(Sha256 *c, char hex[SHA256_HEX + 1])
+{
+    uint64_t bits = c->len * 8;
+    c->block[c->fill++] = 0x80;
+    if (c->fill > 56)
+    {
+        memset(c->block + c->fill, 0, 64 - c->fill);
+        sha256_block(c, c->block);
+        c->fill = 0;
+    }
+    memset(c->block + c->fill, 0, 56 - c->fill);
+    for (int i = 0; i < 8; i++)
+        c->block[56 + i] = (unsigned char)(bits >> (56 - i * 8));
+    sha256_block(c, c->block);
+
+    for (int i = 0; i < 8; i++)
+        sprintf(hex + i * 8, "%08x", c->h[i]);
+}
+
+// 16진수 64자인지 검사
+int sha256_valid_hex(const char *hex)
+{
+    for (int i = 0; i < SHA256_HEX; i++)
+        if (!((hex[i] >= '0' && hex[i] <= '9') || (hex[i] >= 'a' && hex[i] <= 'f')))
+            return 0;
+    return hex[SHA256_HEX] == '\0';
+}
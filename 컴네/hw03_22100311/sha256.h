@@ -0,0 +1,31 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 파일 전체 내용 해시 (FIPS 180-4 SHA-256) - 같은 내용의 업로드를 알아보는 데 사용
+#define SHA256_LEN 32
+#define SHA256_HEX (SHA256_LEN * 2)
+
+// FIRST/RESUME 에 붙이는 해시 토큰 머리 ("sha256=<16진수 64자>")
+#define SHA256_TOKEN "sha256="
+
+typedef struct
+{
+    uint32_t h[8];
+    uint64_t len;              // 지금까지 넣은 바이트 수
+    unsigned char block[64];   // 64바이트가 안 찬 나머지
+    size_t fill;
+} Sha256;
+
+void sha256_init(Sha256 *c);
+void sha256_update(Sha256 *c, const void *buf, size_t len);
+
+// 마지막 블록을 채워 해시를 hex(소문자 64자 + '\0')로 기록
+void sha256_final_hex(Sha256 *c, char hex[SHA256_HEX + 1]);
+
+// 16진수 64자로 된 해시 문자열인지 (맞으면 1)
+int sha256_valid_hex(const char *hex);
+
+#endif
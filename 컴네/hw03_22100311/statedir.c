@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "netio.h"
+#include "delta.h"
+#include "statedir.h"
+
+// 상태 파일 경로: id와 파일 이름의 64비트 FNV-1a 해시 (파일 이름에 '/'가 있어도 평평하게 저장)
+static void state_path(const char *dir, const char *client_id, const char *filename, char *path, size_t size)
+{
+    char key[330];
+    int len = snprintf(key, sizeof(key), "%s/%s", client_id, filename);
+    uint64_t h = delta_strong((const unsigned char *)key, len);
+    snprintf(path, size, "%s/%016llx.state", dir, (unsigned long long)h);
+}
+
+// 새 상태 생성
+void state_init(UploadState *st, const char *client_id, const char *filename,
+                const char *source, const struct stat *sb)
+{
+    memset(st, 0, sizeof(*st));
+    snprintf(st->client_id, sizeof(st->client_id), "%s", client_id);
+    snprintf(st->filename, sizeof(st->filename), "%s", filename);
+    snprintf(st->source, sizeof(st->source), "%s", source);
+    state_set_source(st, sb);
+}
+
+// 원본 정보 갱신
+void state_set_source(UploadState *st, const struct stat *sb)
+{
+    st->size = sb->st_size;
+    st->mtime_ns = sb->st_mtim.tv_sec * 1000000000LL + sb->st_mtim.tv_nsec;
+    st->ino = sb->st_ino;
+}
+
+// 원본이 바뀌었는지
+int state_changed(const UploadState *st, const struct stat *sb)
+{
+    return st->size != sb->st_size ||
+           st->mtime_ns != sb->st_mtim.tv_sec * 1000000000LL + sb->st_mtim.tv_nsec ||
+           st->ino != (long long)sb->st_ino;
+}
+
+// 해시 하나 추가
+static int push_sum(UploadState *st, uint64_t h)
+{
+    if (st->nsums == st->cap)
+    {
+        long long cap = st->cap ? st->cap * 2 : 64;
+        uint64_t *p = realloc(st->sums, sizeof(uint64_t) * cap);
+        if (!p)
+            return -1;
+        st->sums = p;
+        st->cap = cap;
+    }
+    st->sums[st->nsums++] = h;
+    return 0;
+}
+
+// "<key> <값>" 한 줄을 읽어 key 뒤 공백 하나 다음부터 줄 끝까지를 값으로 복사 (공백이 들어간 이름도 그대로, 성공 1)
+static int read_field(FILE *fp, const char *key, char *out, size_t size)
+{
+    char line[600];
+    size_t klen = strlen(key);
+    if (!fgets(line, sizeof(line), fp) || strncmp(line, key, klen) != 0 || line[klen] != ' ')
+        return 0;
+    line[strcspn(line, "\n")] = '\0';
+    size_t len = strlen(line + klen + 1);
+    if (len >= size)
+        return 0;
+    memcpy(out, line + klen + 1, len + 1);
+    return 1;
+}
+
+// 상태 파일 읽기
+static int load_file(const char *path, UploadState *st)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+
+    memset(st, 0, sizeof(*st));
+    long long nsums = 0;
+    int ok = fscanf(fp, "id %63s", st->client_id) == 1 && fgetc(fp) == '\n' &&
+             read_field(fp, "file", st->filename, sizeof(st->filename)) &&
+             read_field(fp, "source", st->source, sizeof(st->source)) &&
+             fscanf(fp, "size %lld\n", &st->size) == 1 &&
+             fscanf(fp, "mtime %lld\n", &st->mtime_ns) == 1 &&
+             fscanf(fp, "ino %lld\n", &st->ino) == 1 &&
+             fscanf(fp, "offset %lld\n", &st->offset) == 1 &&
+             fscanf(fp, "done %d\n", &st->done) == 1;
+
+    // 파일 해시는 알 때만 기록 (예전 상태 파일에는 없음)
+    if (ok && fscanf(fp, "sha256 %64s\n", st->sha256) == 1 && !sha256_valid_hex(st->sha256))
+        st->sha256[0] = '\0';
+    ok = ok && fscanf(fp, "blocks %lld\n", &nsums) == 1;
+
+    // 해시가 중간에 끊겼으면 읽은 만큼만 사용 (앞쪽 블록은 그대로 유효)
+    unsigned long long h;
+    for (long long i = 0; ok && i < nsums && fscanf(fp, "%llx\n", &h) == 1; i++)
+        ok = push_sum(st, h) == 0;
+    fclose(fp);
+
+    if (!ok)
+        state_free(st);
+    return ok ? 0 : -1;
+}
+
+// 상태 파일 읽기 (다른 업로드와 해시가 겹친 파일은 무시)
+int state_load(const char *dir, const char *client_id, const char *filename, UploadState *st)
+{
+    char path[600];
+    state_path(dir, client_id, filename, path, sizeof(path));
+    if (load_file(path, st) < 0)
+        return -1;
+    if (strcmp(st->client_id, client_id) != 0 || strcmp(st->filename, filename) != 0)
+    {
+        state_free(st);
+        return -1;
+    }
+    return 0;
+}
+
+// 상태 파일 저장 (쓰는 도중에 죽어도 이전 상태가 남도록 임시 파일에 쓴 뒤 rename)
+int state_save(const char *dir, const UploadState *st)
+{
+    char path[600], tmp[610];
+    state_path(dir, st->client_id, st->filename, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE *fp = fopen(tmp, "w");
+    if (!fp)
+        return -1;
+    fprintf(fp, "id %s\nfile %s\nsource %s\n", st->client_id, st->filename, st->source);
+    fprintf(fp, "size %lld\nmtime %lld\nino %lld\n", st->size, st->mtime_ns, st->ino);
+    fprintf(fp, "offset %lld\ndone %d\n", st->offset, st->done);
+    if (st->sha256[0])
+        fprintf(fp, "sha256 %s\n", st->sha256);
+    fprintf(fp, "blocks %lld\n", st->nsums);
+    for (long long i = 0; i < st->nsums; i++)
+        fprintf(fp, "%016llx\n", (unsigned long long)st->sums[i]);
+    if (fclose(fp) != 0)
+    {
+        unlink(tmp);
+        return -1;
+    }
+    return rename(tmp, path);
+}
+
+// 아직 해시하지 않은 블록 중 upto 안에 끝나는 블록 해시 추가
+int state_hash_blocks(UploadState *st, int fd, long long upto)
+{
+    if ((st->nsums + 1) * STATE_BLOCK > upto)
+        return 0;
+
+    unsigned char *buf = malloc(STATE_BLOCK);
+    if (!buf)
+        return -1;
+    int ret = 0;
+    while ((st->nsums + 1) * STATE_BLOCK <= upto)
+    {
+        if (pread_all(fd, buf, STATE_BLOCK, st->nsums * STATE_BLOCK) < 0 ||
+            push_sum(st, delta_strong(buf, STATE_BLOCK)) < 0)
+        {
+            ret = -1;
+            break;
+        }
+    }
+    free(buf);
+    return ret;
+}
+
+// client_id의 끝나지 않은 업로드 이름 목록
+int state_list(const char *dir, const char *client_id, char (*names)[256], int max)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return 0;
+
+    int cnt = 0;
+    struct dirent *e;
+    while (cnt < max && (e = readdir(d)) != NULL)
+    {
+        size_t len = strlen(e->d_name);
+        if (len < 6 || strcmp(e->d_name + len - 6, ".state") != 0)
+            continue;
+
+        char path[600];
+        UploadState st;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (load_file(path, &st) < 0)
+            continue;
+        if (!st.done && strcmp(st.client_id, client_id) == 0)
+            snprintf(names[cnt++], 256, "%s", st.filename);
+        state_free(&st);
+    }
+    closedir(d);
+    return cnt;
+}
+
+// 해시 목록 해제
+void state_free(UploadState *st)
+{
+    free(st->sums);
+    st->sums = NULL;
+    st->nsums = st->cap = 0;
+}
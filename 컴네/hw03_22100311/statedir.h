@@ -0,0 +1,66 @@
+#ifndef STATEDIR_H
+#define STATEDIR_H
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+#include "sha256.h"
+
+// 클라이언트 상태 디렉토리: 대기열의 업로드마다 상태 파일 하나 (-s)
+//   <dir>/<id와 파일 이름의 해시>.state  원본 경로, 크기/mtime/inode, 서버 오프셋, 파일 sha256, 블록별 해시
+// 클라이언트가 죽었다가 다시 실행되면 남은 업로드를 바로 이어 보내고,
+// 원본이 바뀌었으면 (크기/mtime/inode) 이미 보낸 블록의 해시를 비교해서 바뀐 블록만 다시 보냄
+
+// 해시를 기록하는 블록 크기
+#define STATE_BLOCK (1024 * 1024)
+
+typedef struct
+{
+    char client_id[64];
+    char filename[256]; // 서버에 저장되는 이름
+    char source[512];   // 원본 파일 절대 경로
+
+    // 원본 식별 정보 (바뀌었는지 판단)
+    long long size;
+    long long mtime_ns;
+    long long ino;
+
+    long long offset; // 마지막으로 기록한 서버 ACK 오프셋
+    int done;         // FIN까지 끝남
+
+    // 원본 전체의 sha256 (-H / 델타 확인용, 모르면 빈 문자열)
+    // 원본 정보가 그대로일 때만 유효하므로 다시 실행해도 파일을 다시 읽지 않음
+    char sha256[SHA256_HEX + 1];
+
+    // 블록 i = [i * STATE_BLOCK, (i + 1) * STATE_BLOCK) 의 해시, 앞에서부터 nsums개
+    long long nsums;
+    long long cap;
+    uint64_t *sums;
+} UploadState;
+
+// 새 상태 생성 (원본 정보는 sb, 해시 없음)
+void state_init(UploadState *st, const char *client_id, const char *filename,
+                const char *source, const struct stat *sb);
+
+// 상태 파일 읽기 (없거나 깨졌으면 -1)
+int state_load(const char *dir, const char *client_id, const char *filename, UploadState *st);
+
+// 상태 파일 저장 (임시 파일에 쓴 뒤 rename, 성공 0)
+int state_save(const char *dir, const UploadState *st);
+
+// 원본이 기록한 뒤로 바뀌었는지 (크기, mtime, inode 비교)
+int state_changed(const UploadState *st, const struct stat *sb);
+
+// 원본 정보를 sb로 갱신
+void state_set_source(UploadState *st, const struct stat *sb);
+
+// fd에서 아직 해시하지 않은 블록 중 upto 안에 끝나는 블록을 읽어서 해시 추가 (성공 0)
+int state_hash_blocks(UploadState *st, int fd, long long upto);
+
+// 디렉토리에서 client_id의 끝나지 않은 업로드 이름을 names에 최대 max개 저장 (개수 반환)
+int state_list(const char *dir, const char *client_id, char (*names)[256], int max);
+
+// 해시 목록 해제
+void state_free(UploadState *st);
+
+#endif
@@ -0,0 +1,246 @@
+#include "stats.h"
+
+#ifdef UPLOAD_STATS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+#include "netio.h"
+
+// 스레드 하나가 쓰는 히스토그램 (소유 스레드만 쓰고, 출력 시 다른 스레드가 읽음)
+typedef struct StatsHist
+{
+    uint64_t count[STATS_PHASES][STATS_BUCKETS];
+    uint64_t max[STATS_PHASES];
+    int in_use;
+    struct StatsHist *next;
+} StatsHist;
+
+static const char *phase_names[STATS_PHASES] = {
+    "recv", "write", "mmap", "journal", "ack", "chunk"};
+
+// 등록된 히스토그램 목록 (끝난 스레드의 것은 다음 스레드가 재사용하므로 누적값 유지)
+static StatsHist *hists = NULL;
+static pthread_mutex_t hists_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t hist_key;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static __thread StatsHist *mine = NULL;
+
+// 스레드 종료 시 히스토그램을 반납
+static void hist_release(void *arg)
+{
+    StatsHist *h = arg;
+    pthread_mutex_lock(&hists_lock);
+    h->in_use = 0;
+    pthread_mutex_unlock(&hists_lock);
+}
+
+static void key_init(void)
+{
+    pthread_key_create(&hist_key, hist_release);
+}
+
+// 현재 스레드의 히스토그램 (처음 기록할 때 반납된 것을 재사용하거나 새로 할당)
+static StatsHist *hist_get(void)
+{
+    if (mine)
+        return mine;
+
+    pthread_once(&key_once, key_init);
+    pthread_mutex_lock(&hists_lock);
+    StatsHist *h;
+    for (h = hists; h; h = h->next)
+    {
+        if (!h->in_use)
+            break;
+    }
+    if (!h)
+    {
+        h = calloc(1, sizeof(*h));
+        if (h)
+        {
+            h->next = hists;
+            hists = h;
+        }
+    }
+    if (h)
+        h->in_use = 1;
+    pthread_mutex_unlock(&hists_lock);
+
+    if (h)
+        pthread_setspecific(hist_key, h);
+    mine = h;
+    return h;
+}
+
+// 값 -> 칸 번호 (16 미만은 그대로, 그 이상은 최상위 비트 위치와 다음 4비트)
+static int bucket_of(uint64_t v)
+{
+    if (v < (1U << STATS_SUB_BITS))
+        return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    int sub = (v >> (e - STATS_SUB_BITS)) & ((1U << STATS_SUB_BITS) - 1);
+    return ((e - STATS_SUB_BITS + 1) << STATS_SUB_BITS) + sub;
+}
+
+// 칸 번호 -> 칸의 하한 값
+static uint64_t bucket_low(int b)
+{
+    if (b < (1 << STATS_SUB_BITS))
+        return b;
+    int e = (b >> STATS_SUB_BITS) + STATS_SUB_BITS - 1;
+    uint64_t sub = b & ((1U << STATS_SUB_BITS) - 1);
+    return ((1ULL << STATS_SUB_BITS) + sub) << (e - STATS_SUB_BITS);
+}
+
+// 현재 스레드의 히스토그램에 기록 (원자적 읽기/쓰기만 사용, lock 접두 명령 없음)
+void stats_record(int phase, long long ns)
+{
+    StatsHist *h = hist_get();
+    if (!h || ns < 0)
+        return;
+
+    uint64_t *c = &h->count[phase][bucket_of(ns)];
+    __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    if ((uint64_t)ns > __atomic_load_n(&h->max[phase], __ATOMIC_RELAXED))
+        __atomic_store_n(&h->max[phase], (uint64_t)ns, __ATOMIC_RELAXED);
+}
+
+// 모든 스레드의 히스토그램을 합쳐서 구간별 p50/p99/p999 를 buf에 작성, 전체 기록 수 반환
+static uint64_t stats_format(char *buf, size_t size)
+{
+    static uint64_t merged[STATS_BUCKETS];
+    static pthread_mutex_t format_lock = PTHREAD_MUTEX_INITIALIZER;
+    uint64_t total_all = 0;
+    size_t len = 0;
+
+    pthread_mutex_lock(&format_lock);
+    for (int p = 0; p < STATS_PHASES; p++)
+    {
+        uint64_t total = 0, max = 0;
+        memset(merged, 0, sizeof(merged));
+
+        pthread_mutex_lock(&hists_lock);
+        for (StatsHist *h = hists; h; h = h->next)
+        {
+            for (int b = 0; b < STATS_BUCKETS; b++)
+            {
+                uint64_t c = __atomic_load_n(&h->count[p][b], __ATOMIC_RELAXED);
+                merged[b] += c;
+                total += c;
+            }
+            uint64_t m = __atomic_load_n(&h->max[p], __ATOMIC_RELAXED);
+            if (m > max)
+                max = m;
+        }
+        pthread_mutex_unlock(&hists_lock);
+
+        if (total == 0)
+            continue;
+        total_all += total;
+
+        // 누적 개수가 각 백분위 순위를 처음 넘는 칸의 하한 값
+        const double q[3] = {0.50, 0.99, 0.999};
+        uint64_t v[3] = {0, 0, 0};
+        uint64_t seen = 0;
+        int k = 0;
+        for (int b = 0; b < STATS_BUCKETS && k < 3; b++)
+        {
+            seen += merged[b];
+            while (k < 3 && seen > (uint64_t)(q[k] * (total - 1)))
+                v[k++] = bucket_low(b);
+        }
+
+        if (len < size)
+            len += snprintf(buf + len, size - len,
+                            "%-8s n=%llu p50=%.1fus p99=%.1fus p999=%.1fus max=%.1fus\n",
+                            phase_names[p], (unsigned long long)total,
+                            v[0] / 1e3, v[1] / 1e3, v[2] / 1e3, max / 1e3);
+    }
+    pthread_mutex_unlock(&format_lock);
+
+    if (len == 0 && size > 0)
+        snprintf(buf, size, "no samples\n");
+    return total_all;
+}
+
+// 주기 출력 스레드 - 새 기록이 있을 때만 출력
+static void *dump_thread(void *arg)
+{
+    (void)arg;
+    char buf[1024];
+    uint64_t last = 0;
+
+    while (1)
+    {
+        sleep(STATS_DUMP_SEC);
+        uint64_t total = stats_format(buf, sizeof(buf));
+        if (total == last)
+            continue;
+        last = total;
+        printf("[STATS] DATA latency by phase\n%s", buf);
+        fflush(stdout);
+    }
+    return NULL;
+}
+
+// 통계 소켓 스레드 - 접속하면 현재 통계를 보내고 닫음 (예: nc 127.0.0.1 <port>)
+static void *socket_thread(void *arg)
+{
+    int sd = *(int *)arg;
+    free(arg);
+    char buf[1024];
+
+    while (1)
+    {
+        int c = accept(sd, NULL, NULL);
+        if (c < 0)
+            continue;
+        stats_format(buf, sizeof(buf));
+        write_all(c, buf, strlen(buf));
+        close(c);
+    }
+    return NULL;
+}
+
+// 주기 출력 / 통계 소켓 스레드 시작
+void stats_start(int port)
+{
+    pthread_t t;
+    pthread_create(&t, NULL, dump_thread, NULL);
+    pthread_detach(t);
+
+    if (port <= 0)
+        return;
+
+    // 로컬에서만 조회 가능하도록 루프백에 바인드
+    int sd = socket(PF_INET, SOCK_STREAM, 0);
+    int option = 1;
+    setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &option, sizeof(option));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    int *psd = malloc(sizeof(int));
+    if (!psd || bind(sd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sd, 4) < 0)
+    {
+        perror("stats socket");
+        free(psd);
+        close(sd);
+        return;
+    }
+    *psd = sd;
+
+    pthread_create(&t, NULL, socket_thread, psd);
+    pthread_detach(t);
+    printf("Stats socket: 127.0.0.1:%d\n", port);
+}
+
+#endif
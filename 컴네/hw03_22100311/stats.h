@@ -0,0 +1,47 @@
+#ifndef STATS_H
+#define STATS_H
+
+// DATA 처리 구간 (청크 하나 기준으로 구간별 시간을 합산해서 기록)
+#define STATS_RECV 0    // 소켓 수신 (read)
+#define STATS_WRITE 1   // 파일 쓰기 (pwrite)
+#define STATS_MMAP 2    // mmap 모드 수신 (소켓 -> 매핑 직접 수신, 페이지 폴트 포함)
+#define STATS_JOURNAL 3 // 저널 기록
+#define STATS_ACK 4     // ACK 전송
+#define STATS_CHUNK 5   // handle_DATA 전체
+#define STATS_PHASES 6
+
+// 주기적으로 통계를 출력하는 간격 (초, 새 기록이 있을 때만)
+#define STATS_DUMP_SEC 30
+
+// 로그-선형 히스토그램: 2의 거듭제곱 구간마다 16칸 (상대 오차 약 6%)
+#define STATS_SUB_BITS 4
+#define STATS_BUCKETS (64 << STATS_SUB_BITS)
+
+#ifdef UPLOAD_STATS
+
+#include <time.h>
+
+// 단조 시계 (ns)
+static inline long long stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// 현재 스레드의 히스토그램에 한 구간의 소요 시간(ns) 기록 (잠금 없음)
+void stats_record(int phase, long long ns);
+
+// 주기 출력 스레드 시작, port > 0 이면 127.0.0.1:port 에서 접속마다 통계를 텍스트로 응답
+void stats_start(int port);
+
+#else
+
+// 계측을 끄고 빌드하면 호출 자체가 상수/빈 식으로 바뀜 (최적화 없이 빌드해도 함수 호출 없음)
+#define stats_now() 0LL
+#define stats_record(phase, ns) ((void)(phase), (void)(ns))
+#define stats_start(port) ((void)(port))
+
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "tcptune.h"
+
+static long long rate = TUNE_DEFAULT_RATE;
+
+// 커널 버퍼 한도 (처음 조정할 때 /proc/sys 에서 한 번 읽음)
+//   *_auto: net.ipv4.tcp_[rw]mem 세 번째 값, 자동 조정이 키울 수 있는 최대 (읽지 못하면 0)
+//   *_max:  net.core.[rw]mem_max, SO_RCVBUF/SO_SNDBUF 설정값이 잘리는 한도 (읽지 못하면 TUNE_MAX_BUF)
+static long long rmem_auto, wmem_auto, rmem_max, wmem_max;
+static pthread_once_t limits_once = PTHREAD_ONCE_INIT;
+
+// sysctl 파일에서 field번째 값 읽기 (없으면 def)
+static long long read_sysctl(const char *path, int field, long long def)
+{
+    long long v[3];
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return def;
+    int n = fscanf(fp, "%lld %lld %lld", &v[0], &v[1], &v[2]);
+    fclose(fp);
+    return n > field ? v[field] : def;
+}
+
+static void read_limits(void)
+{
+    rmem_auto = read_sysctl("/proc/sys/net/ipv4/tcp_rmem", 2, 0);
+    wmem_auto = read_sysctl("/proc/sys/net/ipv4/tcp_wmem", 2, 0);
+    rmem_max = read_sysctl("/proc/sys/net/core/rmem_max", 0, TUNE_MAX_BUF);
+    wmem_max = read_sysctl("/proc/sys/net/core/wmem_max", 0, TUNE_MAX_BUF);
+}
+
+// 목표 대역폭 설정
+void tune_set_rate(long long bytes_per_sec)
+{
+    rate = bytes_per_sec > 0 ? bytes_per_sec : TUNE_DEFAULT_RATE;
+}
+
+// BDP(want)를 담을 버퍼 정하기 (커널은 버퍼의 절반 정도를 데이터에 쓰므로 want의 2배가 필요)
+// 설정하면 그 소켓은 자동 조정이 꺼지고 설정값은 set_max로 잘리므로,
+// 자동 조정 최대(auto_max)로 모자라고 set_max가 그보다 클 때만 설정 (나머지는 자동 조정에 맡김)
+// 실제 버퍼 크기 반환, *fixed: 직접 설정했는지, *cap: 두 한도 모두 BDP보다 작으면 그 중 큰 값 (아니면 0)
+static int grow_buf(int sd, int opt, long long want, long long auto_max, long long set_max, int *fixed,
+                    long long *cap)
+{
+    int cur = 0;
+    socklen_t len = sizeof(cur);
+    getsockopt(sd, SOL_SOCKET, opt, &cur, &len);
+    if (want > TUNE_MAX_BUF)
+        want = TUNE_MAX_BUF;
+
+    *fixed = 0;
+    *cap = 0;
+    if (want * 2 <= cur || want * 2 <= auto_max)
+        return cur;
+
+    long long limit = set_max * 2 > auto_max ? set_max * 2 : auto_max;
+    if (want * 2 > limit)
+        *cap = limit;
+    if (set_max * 2 > auto_max && set_max * 2 > cur)
+    {
+        int v = (int)(want < set_max ? want : set_max);
+        setsockopt(sd, SOL_SOCKET, opt, &v, sizeof(v));
+        len = sizeof(cur);
+        getsockopt(sd, SOL_SOCKET, opt, &cur, &len);
+        *fixed = 1;
+    }
+    return cur;
+}
+
+// RTT 측정 -> BDP -> 버퍼, 명령/ACK 구간은 Nagle 끄기
+int tune_socket(int sd, const char *tag)
+{
+    struct tcp_info ti;
+    socklen_t len = sizeof(ti);
+    memset(&ti, 0, sizeof(ti));
+    if (getsockopt(sd, IPPROTO_TCP, TCP_INFO, &ti, &len) < 0)
+        return -1;
+
+    int one = 1;
+    setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    // 상대 주소 (로그용)
+    char peer[64] = "?";
+    struct sockaddr_in addr;
+    socklen_t alen = sizeof(addr);
+    if (getpeername(sd, (struct sockaddr *)&addr, &alen) == 0 && addr.sin_family == AF_INET)
+    {
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        snprintf(peer, sizeof(peer), "%s:%d", ip, ntohs(addr.sin_port));
+    }
+
+    // TCP Fast Open 으로 접속하면 첫 응답 전에는 RTT 표본이 없음
+    if (ti.tcpi_rtt == 0)
+    {
+        printf("[TUNE ] %s %s rtt=? nodelay (버퍼는 첫 응답 후 결정)\n", tag, peer);
+        return 0;
+    }
+
+    pthread_once(&limits_once, read_limits);
+    long long bdp = rate * ti.tcpi_rtt / 1000000;
+    int snd_fixed, rcv_fixed;
+    long long snd_cap, rcv_cap;
+    int snd = grow_buf(sd, SO_SNDBUF, bdp, wmem_auto, wmem_max, &snd_fixed, &snd_cap);
+    int rcv = grow_buf(sd, SO_RCVBUF, bdp, rmem_auto, rmem_max, &rcv_fixed, &rcv_cap);
+    printf("[TUNE ] %s %s rtt=%.3fms mss=%u bdp=%lld sndbuf=%d%s rcvbuf=%d%s nodelay\n",
+           tag, peer, ti.tcpi_rtt / 1000.0, ti.tcpi_snd_mss, bdp, snd, snd_fixed ? "" : "(auto)", rcv,
+           rcv_fixed ? "" : "(auto)");
+
+    // 커널 한도 때문에 창이 BDP보다 작으면 목표 대역폭을 낼 수 없음 (sysctl을 올려야 함)
+    if (snd_cap)
+        printf("[TUNE ] %s %s bdp=%lld > 송신 한도 %lld (net.ipv4.tcp_wmem=%lld, net.core.wmem_max=%lld)\n",
+               tag, peer, bdp, snd_cap / 2, wmem_auto, wmem_max);
+    if (rcv_cap)
+        printf("[TUNE ] %s %s bdp=%lld > 수신 한도 %lld (net.ipv4.tcp_rmem=%lld, net.core.rmem_max=%lld)\n",
+               tag, peer, bdp, rcv_cap / 2, rmem_auto, rmem_max);
+    return 1;
+}
+
+// 헤더와 본문을 꽉 찬 세그먼트로 묶음
+void tune_bulk_begin(int sd)
+{
+    int one = 1;
+    setsockopt(sd, IPPROTO_TCP, TCP_CORK, &one, sizeof(one));
+}
+
+// 묶기를 풀면서 남은 부분을 바로 전송 (NODELAY가 켜져 있으므로 기다리지 않음)
+void tune_bulk_end(int sd)
+{
+    int zero = 0;
+    setsockopt(sd, IPPROTO_TCP, TCP_CORK, &zero, sizeof(zero));
+}
+
+// 지연 ACK 끄기 (일시적)
+void tune_quickack(int sd)
+{
+    int one = 1;
+    setsockopt(sd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+}
@@ -0,0 +1,33 @@
+#ifndef TCPTUNE_H
+#define TCPTUNE_H
+
+// TCP 소켓 조정 (클라이언트, 서버, HTTP, 피어 복제 공용)
+// 접속 직후 TCP_INFO의 RTT로 대역폭 지연 곱(BDP = 목표 대역폭 x RTT)을 계산해서
+// 커널 자동 조정 최대(net.ipv4.tcp_[rw]mem)로 BDP를 담을 수 있으면 그대로 두고, 모자랄 때만
+// net.core.[rw]mem_max 가 그보다 크면 SO_SNDBUF/SO_RCVBUF를 설정 (설정하면 자동 조정이 꺼지고 [rw]mem_max로 잘림)
+// 두 한도 모두 BDP보다 작으면 로그로 알림
+// 이 프로토콜은 청크마다 ACK 한 줄을 기다리므로 명령/ACK 구간은 TCP_NODELAY로 바로 보내고
+// (Nagle + 지연 ACK가 겹치면 작은 청크마다 약 40ms 멈춤), 청크 본문 구간은 TCP_CORK로 헤더와 본문을
+// 꽉 찬 세그먼트로 묶은 뒤 풀면서 꼬리를 바로 내보냄, 받는 쪽은 TCP_QUICKACK으로 창을 빨리 엶
+
+// 목표 대역폭 기본값 (bytes/s, 1 Gbit/s)
+#define TUNE_DEFAULT_RATE (125LL * 1000 * 1000)
+
+// 버퍼 최대 크기 (RTT가 아주 큰 경로에서도 이 이상 잡지 않음)
+#define TUNE_MAX_BUF (64 * 1024 * 1024)
+
+// BDP 계산에 쓸 목표 대역폭 설정 (bytes/s, 0 이하면 기본값)
+void tune_set_rate(long long bytes_per_sec);
+
+// 접속한 TCP 소켓 조정 후 선택한 값을 로그로 출력 (tag: 로그 머리)
+// (RTT를 재서 버퍼를 정했으면 1, 아직 RTT가 없으면 0 - TCP Fast Open 등, TCP가 아니면 -1)
+int tune_socket(int sd, const char *tag);
+
+// 청크 본문 구간 시작 / 끝 (TCP_CORK 켜기 / 끄기 - 끌 때 남은 세그먼트를 바로 전송)
+void tune_bulk_begin(int sd);
+void tune_bulk_end(int sd);
+
+// 받는 쪽: 곧 들어올 데이터 구간의 ACK를 지연 없이 보냄 (커널이 다시 지연 모드로 돌아가므로 구간마다 호출)
+void tune_quickack(int sd);
+
+#endif
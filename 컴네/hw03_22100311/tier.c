@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "netio.h"
+#include "journal.h"
+#include "filetable.h"
+#include "gc.h"
+#include "lz.h"
+#include "tier.h"
+#include "catalog.h"
+
+#define TIER_MAGIC 0x52454954U // "TIER"
+
+// 저온 계층 파일 헤더 (뒤에 nblocks개의 블록 색인, 그 뒤에 블록 데이터)
+typedef struct
+{
+    uint32_t magic;
+    uint32_t block; // 블록 원본 크기 (마지막 블록만 짧음)
+    uint64_t size;  // 원본 크기
+    uint32_t nblocks;
+    uint32_t index_crc; // 블록 색인의 CRC32
+    uint32_t pad;
+    uint32_t hdr_crc; // 위 필드들의 CRC32
+} TierHeader;
+
+// 블록 색인 한 칸
+typedef struct
+{
+    uint64_t offset; // 파일 안에서 블록 데이터 위치
+    uint32_t zlen;   // 저장된 길이 (원본 길이와 같으면 압축하지 않고 저장)
+    uint32_t crc;    // 원본 블록의 CRC32
+} TierBlock;
+
+struct TierFile
+{
+    int fd;
+    TierHeader h;
+    TierBlock *idx;
+    long long cached; // raw에 풀어 둔 블록 번호 (-1: 없음)
+    uint8_t *raw;
+    uint8_t *z;
+};
+
+static char *cold_dir = NULL;
+static struct stat cold_st;
+static long long age_sec = TIER_DEFAULT_AGE;
+static long long min_bytes = TIER_DEFAULT_MIN;
+static long long rate = TIER_DEFAULT_RATE;
+
+// 단조 시계 (us)
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// 헤더 CRC 계산
+static uint32_t header_crc(const TierHeader *h)
+{
+    return crc32_update(0, h, offsetof(TierHeader, hdr_crc));
+}
+
+// 저온 계층 설정
+int tier_open(const char *spec)
+{
+    char *copy = strdup(spec);
+    char *save = NULL;
+    char *tok = copy ? strtok_r(copy, ",", &save) : NULL;
+    if (!tok)
+    {
+        free(copy);
+        return -1;
+    }
+    cold_dir = tok;
+
+    while ((tok = strtok_r(NULL, ",", &save)) != NULL)
+    {
+        if (sscanf(tok, "age=%lld", &age_sec) == 1 || sscanf(tok, "min=%lld", &min_bytes) == 1 ||
+            sscanf(tok, "rate=%lld", &rate) == 1)
+            continue;
+        cold_dir = NULL;
+    }
+    if (cold_dir)
+        mkdir(cold_dir, 0777);
+    if (!cold_dir || age_sec < 0 || min_bytes < 0 || rate <= 0 || stat(cold_dir, &cold_st) < 0 ||
+        !S_ISDIR(cold_st.st_mode))
+    {
+        cold_dir = NULL;
+        free(copy);
+        return -1;
+    }
+    printf("[TIER ] cold=%s age=%llds min=%lld bytes rate=%lld bytes/s\n", cold_dir, age_sec, min_bytes, rate);
+    return 0;
+}
+
+// 표시 파일 경로
+static void stub_path(char *out, size_t size, const char *id, const char *file)
+{
+    snprintf(out, size, "./%s/.%s.cold", id, file);
+}
+
+// 표시 파일 읽기 - 저온 계층 파일 경로와 원래 크기 (없으면 -1)
+// 설정이 바뀌어도 찾을 수 있도록 경로는 옮길 때 표시 파일에 기록해 둠
+static int read_stub(const char *id, const char *file, char *cold, size_t size, long long *len)
+{
+    char path[600];
+    stub_path(path, sizeof(path), id, file);
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    char line[700];
+    int ok = fscanf(fp, "size %lld\n", len) == 1 && fgets(line, sizeof(line), fp) && strncmp(line, "path ", 5) == 0;
+    fclose(fp);
+    if (!ok)
+        return -1;
+    line[strcspn(line, "\n")] = '\0';
+    snprintf(cold, size, "%s", line + 5);
+    return 0;
+}
+
+// 저온 계층에 있는 업로드의 원래 크기
+int tier_stat(const char *client_id, const char *filename, long long *len)
+{
+    char cold[700];
+    return read_stub(client_id, filename, cold, sizeof(cold), len);
+}
+
+// 저온 계층 파일 열기 (헤더와 색인 확인)
+static TierFile *open_cold(const char *path)
+{
+    TierFile *t = calloc(1, sizeof(TierFile));
+    if (!t)
+        return NULL;
+    t->cached = -1;
+    t->fd = open(path, O_RDONLY);
+
+    int ok = t->fd >= 0 && pread_all(t->fd, &t->h, sizeof(t->h), 0) == 0 && t->h.magic == TIER_MAGIC &&
+             t->h.hdr_crc == header_crc(&t->h) && t->h.block > 0 && t->h.block <= LZ_CHUNK_MAX;
+    if (ok)
+    {
+        size_t idx_len = (size_t)t->h.nblocks * sizeof(TierBlock);
+        t->idx = malloc(idx_len ? idx_len : 1);
+        t->raw = malloc(t->h.block);
+        t->z = malloc(t->h.block);
+        ok = t->idx && t->raw && t->z && pread_all(t->fd, t->idx, idx_len, sizeof(TierHeader)) == 0 &&
+             crc32_update(0, t->idx, idx_len) == t->h.index_crc;
+    }
+    if (!ok)
+    {
+        printf("[TIER ] %s: 잘못된 저온 계층 파일\n", path);
+        tier_fclose(t);
+        return NULL;
+    }
+    return t;
+}
+
+// 저온 계층 파일 열기
+TierFile *tier_fopen(const char *client_id, const char *filename)
+{
+    char cold[700];
+    long long len;
+    if (read_stub(client_id, filename, cold, sizeof(cold), &len) < 0)
+        return NULL;
+    return open_cold(cold);
+}
+
+// 원래 크기
+long long tier_size(const TierFile *t)
+{
+    return t->h.size;
+}
+
+// 블록 하나를 raw에 풀기 (CRC가 틀리면 -1)
+static int load_block(TierFile *t, long long b)
+{
+    if (t->cached == b)
+        return 0;
+    t->cached = -1;
+
+    TierBlock *e = &t->idx[b];
+    size_t n = b == t->h.nblocks - 1 ? (size_t)(t->h.size - b * (long long)t->h.block) : t->h.block;
+    if (e->zlen == n)
+    {
+        if (pread_all(t->fd, t->raw, n, e->offset) < 0)
+            return -1;
+    }
+    else if (e->zlen > n || pread_all(t->fd, t->z, e->zlen, e->offset) < 0 ||
+             lz_decompress(t->z, e->zlen, t->raw, n) != (long long)n)
+        return -1;
+    if (crc32_update(0, t->raw, n) != e->crc)
+        return -1;
+    t->cached = b;
+    return 0;
+}
+
+// 임의 위치 읽기 (걸치는 블록만 압축 해제)
+int tier_pread(TierFile *t, void *buf, size_t len, long long offset)
+{
+    if (offset < 0 || offset + (long long)len > (long long)t->h.size)
+        return -1;
+    while (len > 0)
+    {
+        long long b = offset / t->h.block;
+        size_t in = offset - b * t->h.block;
+        if (load_block(t, b) < 0)
+            return -1;
+        size_t n = t->h.block - in < len ? t->h.block - in : len;
+        memcpy(buf, t->raw + in, n);
+        buf = (char *)buf + n;
+        offset += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// 닫기
+void tier_fclose(TierFile *t)
+{
+    if (!t)
+        return;
+    if (t->fd >= 0)
+        close(t->fd);
+    free(t->idx);
+    free(t->raw);
+    free(t->z);
+    free(t);
+}
+
+// 처음부터 끝까지 풀어서 out에 기록
+static int unpack_to(TierFile *t, int out)
+{
+    for (long long b = 0; b < t->h.nblocks; b++)
+    {
+        size_t n = b == t->h.nblocks - 1 ? (size_t)(t->h.size - b * (long long)t->h.block) : t->h.block;
+        if (load_block(t, b) < 0 || pwrite_all(out, t->raw, n, b * (long long)t->h.block) < 0)
+            return -1;
+    }
+    return ftruncate(out, t->h.size);
+}
+
+// 이름 없는 임시 파일로 풀어서 반환
+int tier_lookup(const char *client_id, const char *filename, int *fd, long long *offset, long long *len)
+{
+    TierFile *t = tier_fopen(client_id, filename);
+    if (!t)
+        return -1;
+
+    int out = open(".", O_TMPFILE | O_RDWR, 0600);
+    if (out < 0)
+    {
+        char tmpl[] = "./.tier-restore-XXXXXX";
+        out = mkstemp(tmpl);
+        if (out >= 0)
+            unlink(tmpl);
+    }
+    if (out < 0 || unpack_to(t, out) < 0)
+    {
+        if (out >= 0)
+            close(out);
+        tier_fclose(t);
+        return -1;
+    }
+    *fd = out;
+    *offset = 0;
+    *len = t->h.size;
+    tier_fclose(t);
+    return 0;
+}
+
+// 원래 자리로 되돌림
+int tier_thaw(const char *client_id, const char *filename, const char *path)
+{
+    struct stat st;
+    char cold[700], tmp[600], stub[600];
+    long long len;
+    if (stat(path, &st) == 0 || read_stub(client_id, filename, cold, sizeof(cold), &len) < 0)
+        return 0;
+
+    long long t0 = now_us();
+    TierFile *t = open_cold(cold);
+    if (!t)
+        return -1;
+    snprintf(tmp, sizeof(tmp), "./%s/.%s.thaw.tmp", client_id, filename);
+    int out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok = out >= 0 && unpack_to(t, out) == 0 && fsync(out) == 0;
+    if (out >= 0)
+        close(out);
+    tier_fclose(t);
+    if (!ok || rename(tmp, path) < 0)
+    {
+        unlink(tmp);
+        printf("[TIER ] %s 되돌리기 실패\n", cold);
+        return -1;
+    }
+
+    stub_path(stub, sizeof(stub), client_id, filename);
+    unlink(stub);
+    unlink(cold);
+    catalog_set_state(client_id, filename, CATALOG_FILE);
+    printf("[TIER ] thawed %s <- %s (%lld bytes, %lld ms)\n", path, cold, len, (now_us() - t0) / 1000);
+    return 1;
+}
+
+// 표시 파일과 저온 계층 사본 삭제
+void tier_remove(const char *client_id, const char *filename)
+{
+    char cold[700], stub[600];
+    long long len;
+    if (read_stub(client_id, filename, cold, sizeof(cold), &len) < 0)
+        return;
+    unlink(cold);
+    stub_path(stub, sizeof(stub), client_id, filename);
+    unlink(stub);
+}
+
+// 속도 제한: 읽은 양이 초당 rate를 넘지 않게 쉬고, 업로드 수신 중이면 조용해질 때까지 멈춤
+static void throttle(long long *start, long long *bytes, size_t n)
+{
+    if (gc_uploads_active())
+    {
+        while (gc_uploads_active())
+            sleep(GC_QUIET_SEC);
+        *start = now_us();
+        *bytes = 0;
+    }
+    *bytes += n;
+    long long due = *start + *bytes * 1000000 / rate;
+    long long now = now_us();
+    if (due > now)
+        usleep(due - now);
+}
+
+// 표시 파일 기록 (임시 파일에 쓴 뒤 교체)
+static int write_stub(const char *id, const char *file, const char *cold, long long size)
+{
+    char path[600], tmp[620];
+    stub_path(path, sizeof(path), id, file);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    if (!fp)
+        return -1;
+    fprintf(fp, "size %lld\npath %s\n", size, cold);
+    if (fclose(fp) != 0 || rename(tmp, path) < 0)
+    {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// 완료된 업로드 하나를 저온 계층으로 옮김
+// 압축하는 동안은 잠그지 않고, 마지막에 다른 연결이 쓰지 않고 내용이 그대로일 때만 교체
+static void freeze(const char *id, const char *file, const char *path, const struct stat *st)
+{
+    char dir[400], cold[700], tmp[700];
+    snprintf(dir, sizeof(dir), "%s/%s", cold_dir, id);
+    mkdir(dir, 0777);
+    snprintf(cold, sizeof(cold), "%s/%s.lzt", dir, file);
+    snprintf(tmp, sizeof(tmp), "%s/.%s.lzt.tmp", dir, file);
+
+    long long size = st->st_size;
+    uint32_t nblocks = (size + TIER_BLOCK - 1) / TIER_BLOCK;
+    size_t idx_len = (size_t)nblocks * sizeof(TierBlock);
+    TierBlock *idx = calloc(nblocks ? nblocks : 1, sizeof(TierBlock));
+    uint8_t *raw = malloc(TIER_BLOCK);
+    uint8_t *z = malloc(TIER_BLOCK);
+    int in = open(path, O_RDONLY);
+    int out = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok = idx && raw && z && in >= 0 && out >= 0;
+
+    long long t0 = now_us(), start = t0, bytes = 0;
+    long long pos = sizeof(TierHeader) + idx_len;
+    for (uint32_t b = 0; ok && b < nblocks; b++)
+    {
+        size_t n = size - b * (long long)TIER_BLOCK < TIER_BLOCK ? (size_t)(size - b * (long long)TIER_BLOCK) : TIER_BLOCK;
+        throttle(&start, &bytes, n);
+        if (pread_all(in, raw, n, b * (long long)TIER_BLOCK) < 0)
+        {
+            ok = 0;
+            break;
+        }
+
+        // 줄어들지 않는 블록은 그대로 저장
+        size_t zlen = n > 1 ? lz_compress(raw, n, z, n - 1) : 0;
+        idx[b].offset = pos;
+        idx[b].zlen = zlen ? zlen : n;
+        idx[b].crc = crc32_update(0, raw, n);
+        ok = pwrite_all(out, zlen ? z : raw, idx[b].zlen, pos) == 0;
+        pos += idx[b].zlen;
+    }
+
+    if (ok)
+    {
+        TierHeader h;
+        memset(&h, 0, sizeof(h));
+        h.magic = TIER_MAGIC;
+        h.block = TIER_BLOCK;
+        h.size = size;
+        h.nblocks = nblocks;
+        h.index_crc = crc32_update(0, idx, idx_len);
+        h.hdr_crc = header_crc(&h);
+        ok = pwrite_all(out, idx, idx_len, sizeof(h)) == 0 && pwrite_all(out, &h, sizeof(h), 0) == 0 &&
+             fsync(out) == 0;
+    }
+    if (in >= 0)
+        close(in);
+    if (out >= 0)
+        close(out);
+    free(idx);
+    free(raw);
+    free(z);
+
+    // 교체: 쓰는 연결이 없는 동안 (잠금을 쥐고 있으면 새로 여는 연결은 open_upload에서 대기 후 되돌림)
+    int created = 0;
+    UploadFile *f = ok ? filetable_acquire(path, &created) : NULL;
+    struct stat now;
+    ok = f && created && stat(path, &now) == 0 && now.st_size == st->st_size && now.st_mtime == st->st_mtime &&
+         rename(tmp, cold) == 0 && write_stub(id, file, cold, size) == 0 && unlink(path) == 0;
+    if (f)
+    {
+        if (created)
+            pthread_mutex_unlock(&f->lock);
+        filetable_release(f);
+    }
+    if (!ok)
+    {
+        unlink(tmp);
+        return;
+    }
+    catalog_set_state(id, file, CATALOG_COLD);
+    printf("[TIER ] froze %s -> %s (%lld -> %lld bytes, %lld ms)\n", path, cold, size, pos, (now_us() - t0) / 1000);
+    fflush(stdout);
+}
+
+// ./<client_id>/ 의 완료된 업로드 중 정책에 맞는 파일을 옮김
+static void scan_dir(const char *id)
+{
+    char dir[300];
+    snprintf(dir, sizeof(dir), "./%s", id);
+    DIR *d = opendir(dir);
+    if (!d)
+        return;
+
+    struct dirent *e;
+    while ((e = readdir(d)) != NULL)
+    {
+        // 부분 업로드 관련 파일(.journal, .length 등)은 모두 '.'으로 시작
+        if (e->d_name[0] == '.')
+            continue;
+
+        char path[600], side[620];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        if (stat(path, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size < min_bytes ||
+            time(NULL) - st.st_mtime < age_sec)
+            continue;
+
+        // 같은 내용의 업로드끼리 하드 링크로 공유하는 파일은 옮겨도 공간이 줄지 않음
+        if (st.st_nlink > 1)
+            continue;
+
+        // 저널이나 tus 전체 크기 기록이 있으면 아직 진행 중
+        snprintf(side, sizeof(side), "%s/.%s.journal", dir, e->d_name);
+        if (access(side, F_OK) == 0)
+            continue;
+        snprintf(side, sizeof(side), "%s/.%s.length", dir, e->d_name);
+        if (access(side, F_OK) == 0)
+            continue;
+
+        freeze(id, e->d_name, path, &st);
+    }
+    closedir(d);
+}
+
+// 옮기는 스레드 - 시작 시 한 번, 이후 TIER_SCAN_SEC마다 훑음
+static void *tier_thread(void *arg)
+{
+    (void)arg;
+    gc_lower_priority();
+
+    while (1)
+    {
+        DIR *top = opendir(".");
+        struct dirent *e;
+        while (top && (e = readdir(top)) != NULL)
+        {
+            struct stat st;
+            if (e->d_name[0] == '.' || stat(e->d_name, &st) < 0 || !S_ISDIR(st.st_mode))
+                continue;
+
+            // 저온 디렉토리가 작업 디렉토리 안에 있으면 건너뜀
+            if (st.st_dev == cold_st.st_dev && st.st_ino == cold_st.st_ino)
+                continue;
+            scan_dir(e->d_name);
+        }
+        if (top)
+            closedir(top);
+        sleep(TIER_SCAN_SEC);
+    }
+    return NULL;
+}
+
+// 옮기는 스레드 시작
+void tier_start(void)
+{
+    if (!cold_dir)
+        return;
+
+    pthread_t t;
+    pthread_create(&t, NULL, tier_thread, NULL);
+    pthread_detach(t);
+}
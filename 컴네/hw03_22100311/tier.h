@@ -0,0 +1,49 @@
+#ifndef TIER_H
+#define TIER_H
+
+#include <stddef.h>
+
+// 저온 계층: 오래된 완료 업로드를 백그라운드에서 느린 디렉토리로 압축해서 옮김
+//   <cold_dir>/<client_id>/<filename>.lzt   헤더 + 블록 색인 + TIER_BLOCK 단위로 압축한 블록들
+//   ./<client_id>/.<filename>.cold          원래 자리에 남기는 표시 파일 (저온 경로, 크기)
+// 블록마다 따로 압축하므로 임의 위치를 읽을 때 그 블록만 풀면 됨 (GET 범위 요청)
+// FIRST/RESUME 으로 다시 열면 원래 자리로 풀어서 되돌림
+#define TIER_BLOCK (1024 * 1024)
+
+// 디렉토리를 다시 훑는 주기 (초)
+#define TIER_SCAN_SEC 60
+
+// 정책 기본값: 마지막 수정 후 1일, 64 KiB 이상, 초당 16 MiB 읽기
+#define TIER_DEFAULT_AGE 86400
+#define TIER_DEFAULT_MIN (64 * 1024)
+#define TIER_DEFAULT_RATE (16LL * 1024 * 1024)
+
+// 저온 계층에서 읽는 파일 (블록 하나를 풀어 둔 캐시 포함)
+typedef struct TierFile TierFile;
+
+// 저온 계층 설정 - spec: "dir[,age=초][,min=바이트][,rate=바이트/초]" (성공 0, 실패 -1)
+int tier_open(const char *spec);
+
+// 옮기는 스레드 시작 (설정하지 않았으면 아무것도 안 함)
+void tier_start(void);
+
+// 저온 계층에 있는 업로드의 원래 크기 (없으면 -1)
+int tier_stat(const char *client_id, const char *filename, long long *len);
+
+// 저온 계층 파일 열기 / 원래 크기 / 임의 위치 읽기 (필요한 블록만 압축 해제, 성공 0, 실패 -1) / 닫기
+TierFile *tier_fopen(const char *client_id, const char *filename);
+long long tier_size(const TierFile *t);
+int tier_pread(TierFile *t, void *buf, size_t len, long long offset);
+void tier_fclose(TierFile *t);
+
+// 이름 없는 임시 파일로 풀어서 반환 - pack_lookup 과 같은 형태 (없으면 -1)
+int tier_lookup(const char *client_id, const char *filename, int *fd, long long *offset, long long *len);
+
+// 원래 자리(path)가 비어 있고 표시 파일이 있으면 풀어서 되돌림
+// (되돌렸으면 1, 저온 계층에 없으면 0, 실패 -1) - 호출자가 filetable 잠금을 쥔 상태에서 호출
+int tier_thaw(const char *client_id, const char *filename, const char *path);
+
+// 표시 파일과 저온 계층 사본 삭제 (같은 이름으로 새 업로드가 완료되거나 다시 시작할 때)
+void tier_remove(const char *client_id, const char *filename);
+
+#endif
@@ -0,0 +1,154 @@
+#include <time.h>
+#include <pthread.h>
+
+#include "timerwheel.h"
+
+#define TW_BITS 6
+
+static TimerEntry *wheel[TW_LEVELS][TW_SLOTS];
+static long long now_tick = 0;
+static pthread_mutex_t wheel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// 만료까지 남은 tick에 맞는 레벨/칸에 연결
+// 레벨 L은 남은 시간이 64^L 이상 64^(L+1) 미만인 타이머를 만료 tick의 L번째 자리로 분류
+static void link_entry(TimerEntry *t)
+{
+    long long delta = t->expire - now_tick;
+    int level = 0;
+    while (level < TW_LEVELS - 1 && delta >= (1LL << (TW_BITS * (level + 1))))
+        level++;
+
+    int slot = (t->expire >> (TW_BITS * level)) & (TW_SLOTS - 1);
+    TimerEntry **head = &wheel[level][slot];
+
+    t->prev = NULL;
+    t->next = *head;
+    if (*head)
+        (*head)->prev = t;
+    *head = t;
+    t->armed = 1;
+}
+
+// 연결된 칸에서 제거
+static void unlink_entry(TimerEntry *t)
+{
+    if (t->prev)
+    {
+        t->prev->next = t->next;
+    }
+    else
+    {
+        // 첫 번째 원소면 어느 칸의 머리인지 찾아서 갱신
+        for (int l = 0; l < TW_LEVELS; l++)
+        {
+            int slot = (t->expire >> (TW_BITS * l)) & (TW_SLOTS - 1);
+            if (wheel[l][slot] == t)
+            {
+                wheel[l][slot] = t->next;
+                break;
+            }
+        }
+    }
+    if (t->next)
+        t->next->prev = t->prev;
+    t->prev = t->next = NULL;
+    t->armed = 0;
+}
+
+// 상위 레벨 칸의 타이머를 남은 시간에 맞춰 하위 레벨로 내림
+static void cascade(int level)
+{
+    int slot = (now_tick >> (TW_BITS * level)) & (TW_SLOTS - 1);
+    TimerEntry *t = wheel[level][slot];
+    wheel[level][slot] = NULL;
+
+    while (t)
+    {
+        TimerEntry *next = t->next;
+        link_entry(t);
+        t = next;
+    }
+}
+
+// 한 tick 진행 후 만료된 타이머 실행
+static void tick(void)
+{
+    now_tick++;
+
+    // 하위 레벨이 한 바퀴 돌 때마다 위 레벨의 다음 칸을 내림 (높은 레벨부터)
+    for (int l = TW_LEVELS - 1; l > 0; l--)
+    {
+        if ((now_tick & ((1LL << (TW_BITS * l)) - 1)) == 0)
+            cascade(l);
+    }
+
+    int slot = now_tick & (TW_SLOTS - 1);
+    while (wheel[0][slot])
+    {
+        TimerEntry *t = wheel[0][slot];
+        unlink_entry(t);
+        t->cb(t->arg);
+    }
+}
+
+// tick 스레드 - 단조 시계 기준 1초마다 진행 (늦어진 tick은 몰아서 처리)
+static void *timer_thread(void *arg)
+{
+    (void)arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (1)
+    {
+        next.tv_sec++;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+        pthread_mutex_lock(&wheel_lock);
+        tick();
+        pthread_mutex_unlock(&wheel_lock);
+    }
+    return NULL;
+}
+
+// tick 스레드 시작
+void timer_start(void)
+{
+    pthread_t t;
+    pthread_create(&t, NULL, timer_thread, NULL);
+    pthread_detach(t);
+}
+
+// 타이머 초기화
+void timer_init(TimerEntry *t, void (*cb)(void *), void *arg)
+{
+    t->expire = 0;
+    t->cb = cb;
+    t->arg = arg;
+    t->armed = 0;
+    t->prev = t->next = NULL;
+}
+
+// seconds 뒤에 만료되도록 설정
+void timer_arm(TimerEntry *t, int seconds)
+{
+    if (seconds < 1)
+        seconds = 1;
+    if (seconds > TW_MAX_SEC)
+        seconds = TW_MAX_SEC;
+
+    pthread_mutex_lock(&wheel_lock);
+    if (t->armed)
+        unlink_entry(t);
+    t->expire = now_tick + seconds;
+    link_entry(t);
+    pthread_mutex_unlock(&wheel_lock);
+}
+
+// 타이머 해제
+void timer_cancel(TimerEntry *t)
+{
+    pthread_mutex_lock(&wheel_lock);
+    if (t->armed)
+        unlink_entry(t);
+    pthread_mutex_unlock(&wheel_lock);
+}
@@ -0,0 +1,33 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+// 계층형 타이머 휠: 1초 tick, 레벨당 64칸 x 3단계 (최대 약 3일)
+#define TW_SLOTS 64
+#define TW_LEVELS 3
+#define TW_MAX_SEC (TW_SLOTS * TW_SLOTS * TW_SLOTS - 1)
+
+// 타이머 하나 (연결 세션 등에 내장해서 사용, 별도 할당 없음)
+typedef struct TimerEntry
+{
+    long long expire; // 만료 tick
+    void (*cb)(void *arg);
+    void *arg;
+    int armed;
+    struct TimerEntry *prev;
+    struct TimerEntry *next;
+} TimerEntry;
+
+// tick 스레드 시작
+void timer_start(void);
+
+// 타이머 초기화 (만료 시 타이머 스레드에서 cb(arg) 호출)
+// cb는 휠 잠금을 잡은 채 호출되므로 짧아야 하고 timer_* 함수를 부르면 안 됨
+void timer_init(TimerEntry *t, void (*cb)(void *), void *arg);
+
+// seconds 뒤에 만료되도록 설정 (이미 설정된 타이머는 다시 설정, O(1))
+void timer_arm(TimerEntry *t, int seconds);
+
+// 타이머 해제 (반환 후에는 cb가 실행 중이거나 실행되지 않음을 보장)
+void timer_cancel(TimerEntry *t);
+
+#endif
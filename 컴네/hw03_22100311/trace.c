@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "trace.h"
+
+static FILE *trace_fp = NULL;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread unsigned long data_seq = 0;
+
+// Chrome/Perfetto JSON 배열 형식 트레이스 파일 열기
+// (배열 끝의 ']' 는 생략 가능한 형식이라 비정상 종료해도 그때까지의 이벤트를 볼 수 있음)
+int trace_open(const char *path, const char *process_name)
+{
+    trace_fp = fopen(path, "w");
+    if (!trace_fp)
+        return -1;
+
+    fprintf(trace_fp, "[\n");
+    fprintf(trace_fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+            (int)getpid(), trace_str(process_name));
+    fflush(trace_fp);
+    return 0;
+}
+
+// 트레이스가 켜져 있는지
+int trace_enabled(void)
+{
+    return trace_fp != NULL;
+}
+
+// 현재 시각 (us) - 프로세스 사이에서 비교할 수 있도록 벽시계 사용
+long long trace_now(void)
+{
+    if (!trace_fp)
+        return 0;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// DATA 샘플링
+int trace_sample(void)
+{
+    if (!trace_fp)
+        return 0;
+    return data_seq++ % TRACE_DATA_SAMPLE == 0;
+}
+
+// 이벤트 한 줄 기록 (ph: "X" 구간, "i" 순간)
+static void trace_event(const char *name, const char *ph, long long ts, long long dur,
+                        const char *args_fmt, va_list ap)
+{
+    int tid = (int)syscall(SYS_gettid);
+
+    pthread_mutex_lock(&trace_lock);
+    fprintf(trace_fp, "{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%lld,", name, ph, ts);
+    if (dur >= 0)
+        fprintf(trace_fp, "\"dur\":%lld,", dur);
+    else
+        fprintf(trace_fp, "\"s\":\"t\",");
+    fprintf(trace_fp, "\"pid\":%d,\"tid\":%d,\"args\":{", (int)getpid(), tid);
+    if (args_fmt)
+        vfprintf(trace_fp, args_fmt, ap);
+    fprintf(trace_fp, "}},\n");
+    fflush(trace_fp);
+    pthread_mutex_unlock(&trace_lock);
+}
+
+// 구간 이벤트 기록
+void trace_complete(const char *name, long long start_us, const char *args_fmt, ...)
+{
+    if (!trace_fp)
+        return;
+
+    long long now = trace_now();
+    va_list ap;
+    va_start(ap, args_fmt);
+    trace_event(name, "X", start_us, now - start_us, args_fmt, ap);
+    va_end(ap);
+}
+
+// 순간 이벤트 기록
+void trace_instant(const char *name, const char *args_fmt, ...)
+{
+    if (!trace_fp)
+        return;
+
+    va_list ap;
+    va_start(ap, args_fmt);
+    trace_event(name, "i", trace_now(), -1, args_fmt, ap);
+    va_end(ap);
+}
+
+// JSON 문자열 이스케이프 (따옴표, 역슬래시, 제어 문자)
+const char *trace_str(const char *s)
+{
+    static __thread char bufs[2][600];
+    static __thread int which = 0;
+    char *out = bufs[which];
+    which ^= 1;
+
+    size_t n = 0;
+    for (; *s && n < sizeof(bufs[0]) - 7; s++)
+    {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\')
+        {
+            out[n++] = '\\';
+            out[n++] = c;
+        }
+        else if (c < 0x20)
+        {
+            n += sprintf(out + n, "\\u%04x", c);
+        }
+        else
+        {
+            out[n++] = c;
+        }
+    }
+    out[n] = '\0';
+    return out;
+}
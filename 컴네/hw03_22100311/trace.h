@@ -0,0 +1,33 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// DATA 이벤트는 스레드마다 이 개수 중 하나만 기록 (나머지 명령은 모두 기록)
+#define TRACE_DATA_SAMPLE 16
+
+// Chrome/Perfetto JSON 배열 형식 트레이스 파일 열기 (성공 0, 실패 -1)
+// process_name은 타임라인에 표시할 프로세스 이름 ("server", "client c1" 등)
+// 클라이언트와 서버 파일은 같은 시계(CLOCK_REALTIME)를 쓰므로 합쳐서 열면 나란히 보임:
+//   (cat server.json; tail -n +2 client.json) > all.json
+int trace_open(const char *path, const char *process_name);
+
+// 트레이스가 켜져 있는지
+int trace_enabled(void);
+
+// 현재 시각 (us, 트레이스가 꺼져 있으면 0)
+long long trace_now(void);
+
+// DATA 샘플링: 현재 스레드에서 TRACE_DATA_SAMPLE번에 한 번 1 반환
+int trace_sample(void);
+
+// start_us부터 지금까지의 구간 이벤트 기록 (args_fmt: JSON 객체 안쪽 "key":value,... 또는 NULL)
+void trace_complete(const char *name, long long start_us, const char *args_fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// 순간 이벤트 기록
+void trace_instant(const char *name, const char *args_fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+// 문자열을 JSON 문자열 안에 넣을 수 있게 이스케이프 (스레드별 버퍼, 한 호출에 최대 2개까지 사용)
+const char *trace_str(const char *s);
+
+#endif
@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "netio.h"
+#include "lz.h"
+#include "zpool.h"
+
+// 슬롯 상태
+#define SLOT_EMPTY 0
+#define SLOT_BUSY 1
+#define SLOT_FULL 2
+#define SLOT_ERROR 3
+
+// 압축 스레드 수 상한
+#define ZPOOL_MAX_THREADS 16
+
+typedef struct
+{
+    ZChunk c;
+    int state;
+} ZSlot;
+
+struct ZPool
+{
+    int fd;
+    size_t chunk;
+    long long end;
+
+    // 슬롯 링: 순번 seq의 청크는 slots[seq % depth]
+    ZSlot *slots;
+    int depth;
+
+    // 작업 스레드가 다음에 가져갈 청크 순번과 위치
+    long long next_seq;
+    long long next_off;
+
+    // 전송 쪽이 다음에 받을 청크 순번과 위치
+    long long head_seq;
+    long long head_off;
+
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t threads[ZPOOL_MAX_THREADS];
+    int nthreads;
+};
+
+// 작업 스레드 - 링에 빈 자리가 있는 동안 다음 청크를 가져가서 읽고 압축
+static void *zworker(void *arg)
+{
+    ZPool *zp = arg;
+
+    pthread_mutex_lock(&zp->lock);
+    while (1)
+    {
+        while (!zp->stop && zp->next_off < zp->end && zp->next_seq - zp->head_seq >= zp->depth)
+            pthread_cond_wait(&zp->cond, &zp->lock);
+        if (zp->stop || zp->next_off >= zp->end)
+            break;
+
+        ZSlot *s = &zp->slots[zp->next_seq++ % zp->depth];
+        s->c.offset = zp->next_off;
+        s->c.len = zp->end - zp->next_off < (long long)zp->chunk ? (size_t)(zp->end - zp->next_off) : zp->chunk;
+        s->c.zlen = 0;
+        s->state = SLOT_BUSY;
+        zp->next_off += s->c.len;
+
+        // 읽기와 압축은 잠금 없이 (다른 스레드는 다음 청크를 동시에 처리)
+        pthread_mutex_unlock(&zp->lock);
+        int r = pread_all(zp->fd, s->c.raw, s->c.len, s->c.offset);
+        if (r == 0 && s->c.len > 1)
+            s->c.zlen = lz_compress(s->c.raw, s->c.len, s->c.z, s->c.len - 1);
+        pthread_mutex_lock(&zp->lock);
+
+        s->state = r < 0 ? SLOT_ERROR : SLOT_FULL;
+        pthread_cond_broadcast(&zp->cond);
+    }
+    pthread_mutex_unlock(&zp->lock);
+    return NULL;
+}
+
+// 슬롯 버퍼 해제
+static void free_slots(ZPool *zp)
+{
+    for (int i = 0; zp->slots && i < zp->depth; i++)
+    {
+        free(zp->slots[i].c.raw);
+        free(zp->slots[i].c.z);
+    }
+    free(zp->slots);
+}
+
+// 압축 시작 (청크 수가 스레드 수의 두 배만큼 앞서 나감)
+ZPool *zpool_start(int fd, long long offset, long long end, size_t chunk, int threads)
+{
+    if (threads < 1)
+        threads = 1;
+    if (threads > ZPOOL_MAX_THREADS)
+        threads = ZPOOL_MAX_THREADS;
+
+    ZPool *zp = calloc(1, sizeof(ZPool));
+    if (!zp)
+        return NULL;
+    zp->fd = fd;
+    zp->chunk = chunk;
+    zp->end = end;
+    zp->next_off = zp->head_off = offset;
+    zp->depth = threads * 2;
+    zp->slots = calloc(zp->depth, sizeof(ZSlot));
+    int ok = zp->slots != NULL;
+    for (int i = 0; ok && i < zp->depth; i++)
+        ok = (zp->slots[i].c.raw = malloc(chunk)) != NULL && (zp->slots[i].c.z = malloc(chunk)) != NULL;
+    if (!ok)
+    {
+        free_slots(zp);
+        free(zp);
+        return NULL;
+    }
+
+    pthread_mutex_init(&zp->lock, NULL);
+    pthread_cond_init(&zp->cond, NULL);
+    for (int i = 0; i < threads; i++)
+        if (pthread_create(&zp->threads[zp->nthreads], NULL, zworker, zp) == 0)
+            zp->nthreads++;
+    if (zp->nthreads == 0)
+    {
+        zpool_stop(zp);
+        return NULL;
+    }
+    return zp;
+}
+
+// 다음 순서의 청크
+const ZChunk *zpool_get(ZPool *zp)
+{
+    pthread_mutex_lock(&zp->lock);
+    if (zp->head_off >= zp->end)
+    {
+        pthread_mutex_unlock(&zp->lock);
+        return NULL;
+    }
+    ZSlot *s = &zp->slots[zp->head_seq % zp->depth];
+    while (s->state != SLOT_FULL && s->state != SLOT_ERROR)
+        pthread_cond_wait(&zp->cond, &zp->lock);
+    pthread_mutex_unlock(&zp->lock);
+    return s->state == SLOT_FULL ? &s->c : NULL;
+}
+
+// 보낸 청크의 슬롯 반환
+void zpool_advance(ZPool *zp)
+{
+    pthread_mutex_lock(&zp->lock);
+    ZSlot *s = &zp->slots[zp->head_seq % zp->depth];
+    s->state = SLOT_EMPTY;
+    zp->head_off += s->c.len;
+    zp->head_seq++;
+    pthread_cond_broadcast(&zp->cond);
+    pthread_mutex_unlock(&zp->lock);
+}
+
+// 다음 청크 위치
+long long zpool_pos(const ZPool *zp)
+{
+    return zp->head_off;
+}
+
+// 작업 스레드 종료 후 해제
+void zpool_stop(ZPool *zp)
+{
+    if (!zp)
+        return;
+
+    pthread_mutex_lock(&zp->lock);
+    zp->stop = 1;
+    pthread_cond_broadcast(&zp->cond);
+    pthread_mutex_unlock(&zp->lock);
+    for (int i = 0; i < zp->nthreads; i++)
+        pthread_join(zp->threads[i], NULL);
+
+    free_slots(zp);
+    pthread_mutex_destroy(&zp->lock);
+    pthread_cond_destroy(&zp->cond);
+    free(zp);
+}
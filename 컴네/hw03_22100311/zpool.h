@@ -0,0 +1,35 @@
+#ifndef ZPOOL_H
+#define ZPOOL_H
+
+#include <stddef.h>
+
+// 클라이언트 압축 작업 풀: 여러 스레드가 전송할 청크를 순서대로 나눠 가져가 미리 읽고 압축,
+// 전송 쪽은 압축이 끝난 청크를 파일 순서대로 받아서 보냄
+typedef struct ZPool ZPool;
+
+// 압축된 청크 하나
+typedef struct
+{
+    long long offset;
+    size_t len;  // 원본 길이
+    size_t zlen; // 압축 길이 (0이면 줄지 않아서 원본 그대로 전송)
+    char *raw;
+    char *z;
+} ZChunk;
+
+// [offset, end) 를 chunk 크기로 나눠 threads개 스레드로 압축 시작 (실패 시 NULL)
+ZPool *zpool_start(int fd, long long offset, long long end, size_t chunk, int threads);
+
+// 다음 순서의 청크 (압축이 끝날 때까지 대기), 끝이거나 읽기 오류면 NULL
+const ZChunk *zpool_get(ZPool *zp);
+
+// zpool_get 으로 받은 청크를 다 보냈음 (버퍼를 작업 스레드에 돌려줌)
+void zpool_advance(ZPool *zp);
+
+// 다음에 zpool_get 이 돌려줄 청크의 파일 위치
+long long zpool_pos(const ZPool *zp);
+
+// 작업 스레드 종료 후 해제 (NULL 이면 무시)
+void zpool_stop(ZPool *zp);
+
+#endif
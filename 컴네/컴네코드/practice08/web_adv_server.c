@@ -5,6 +5,7 @@
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <pthread.h>
+#include "tcptune.h"	// hw03 socket tuning (see Makefile)
 
 #define BUF_SIZE 1024
 #define SMALL_BUF 100
@@ -53,6 +54,7 @@ int main(int argc, char *argv[])
 		clnt_sock = accept(serv_sock, (struct sockaddr*)&clnt_adr, &clnt_adr_size);
 		printf("Connection Request : %s:%d\n", 
 			inet_ntoa(clnt_adr.sin_addr), ntohs(clnt_adr.sin_port));
+		tune_socket(clnt_sock, "web");
 		pthread_create(&t_id, NULL, (void*)request_handler, &clnt_sock);
 		pthread_detach(t_id);
 	}
@@ -123,7 +125,8 @@ void send_data(FILE* fp, char* ct, char* file_name)
 
 	printf("file_name: %s(%dbytes)\n", file_name, file_size);
 
-	// Send HTTP header
+	// Send HTTP header (corked: header and body leave in full segments)
+	tune_bulk_begin(fileno(fp));
 	fputs(protocol, fp);
 	fputs(server, fp);
 	fputs(cnt_len, fp);
@@ -133,6 +136,7 @@ void send_data(FILE* fp, char* ct, char* file_name)
 	// Hint: use fread() and fwrite() 
 
 	fflush(fp);
+	tune_bulk_end(fileno(fp));
 	fclose(fp);
 }
 